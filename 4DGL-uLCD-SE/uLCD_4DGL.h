@@ -30,6 +30,31 @@
 // Common WAIT value in milliseconds between commands
 #define TEMPO 0
 
+// Command queue: commands are sent from the UART interrupt while the screen
+// works on earlier ones, as many as fit in its serial receive buffer
+#define LCD_RX_BUFFER   16      // bytes the screen buffers, commands in flight must fit
+#define LCD_TX_QUEUE    256     // default bytes of queued commands, see the constructor
+#define LCD_MAX_PENDING 32      // commands queued or in flight, a power of 2
+#define LCD_RX_QUEUE    8       // bytes of replies to data commands, a power of 2
+#define LCD_MAX_ERRORS  4       // failed commands kept for get_error(), a power of 2
+#define LCD_ACK_TIMEOUT 2000    // ms without an answer before queued commands are dropped
+
+// Commands longer than the screen buffer go out a buffer full at a time, with
+// a pause (on a Timeout, the caller does not wait) after each for whatever
+// part of it the screen has not taken in yet
+#ifndef LCD_BYTE_US
+#define LCD_BYTE_US     100     // us the screen needs per byte of a long command
+#endif
+
+// Text grid kept by text_print(), one cell per character of the 7x8 font
+#define LCD_GRID_COLS   18
+#define LCD_GRID_ROWS   16
+#define LCD_GRID_GAP    6       // unchanged cells resent to join two runs, cheaper than a new run
+
+#define LCD_RLE_MAX_W   256     // widest RLE565 image, its line buffer is 2 bytes a pixel
+#define LCD_RLE_MIN_RUN 8       // shortest run of a colour drawn as a rectangle
+#define LCD_RLE_RECTS   8       // rectangles grown down at once
+
 // 4DGL SGE Function values for Goldelox Processor
 #define CLS          '\xD7'
 #define BAUDRATE     '\x0B' //null prefix
@@ -60,6 +85,7 @@
 #define TEXTCHAR     '\xFE'
 #define TEXTSTRING   '\x06'  //null prefix
 #define MOVECURSOR   '\xE4'
+#define TEXTCOLOR    '\x7F'
 #define BLITCOM      '\x0A'
 #define PUTCHAR      '\xFE'
 #define DISPPOWER    '\x66'
@@ -73,6 +99,7 @@
 #define WRITEWORD    '\xB4'
 #define FLUSHMEDIA   '\xB2'
 #define DISPLAYIMAGE '\xB3'
+#define WRITESECTOR  '\x17'  //null prefix
 #define DISPLAYVIDEO '\xBB'
 #define DISPLAYFRAME '\xBA'
 
@@ -179,6 +206,49 @@
 #define PROTECT      '\x00'
 #define UNPROTECT    '\x02'
 
+// RGB888 like 0xRRGGBB to the screen's 16 bits color, a constant for a constant
+#define LCD_RGB565(c) ((((c) >> 8) & 0xF800) | (((c) >> 5) & 0x07E0) | (((c) >> 3) & 0x001F))
+
+//**************************************************************************
+// Bytes of one command, built on the stack and queued by writeCOMMAND():
+// writeCOMMAND(LCDPacket<7>(PIXEL).word(x).word(y).color(color));
+template <int N> class LCDPacket
+{
+
+public :
+
+    LCDPacket(char command) : _length(0) {
+        byte(command);
+    }
+    LCDPacket &byte(int value) {             // one byte
+        _data[_length++] = value & 0xFF;
+        return *this;
+    }
+    LCDPacket &word(int value) {             // 16 bits, high byte first
+        _data[_length++] = (value >> 8) & 0xFF;
+        _data[_length++] = value & 0xFF;
+        return *this;
+    }
+    LCDPacket &color(int rgb) {              // 0xRRGGBB as 16 bits color
+        return word(LCD_RGB565(rgb));
+    }
+    LCDPacket &bytes(const char *data, int number) {
+        while (number--) _data[_length++] = *data++;
+        return *this;
+    }
+    const char *data() const {
+        return _data;
+    }
+    int length() const {
+        return _length;
+    }
+
+private :
+
+    char _data[N];
+    int _length;
+};
+
 //**************************************************************************
 // \class uLCD_4DGL uLCD_4DGL.h
 // \brief This is the main class. It shoud be used like this : uLCD_4GDL myLCD(p9,p10,p11);
@@ -202,7 +272,58 @@ class uLCD_4DGL : public Stream
 
 public :
 
-    uLCD_4DGL(PinName tx, PinName rx, PinName rst);
+    /** Create the display on a serial port and a reset pin
+    * @param tx Serial TX pin, to the RX of the display
+    * @param rx Serial RX pin, to the TX of the display
+    * @param rst Reset pin of the display
+    * @param init_now Reset and clear the screen right away, which takes about 3s.
+    *        Pass false to call init() later, e.g. from a thread while other
+    *        devices start up
+    * @param queue_size Bytes of commands that can be queued before a call
+    *        has to wait for the UART, rounded up to a power of 2
+    */
+    uLCD_4DGL(PinName tx, PinName rx, PinName rst, bool init_now = true, int queue_size = LCD_TX_QUEUE);
+
+    /** Reset the screen, clear it and set the default text state */
+    void init();
+
+    /** A command the screen answered with NAK, or not at all */
+    struct Error {
+        uint32_t seq;       // number of the command, see commands()
+        char command;       // its command byte
+        char answer;        // NAK or other byte received, 0 on timeout
+    };
+
+    /** Drawing commands do not wait for the screen, they are queued and sent
+    * from the UART interrupt, and the answers are checked as they come in.
+    * A call only waits when the queue is full. Commands that read data back
+    * wait until the queue is empty and then run on their own.
+    *
+    * @returns the number of commands sent since start-up; the next command
+    * gets commands() + 1
+    */
+    uint32_t commands() {
+        return _seq;
+    }
+
+    /** Number of commands that failed since start-up */
+    uint32_t errors() {
+        return _errors;
+    }
+
+    /** Take the oldest failed command not reported yet
+    * @param e Set to the failed command
+    * @returns true if there was one
+    */
+    bool get_error(Error &e);
+
+    /** Wait until every queued byte has been sent */
+    void flush();
+
+    /** Wait until the screen has answered every queued command
+    * @returns 1 if all commands since the last wait_idle() succeeded, -1 if not
+    */
+    int wait_idle();
 
 // General Commands *******************************************************************************
 
@@ -215,8 +336,22 @@ public :
 
     /** Set serial Baud rate (both sides : screen and mbed)
     * @param Speed Correct BAUD value (see uLCD_4DGL.h)
+    * @returns 1 if the screen answered ACK at the new rate, -1 on NAK, 0 if no answer
+    */
+    int baudrate(int speed);
+
+    /** Raise the baud rate step by step up to max, checking each rate with
+    * a version request. On the first rate that fails it goes back to the
+    * last good one and stops.
+    * @param max Highest rate to try, e.g. 3000000
+    * @returns the rate in use, 0 if the screen does not answer at all
     */
-    void baudrate(int speed);
+    int negotiate_baud(int max);
+
+    /** Baud rate in use, as passed to baudrate() */
+    int baud() {
+        return _rate;
+    }
 
     /** Set background colour to the specified value
     * @param color in HEX RGB like 0xFF00FF
@@ -259,6 +394,49 @@ public :
     void pen_size(char);
     void BLIT(int x, int y, int w, int h, int *colors);
 
+    /** Draw a block of pixels already in the screen's RGB565 format, sent as they are
+    * @param pixels w*h colours, row by row
+    */
+    void BLIT565(int x, int y, int w, int h, const uint16_t *pixels);
+
+    /** Draw a block of RGB565 pixels pulled from a reader, 64 bytes at a time
+    *
+    * The reader returns big-endian pixel bytes (high byte first, the order of
+    * the wire and of the files made by tools/rgb565.py). If it runs short the
+    * block is padded with black so the screen still gets the whole command.
+    * @param read Called as read(ctx, data, length), returns the bytes it put in data
+    * @returns 0, or -1 if the reader ran short
+    */
+    int  BLIT565(int x, int y, int w, int h, int (*read)(void *ctx, char *data, int length), void *ctx);
+
+    /** Draw a block of RGB565 pixels read from the current position of a file
+    * @returns 0, or -1 if the file ran short
+    */
+    int  BLIT565(int x, int y, int w, int h, FILE *fp);
+
+    /** Draw an RLE565 image made by tools/rgb565.py --rle, pulled from a reader
+    *
+    * The file is an 8-byte header, "RLE5" and the width and height as
+    * big-endian 16-bit numbers, then the rows as packets that never span two
+    * rows. A packet is a count byte c and RGB565 colours high byte first:
+    * c < 0x80 is c+1 different colours, c >= 0x80 is one colour repeated
+    * c-0x7F times.
+    *
+    * Rows are decoded into a line buffer. Runs of LCD_RLE_MIN_RUN pixels or
+    * more are drawn with filled_rectangle, one rectangle for as many rows as
+    * repeat the run, and the pixels around them with BLIT565. That cuts the
+    * bytes read and sent for flat artwork, but every rectangle and row is a
+    * command of its own: at 1M baud and up a plain BLIT565 can be quicker.
+    * @returns the bytes sent to the screen, or -1 for a bad header or a
+    * source that ran short (the rows before it are drawn)
+    */
+    int  BLITRLE(int x, int y, int (*read)(void *ctx, char *data, int length), void *ctx);
+
+    /** Draw an RLE565 image read from the current position of a file
+    * @returns the bytes sent to the screen, or -1
+    */
+    int  BLITRLE(int x, int y, FILE *fp);
+
 // Text Commands
     void set_font(char);
     void set_font_size(char width, char height);  
@@ -270,21 +448,54 @@ public :
     void text_width(char);
     void text_height(char);
     void text_char(char, char, char, int);
+
+    /** Draw a string at a text position in a font and color
+    *
+    * The string goes from the caller's memory straight to the command queue,
+    * as pieces that fit the screen buffer, so a string of any length costs
+    * no stack and no pacing pauses.
+    */
     void text_string(char *, char, char, char, int);
     void locate(char, char);
     void color(int);
     void putc(char);
     void puts(char *);
 
+    /** Write a string into the text grid, wrapping at the end of a row.
+    * Nothing is sent until text_flush(), which sends only the cells that
+    * changed since the last flush. The grid starts out as a cleared screen
+    * and cls() clears it again. Assumes the 7x8 font and opaque text.
+    * @param col Column of the first character
+    * @param row Row of the first character
+    * @param s String to write
+    * @param color Text color in HEX RGB like 0xFF00FF
+    */
+    void text_print(int col, int row, const char *s, int color);
+
+    /** Send the changed cells of the text grid as a few text_string runs.
+    * This moves the screen's text cursor.
+    * @returns the number of bytes sent
+    */
+    int text_flush();
+
+    /** Send the whole grid on the next text_flush(), e.g. after drawing over it */
+    void text_redraw();
+
 //Media Commands
     int media_init();
     void set_byte_address(int, int);
     void set_sector_address(int, int);
     char read_byte();
     int  read_word();
-    void write_byte(int);
-    void write_word(int);
-    void flush_media();
+    int  write_byte(int);
+    int  write_word(int);
+    int  flush_media();
+
+    /** Write a sector of the screen's card at the address of set_sector_address()
+    * @param data 512 bytes
+    * @returns the status from the screen, non-zero if it was written
+    */
+    int  write_sector(const char *data);
     void display_image(int, int);
     void display_video(int, int);
     void display_frame(int, int, int);
@@ -311,7 +522,7 @@ public :
 
 protected :
 
-    Serial     _cmd;
+    RawSerial  _cmd;
     DigitalOut _rst;
     //used by printf
     virtual int _putc(int c) {
@@ -323,10 +534,75 @@ protected :
     }
 
     void freeBUFFER  (void);
-    void writeBYTE   (char);
     void writeBYTEfast   (char);
-    int  writeCOMMAND(char *, int);
-    int  writeCOMMANDnull(char *, int);
+    int  writeCOMMAND(const char *, int);
+    int  writeCOMMANDnull(const char *, int);
+    int  queueCOMMAND(char, const char *, int);
+    template <int N> int writeCOMMAND(const LCDPacket<N> &p) {
+        return queueCOMMAND('\xFF', p.data(), p.length());
+    }
+    template <int N> int writeCOMMANDnull(const LCDPacket<N> &p) {
+        return queueCOMMAND('\x00', p.data(), p.length());
+    }
+    int  queueTEXT   (const char *, int);
+    void startCOMMAND(char, int, int);
+    void startBLIT   (int, int, int, int);
+    void queueBYTES  (const char *, int);
+    int  writeQUERY  (const char *, int, char *, int);
+    int  queryWORD   (const char *, int);
+    template <int N> int queryWORD(const LCDPacket<N> &p) {
+        return queryWORD(p.data(), p.length());
+    }
+    int  readANSWER  (char *, int);
+    void waitQUEUE   (int, int);
+    void dropQUEUE   (void);
+    void addERROR    (uint32_t, char, char);
+    void txPUMP      (void);
+    void txRESUME    (void);
+    void rxIRQ       (void);
+
+    // Bytes of queued commands, sent by txPUMP() from the TX interrupt
+    char             *_tx;
+    uint16_t          _tx_mask;             // queue size - 1
+    volatile uint16_t _tx_in, _tx_out;      // free running, masked on use
+    volatile uint16_t _tx_left;             // bytes of the command on the wire not sent yet
+    volatile uint16_t _tx_paced;            // of those, bytes to send a buffer full at a time
+    volatile uint16_t _tx_chunk;            // paced bytes sent since the last pause
+    volatile bool     _tx_paused;           // waiting for _resume
+    Timeout           _resume;
+
+    // Queued commands in order: [_p_acked, _p_sent) are waiting for their
+    // answer, [_p_sent, _p_in) are not on the wire yet
+    struct Pending {
+        uint32_t seq;
+        char command;
+        uint16_t length;
+        uint16_t paced;                     // leading bytes that need pacing, 0 for short commands
+    };
+    Pending _pending[LCD_MAX_PENDING];
+    volatile uint8_t _p_in, _p_sent, _p_acked;
+    volatile int     _in_flight;            // bytes sent and not answered yet
+
+    // Bytes received while no command waits for an answer
+    volatile char    _rx[LCD_RX_QUEUE];
+    volatile uint8_t _rx_in, _rx_out;
+
+    // Text grid for text_print(), allocated on first use
+    struct TextGrid {
+        char     text[LCD_GRID_ROWS][LCD_GRID_COLS];
+        uint16_t color[LCD_GRID_ROWS][LCD_GRID_COLS];   // RGB565
+        uint32_t dirty[LCD_GRID_ROWS];                   // a bit per column to send
+    };
+    TextGrid *_grid;
+
+    int _rate;                              // baud rate as passed to baudrate()
+    int _baud;                              // rate set on the mbed side, can differ a little
+
+    Error _err[LCD_MAX_ERRORS];
+    volatile uint8_t _err_in, _err_out;
+    volatile uint32_t _errors;
+    uint32_t _idle_errors;                  // _errors at the last wait_idle()
+    uint32_t _seq;
     int  readVERSION (char *, int);
     int  getSTATUS   (char *, int);
     int  version     (void);
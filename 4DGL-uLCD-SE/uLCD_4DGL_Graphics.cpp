@@ -25,174 +25,36 @@
 //****************************************************************************************************
 void uLCD_4DGL :: circle(int x, int y , int radius, int color)     // draw a circle in (x,y)
 {
-    char command[9]= "";
-
-    command[0] = CIRCLE;
-
-    command[1] = (x >> 8) & 0xFF;
-    command[2] = x & 0xFF;
-
-    command[3] = (y >> 8) & 0xFF;
-    command[4] = y & 0xFF;
-
-    command[5] = (radius >> 8) & 0xFF;
-    command[6] = radius & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[7] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[8] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 9);
+    writeCOMMAND(LCDPacket<9>(CIRCLE).word(x).word(y).word(radius).color(color));
 }
 //****************************************************************************************************
 void uLCD_4DGL :: filled_circle(int x, int y , int radius, int color)     // draw a circle in (x,y)
 {
-    char command[9]= "";
-
-    command[0] = FCIRCLE;
-
-    command[1] = (x >> 8) & 0xFF;
-    command[2] = x & 0xFF;
-
-    command[3] = (y >> 8) & 0xFF;
-    command[4] = y & 0xFF;
-
-    command[5] = (radius >> 8) & 0xFF;
-    command[6] = radius & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[7] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[8] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 9);
+    writeCOMMAND(LCDPacket<9>(FCIRCLE).word(x).word(y).word(radius).color(color));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: triangle(int x1, int y1 , int x2, int y2, int x3, int y3, int color)     // draw a traingle
 {
-    char command[15]= "";
-
-    command[0] = TRIANGLE;
-
-    command[1] = (x1 >> 8) & 0xFF;
-    command[2] = x1 & 0xFF;
-
-    command[3] = (y1 >> 8) & 0xFF;
-    command[4] = y1 & 0xFF;
-
-    command[5] = (x2 >> 8) & 0xFF;
-    command[6] = x2 & 0xFF;
-
-    command[7] = (y2 >> 8) & 0xFF;
-    command[8] = y2 & 0xFF;
-
-    command[9] = (x3 >> 8) & 0xFF;
-    command[10] = x3 & 0xFF;
-
-    command[11] = (y3 >> 8) & 0xFF;
-    command[12] = y3 & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;               // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;               // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;               // get blue on 5 bits
-
-    command[13] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[14] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 15);
+    writeCOMMAND(LCDPacket<15>(TRIANGLE).word(x1).word(y1).word(x2).word(y2).word(x3).word(y3).color(color));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: line(int x1, int y1 , int x2, int y2, int color)     // draw a line
 {
-    char command[11]= "";
-
-    command[0] = LINE;
-
-    command[1] = (x1 >> 8) & 0xFF;
-    command[2] = x1 & 0xFF;
-
-    command[3] = (y1 >> 8) & 0xFF;
-    command[4] = y1 & 0xFF;
-
-    command[5] = (x2 >> 8) & 0xFF;
-    command[6] = x2 & 0xFF;
-
-    command[7] = (y2 >> 8) & 0xFF;
-    command[8] = y2 & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;               // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;               // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;               // get blue on 5 bits
-
-    command[9] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;   // first part of 16 bits color
-    command[10] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 11);
+    writeCOMMAND(LCDPacket<11>(LINE).word(x1).word(y1).word(x2).word(y2).color(color));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: rectangle(int x1, int y1 , int x2, int y2, int color)     // draw a rectangle
 {
-    char command[11]= "";
-
-    command[0] = RECTANGLE;
-
-    command[1] = (x1 >> 8) & 0xFF;
-    command[2] = x1 & 0xFF;
-
-    command[3] = (y1 >> 8) & 0xFF;
-    command[4] = y1 & 0xFF;
-
-    command[5] = (x2 >> 8) & 0xFF;
-    command[6] = x2 & 0xFF;
-
-    command[7] = (y2 >> 8) & 0xFF;
-    command[8] = y2 & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;               // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;               // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;               // get blue on 5 bits
-
-    command[9] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;   // first part of 16 bits color
-    command[10] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 11);
+    writeCOMMAND(LCDPacket<11>(RECTANGLE).word(x1).word(y1).word(x2).word(y2).color(color));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: filled_rectangle(int x1, int y1 , int x2, int y2, int color)     // draw a rectangle
 {
-    char command[11]= "";
-
-    command[0] = FRECTANGLE;
-
-    command[1] = (x1 >> 8) & 0xFF;
-    command[2] = x1 & 0xFF;
-
-    command[3] = (y1 >> 8) & 0xFF;
-    command[4] = y1 & 0xFF;
-
-    command[5] = (x2 >> 8) & 0xFF;
-    command[6] = x2 & 0xFF;
-
-    command[7] = (y2 >> 8) & 0xFF;
-    command[8] = y2 & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;               // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;               // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;               // get blue on 5 bits
-
-    command[9] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;   // first part of 16 bits color
-    command[10] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 11);
+    writeCOMMAND(LCDPacket<11>(FRECTANGLE).word(x1).word(y1).word(x2).word(y2).color(color));
 }
 
 
@@ -200,110 +62,210 @@ void uLCD_4DGL :: filled_rectangle(int x1, int y1 , int x2, int y2, int color)
 //****************************************************************************************************
 void uLCD_4DGL :: pixel(int x, int y, int color)     // draw a pixel
 {
-    char command[7]= "";
-
-    command[0] = PIXEL;
-
-    command[1] = (x >> 8) & 0xFF;
-    command[2] = x & 0xFF;
-
-    command[3] = (y >> 8) & 0xFF;
-    command[4] = y & 0xFF;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[5] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[6] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 7);
+    writeCOMMAND(LCDPacket<7>(PIXEL).word(x).word(y).color(color));
 }
 //****************************************************************************************************
 void uLCD_4DGL :: BLIT(int x, int y, int w, int h, int *colors)     // draw a block of pixels
 {
-    int red5, green6, blue5;
-    writeBYTEfast('\x00');
-    writeBYTEfast(BLITCOM);
-    writeBYTEfast((x >> 8) & 0xFF);
-    writeBYTEfast(x & 0xFF);
-    writeBYTEfast((y >> 8) & 0xFF);
-    writeBYTEfast(y & 0xFF);
-    writeBYTEfast((w >> 8) & 0xFF);
-    writeBYTE(w & 0xFF);
-    writeBYTE((h >> 8) & 0xFF);
-    writeBYTE(h & 0xFF);
-    wait_ms(1);
-    for (int i=0; i<w*h; i++) {
-        red5   = (colors[i] >> (16 + 3)) & 0x1F;              // get red on 5 bits
-        green6 = (colors[i] >> (8 + 2))  & 0x3F;              // get green on 6 bits
-        blue5  = (colors[i] >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-        writeBYTEfast(((red5 << 3)   + (green6 >> 3)) & 0xFF);  // first part of 16 bits color
-        writeBYTEfast(((green6 << 5) + (blue5 >> 0)) & 0xFF);  // second part of 16 bits color
+    int i, n = 0;
+    char data[32];
+
+    startBLIT(x, y, w, h);
+    for (i=0; i<w*h; i++) {
+        int color = LCD_RGB565(colors[i]);
+        data[n++] = color >> 8;                              // first part of 16 bits color
+        data[n++] = color & 0xFF;                            // second part of 16 bits color
+        if (n == sizeof(data)) {
+            queueBYTES(data, n);
+            n = 0;
+        }
     }
-    int resp=0;
-    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
-    if (_cmd.readable()) resp = _cmd.getc();           // read response if any
-    switch (resp) {
-        case ACK :                                     // if OK return   1
-            resp =  1;
-            break;
-        case NAK :                                     // if NOK return -1
-            resp = -1;
-            break;
-        default :
-            resp =  0;                                 // else return   0
-            break;
+    queueBYTES(data, n);
+}
+//******************************************************************************************************
+void uLCD_4DGL :: BLIT565(int x, int y, int w, int h, const uint16_t *pixels)     // draw a block of RGB565 pixels
+{
+    int i, n = 0;
+    char data[32];
+
+    startBLIT(x, y, w, h);
+    for (i=0; i<w*h; i++) {
+        data[n++] = (pixels[i] >> 8) & 0xFF;                 // high byte goes first
+        data[n++] = pixels[i] & 0xFF;
+        if (n == sizeof(data)) {
+            queueBYTES(data, n);
+            n = 0;
+        }
     }
-#if DEBUGMODE
-    pc.printf("   Answer received : %d\n",resp);
-#endif
-
+    queueBYTES(data, n);
 }
+
 //******************************************************************************************************
-int uLCD_4DGL :: read_pixel(int x, int y)   // read screen info and populate data
+int uLCD_4DGL :: BLIT565(int x, int y, int w, int h, int (*read)(void *, char *, int), void *ctx)   // draw a block of RGB565 pixels from a reader
 {
+    int n, got, left = 2 * w * h, err = 0;
+    char data[64];
+
+    startBLIT(x, y, w, h);
+    while (left > 0) {
+        n = left < (int)sizeof(data) ? left : sizeof(data);
+        got = err ? 0 : read(ctx, data, n);
+        if (got < n) {                                       // short source: pad it out, the screen expects every byte
+            if (got < 0) got = 0;
+            memset(data + got, 0, n - got);
+            err = -1;
+        }
+        queueBYTES(data, n);
+        left -= n;
+    }
+    return err;
+}
 
-    char command[6]= "";
-    command[0] = 0xFF;
-    command[1] = READPIXEL;
+//******************************************************************************************************
+static int readFILE(void *ctx, char *data, int length)   // reader for BLIT565 from a stdio file
+{
+    return fread(data, 1, length, (FILE *)ctx);
+}
 
-    command[2] = (x >> 8) & 0xFF;
-    command[3] = x & 0xFF;
+int uLCD_4DGL :: BLIT565(int x, int y, int w, int h, FILE *fp)   // draw a block of RGB565 pixels from a file
+{
+    return BLIT565(x, y, w, h, readFILE, fp);
+}
 
-    command[4] = (y >> 8) & 0xFF;
-    command[5] = y & 0xFF;
+//******************************************************************************************************
+struct RLEInput {                           // bytes of an RLE565 image, read 64 at a time
+    int (*read)(void *, char *, int);
+    void *ctx;
+    char buf[64];
+    int pos, len;
+
+    int get() {
+        if (pos == len) {
+            pos = 0;
+            len = read(ctx, buf, sizeof(buf));
+            if (len <= 0) {
+                len = 0;
+                return -1;
+            }
+        }
+        return (unsigned char)buf[pos++];
+    }
+};
 
-    int i, temp = 0, color = 0, resp = 0;
-    char response[2] = "";
+struct RLERect {                            // run of one colour, grown down while the next rows repeat it
+    int x1, x2, y1, y2;
+    uint16_t color;
+};
 
-    freeBUFFER();
+static int fillRLE(uLCD_4DGL &lcd, int x, int y, const RLERect &r)   // draw a run, return the bytes sent
+{
+    int c = r.color;
+    lcd.filled_rectangle(x + r.x1, y + r.y1, x + r.x2, y + r.y2,
+                         ((c >> 11) << 19) | (((c >> 5) & 0x3F) << 10) | ((c & 0x1F) << 3));
+    return 12;
+}
 
-    for (i = 0; i < 6; i++) {                   // send all chars to serial port
-        writeBYTE(command[i]);
+int uLCD_4DGL :: BLITRLE(int x, int y, int (*read)(void *, char *, int), void *ctx)   // draw an RLE565 image from a reader, return the bytes sent
+{
+    RLEInput in = { read, ctx, {0}, 0, 0 };
+    RLERect rect[LCD_RLE_RECTS];
+    int rects = 0, sent = 0, err = 0;
+    int w, h, row, n, i, j, k, c, hi, lo = 0, lit;
+    int head[8];
+
+    for (i = 0; i < 8; i++) head[i] = in.get();
+    w = (head[4] << 8) | head[5];
+    h = (head[6] << 8) | head[7];
+    if (head[0] != 'R' || head[1] != 'L' || head[2] != 'E' || head[3] != '5'
+        || head[7] < 0 || w < 1 || w > LCD_RLE_MAX_W) return -1;
+
+    uint16_t *line = new uint16_t[w];
+    for (row = 0; row < h && !err; row++) {
+        for (n = 0; n < w; n += k) {                        // decode the row, packets never span two
+            c = in.get();
+            k = (c & 0x7F) + 1;
+            if (c < 0 || n + k > w) break;
+            for (i = 0; i < k; i++) {
+                if (i && (c & 0x80)) line[n + i] = line[n]; // a run has one colour
+                else {
+                    hi = in.get();
+                    lo = in.get();
+                    line[n + i] = (hi << 8) | lo;
+                }
+            }
+            if (lo < 0) break;                              // ran out, a source only ever stops
+        }
+        if (n < w) {
+            err = -1;
+            break;
+        }
+
+        for (lit = i = 0; i < w; i = j) {                   // long runs become rectangles, the rest is blitted
+            for (j = i + 1; j < w && line[j] == line[i]; j++) ;
+            if (j - i < LCD_RLE_MIN_RUN) continue;
+            if (i > lit) {
+                BLIT565(x + lit, y + row, i - lit, 1, line + lit);
+                sent += 10 + 2 * (i - lit);
+            }
+            lit = j;
+            for (k = 0; k < rects; k++) {
+                if (rect[k].x1 == i && rect[k].x2 == j - 1 && rect[k].color == line[i] && rect[k].y2 == row - 1) break;
+            }
+            if (k == rects) {
+                if (rects == LCD_RLE_RECTS) {               // out of slots: the oldest is drawn as it is
+                    sent += fillRLE(*this, x, y, rect[0]);
+                    memmove(rect, rect + 1, --rects * sizeof(RLERect));
+                }
+                k = rects++;
+                rect[k].x1 = i;
+                rect[k].x2 = j - 1;
+                rect[k].y1 = row;
+                rect[k].color = line[i];
+            }
+            rect[k].y2 = row;
+        }
+        if (w > lit) {
+            BLIT565(x + lit, y + row, w - lit, 1, line + lit);
+            sent += 10 + 2 * (w - lit);
+        }
+
+        for (i = k = 0; i < rects; i++) {                   // runs that did not go on in this row are done
+            if (rect[i].y2 == row) rect[k++] = rect[i];
+            else sent += fillRLE(*this, x, y, rect[i]);
+        }
+        rects = k;
     }
+    for (i = 0; i < rects; i++) sent += fillRLE(*this, x, y, rect[i]);
+    delete[] line;
+    return err ? err : sent;
+}
 
-    while (!_cmd.readable()) wait_ms(TEMPO);    // wait for screen answer
-
-    while (_cmd.readable() && resp < ARRAY_SIZE(response)) {
-        temp = _cmd.getc();
-        response[resp++] = (char)temp;
-    }
+int uLCD_4DGL :: BLITRLE(int x, int y, FILE *fp)   // draw an RLE565 image from a file
+{
+    return BLITRLE(x, y, readFILE, fp);
+}
 
-    color = ((response[0] << 8) + response[1]);
+//******************************************************************************************************
+void uLCD_4DGL :: startBLIT(int x, int y, int w, int h)   // queue the BLIT command and its header, the pixels follow
+{
+    LCDPacket<10> p('\x00');
 
-    return color; // WARNING : this is 16bits color, not 24bits... need to be fixed
+    p.byte(BLITCOM).word(x).word(y).word(w).word(h);
+    startCOMMAND(BLITCOM, 10 + 2 * w * h, 10);        // pace the header, then the pixels stream
+    queueBYTES(p.data(), p.length());
+}
+//******************************************************************************************************
+int uLCD_4DGL :: read_pixel(int x, int y)   // read screen info and populate data
+{
+    LCDPacket<6> p('\xFF');
+    return queryWORD(p.byte(READPIXEL).word(x).word(y));   // WARNING : this is 16bits color, not 24bits... need to be fixed
 }
 
 
 //****************************************************************************************************
 void uLCD_4DGL :: pen_size(char mode)     // set pen to SOLID or WIREFRAME
 {
-    char command[2]= "";
-
-    command[0] = PENSIZE;
-    command[1] = mode;
-    writeCOMMAND(command, 2);
+    writeCOMMAND(LCDPacket<2>(PENSIZE).byte(mode));
 }
 
 
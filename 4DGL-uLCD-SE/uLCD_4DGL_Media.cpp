@@ -26,152 +26,91 @@
 //******************************************************************************************************
 int uLCD_4DGL :: media_init()
 {
-    int resp = 0;
-    char command[1] = "";
-    command[0] = MINIT;
-    writeCOMMAND(command, 1);
-    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
-    if (_cmd.readable()) {
-        resp = _cmd.getc();           // read response
-        resp = resp << 8 + _cmd.getc();
-    }
-    return resp;
+    LCDPacket<2> p('\xFF');
+    return queryWORD(p.byte(MINIT));
 }
 
 //******************************************************************************************************
 void uLCD_4DGL :: set_byte_address(int hi, int lo)
 {
-    char command[5]= "";
-    command[0] = SBADDRESS;
-
-    command[1] = (hi >> 8) & 0xFF;
-    command[2] = hi & 0xFF;
-
-    command[3] = (lo >> 8) & 0xFF;
-    command[4] = lo & 0xFF;
-    writeCOMMAND(command, 5);
+    writeCOMMAND(LCDPacket<5>(SBADDRESS).word(hi).word(lo));
 }
 
 //******************************************************************************************************
 void uLCD_4DGL :: set_sector_address(int hi, int lo)
 {
-
-    char command[5]= "";
-    command[0] = SSADDRESS;
-
-    command[1] = (hi >> 8) & 0xFF;
-    command[2] = hi & 0xFF;
-
-    command[3] = (lo >> 8) & 0xFF;
-    command[4] = lo & 0xFF;
-    writeCOMMAND(command, 5);
+    writeCOMMAND(LCDPacket<5>(SSADDRESS).word(hi).word(lo));
 }
 
 //******************************************************************************************************
 char uLCD_4DGL :: read_byte()
 {
-    char resp = 0;
-    char command[1] = "";
-    command[0] = READBYTE;
-    writeCOMMAND(command, 1);
-    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
-    if (_cmd.readable()) {
-        resp = _cmd.getc();           // read response
-        resp = _cmd.getc();
-    }
-    return resp;
+    LCDPacket<2> p('\xFF');
+    return queryWORD(p.byte(READBYTE)) & 0xFF;           // the byte is in the low half of the word
 }
 
 //******************************************************************************************************
 int  uLCD_4DGL :: read_word()
 {
-    int resp=0;
-    char command[1] = "";
-    command[0] = READWORD;
-    writeCOMMAND(command, 1);
-    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
-    if (_cmd.readable()) {
-        resp = _cmd.getc();           // read response
-        resp = resp << 8 + _cmd.getc();
-    }
-    return resp;
+    LCDPacket<2> p('\xFF');
+    return queryWORD(p.byte(READWORD));
 }
 
 //******************************************************************************************************
-void uLCD_4DGL :: write_byte(int value)
+int uLCD_4DGL :: write_byte(int value)   // write a byte at the byte address, return the status
 {
-    char command[3]= "";
-
-    command[0] = WRITEBYTE;
-
-    command[1] = (value >> 8) & 0xFF;
-    command[2] = value & 0xFF;
-    writeCOMMAND(command,3);
+    LCDPacket<4> p('\xFF');
+    return queryWORD(p.byte(WRITEBYTE).word(value));
 }
 
 //******************************************************************************************************
-void uLCD_4DGL :: write_word(int value)
+int uLCD_4DGL :: write_word(int value)   // write a word at the byte address, return the status
 {
-    char command[3]= "";
-
-    command[0] = WRITEWORD;
+    LCDPacket<4> p('\xFF');
+    return queryWORD(p.byte(WRITEWORD).word(value));
+}
 
-    command[1] = (value >> 8) & 0xFF;
-    command[2] = value & 0xFF;
-    writeCOMMAND(command,3);
+//******************************************************************************************************
+int uLCD_4DGL :: flush_media()   // write out the sector written to byte by byte, return the status
+{
+    LCDPacket<2> p('\xFF');
+    return queryWORD(p.byte(FLUSHMEDIA));
 }
 
 //******************************************************************************************************
-void uLCD_4DGL :: flush_media()
+int uLCD_4DGL :: write_sector(const char *data)   // write 512 bytes at the sector address, return the status
 {
-    char command[1] = "";
-    command[0] = FLUSHMEDIA;
-    writeCOMMAND(command, 1);
+    char command[2] = "";
+    char response[2] = "";
+    uint32_t errors = _errors;
+
+    command[0] = '\x00';
+    command[1] = WRITESECTOR;
+    waitQUEUE(0, 0);                            // the status has to be the first byte after the ACK
+    freeBUFFER();
+    startCOMMAND(WRITESECTOR, 514, 514);         // queued rather than written, so the data is paced
+    queueBYTES(command, 2);
+    queueBYTES(data, 512);
+    waitQUEUE(0, 0);
+    if (_errors != errors || readANSWER(response, 2) != 2) return 0;
+    return ((unsigned char)response[0] << 8) + (unsigned char)response[1];
 }
 
 //******************************************************************************************************
 void uLCD_4DGL :: display_image(int x, int y)
 {
-    char command[6]= "";
-    command[0] = DISPLAYIMAGE;
-
-    command[1] = (x >> 8) & 0xFF;
-    command[2] = x & 0xFF;
-
-    command[3] = (y >> 8) & 0xFF;
-    command[4] = y & 0xFF;
-    writeCOMMAND(command, 5);
+    writeCOMMAND(LCDPacket<5>(DISPLAYIMAGE).word(x).word(y));
 }
 
 //******************************************************************************************************
 void uLCD_4DGL :: display_video(int x, int y)
 {
-    char command[5]= "";
-    command[0] = DISPLAYVIDEO;
-
-    command[1] = (x >> 8) & 0xFF;
-    command[2] = x & 0xFF;
-
-    command[3] = (y >> 8) & 0xFF;
-    command[4] = y & 0xFF;
-    writeCOMMAND(command, 5);
+    writeCOMMAND(LCDPacket<5>(DISPLAYVIDEO).word(x).word(y));
 }
 
 //******************************************************************************************************
 void uLCD_4DGL :: display_frame(int x, int y, int w)
 {
-    char command[7]= "";
-
-    command[0] = DISPLAYFRAME;
-
-    command[1] = (x >> 8) & 0xFF;
-    command[2] = x & 0xFF;
-
-    command[3] = (y >> 8) & 0xFF;
-    command[4] = y & 0xFF;
-
-    command[5] = (w >> 8) & 0xFF;
-    command[6] = w & 0xFF;
-    writeCOMMAND(command,7);
+    writeCOMMAND(LCDPacket<7>(DISPLAYFRAME).word(x).word(y).word(w));
 }
 
@@ -37,12 +37,6 @@ void uLCD_4DGL :: set_font_size(char width, char height)     // set font size
 //****************************************************************************************************
 void uLCD_4DGL :: set_font(char mode)     // set font - system or SD media
 {
-    char command[3]= "";
-
-    command[0] = SETFONT;
-    command[1] = 0;
-    command[2] = mode;
-
     current_font = mode;
 
     if (current_orientation == IS_PORTRAIT) {
@@ -83,7 +77,7 @@ void uLCD_4DGL :: set_font(char mode)     // set font - system or SD media
     max_col = current_w / (current_fx*current_wf);
     max_row = current_h / (current_fy*current_hf);
 
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(SETFONT).byte(0).byte(mode));
 }
 
 
@@ -91,149 +85,66 @@ void uLCD_4DGL :: set_font(char mode)     // set font - system or SD media
 //****************************************************************************************************
 void uLCD_4DGL :: text_mode(char mode)     // set text mode
 {
-    char command[3]= "";
-
-    command[0] = TEXTMODE;
-    command[1] = 0;
-    command[2] = mode;
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTMODE).byte(0).byte(mode));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_bold(char mode)     // set text mode
 {
-    char command[3]= "";
-
-    command[0] = TEXTBOLD;
-    command[1] = 0;
-    command[2] = mode;
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTBOLD).byte(0).byte(mode));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_italic(char mode)     // set text mode
 {
-    char command[3]= "";
-
-    command[0] = TEXTITALIC;
-    command[1] = 0;
-    command[2] = mode;
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTITALIC).byte(0).byte(mode));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_inverse(char mode)     // set text mode
 {
-    char command[3]= "";
-
-    command[0] = TEXTINVERSE;
-    command[1] = 0;
-    command[2] = mode;
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTINVERSE).byte(0).byte(mode));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_underline(char mode)     // set text mode
 {
-    char command[3]= "";
-
-    command[0] = TEXTUNDERLINE;
-    command[1] = 0;
-    command[2] = mode;
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTUNDERLINE).byte(0).byte(mode));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_width(char width)     // set text width
 {
-    char command[3]= "";
-
-    command[0] = TEXTWIDTH;
-    command[1] = 0;
-    command[2] = width;
     current_wf = width;
     max_col = current_w / (current_fx*current_wf);
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTWIDTH).byte(0).byte(width));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_height(char height)     // set text height
 {
-    char command[3]= "";
-
-    command[0] = TEXTHEIGHT;
-    command[1] = 0;
-    command[2] = height;
     current_hf = height;
     max_row = current_h / (current_fy*current_hf);
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTHEIGHT).byte(0).byte(height));
 }
 
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_char(char c, char col, char row, int color)     // draw a text char
 {
-    char command[6]= "";
-    command[0] = 0xE4; //move cursor
-    command[1] = 0;
-    command[2] = row;
-    command[3] = 0;
-    command[4] = col;
-    writeCOMMAND(command, 5);
-
-    command[0] = 0x7F;  //set color
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[1] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[2] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-    writeCOMMAND(command, 3);
-
-    command[0] = TEXTCHAR;  //print char
-    command[1] = 0;
-    command[2] = c;
-    writeCOMMAND(command, 3);
-
+    writeCOMMAND(LCDPacket<5>(MOVECURSOR).byte(0).byte(row).byte(0).byte(col));
+    writeCOMMAND(LCDPacket<3>(TEXTCOLOR).color(color));
+    writeCOMMAND(LCDPacket<3>(TEXTCHAR).byte(0).byte(c));
 }
 
 
 //****************************************************************************************************
 void uLCD_4DGL :: text_string(char *s, char col, char row, char font, int color)     // draw a text string
 {
-
-    char command[1000]= "";
-    int size = strlen(s);
-    int i = 0;
-
     set_font(font);
-
-    command[0] = 0xE4; //move cursor
-    command[1] = 0;
-    command[2] = row;
-    command[3] = 0;
-    command[4] = col;
-    writeCOMMAND(command, 5);
-
-    command[0] = 0x7F;  //set color
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[1] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[2] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-    writeCOMMAND(command, 3);
-
-    command[0] = TEXTSTRING;
-    for (i=0; i<size; i++) command[1+i] = s[i];
-    command[1+size] = 0;
-    writeCOMMANDnull(command, 2 + size);
+    writeCOMMAND(LCDPacket<5>(MOVECURSOR).byte(0).byte(row).byte(0).byte(col));
+    writeCOMMAND(LCDPacket<3>(TEXTCOLOR).color(color));
+    queueTEXT(s, strlen(s));
 }
 
 
@@ -241,86 +152,41 @@ void uLCD_4DGL :: text_string(char *s, char col, char row, char font, int color)
 //****************************************************************************************************
 void uLCD_4DGL :: locate(char col, char row)     // place text curssor at col, row
 {
-    char command[5] = "";
     current_col = col;
     current_row = row;
-    command[0] = MOVECURSOR; //move cursor
-    command[1] = 0;
-    command[2] = current_row;
-    command[3] = 0;
-    command[4] = current_col;
-    writeCOMMAND(command, 5);
+    writeCOMMAND(LCDPacket<5>(MOVECURSOR).byte(0).byte(current_row).byte(0).byte(current_col));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: color(int color)     // set text color
 {
-    char command[5] = "";
     current_color = color;
-    command[0] = 0x7F;  //set color
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[1] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[2] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TEXTCOLOR).color(color));
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: putc(char c)      // place char at current cursor position
 //used by virtual printf function _putc
 {
-    char command[6] ="";
     if(c<0x20) {
         if(c=='\n') {
-            current_col = 0;
-            current_row++;
-            command[0] = MOVECURSOR; //move cursor to start of next line
-            command[1] = 0;
-            command[2] = current_row;
-            command[3] = 0;
-            command[4] = current_col;
-            writeCOMMAND(command, 5);
+            locate(0, current_row + 1);     //move cursor to start of next line
         }
         if(c=='\r') {
-            current_col = 0;
-            command[0] = MOVECURSOR; //move cursor to start of line
-            command[1] = 0;
-            command[2] = current_row;
-            command[3] = 0;
-            command[4] = current_col;
-            writeCOMMAND(command, 5);
+            locate(0, current_row);         //move cursor to start of line
         }
         if(c=='\f') {
             uLCD_4DGL::cls(); //clear screen on form feed
         }
     } else {
-        command[0] = PUTCHAR;
-        command[1] = 0x00;
-        command[2] = c;
-        writeCOMMAND(command,3);
+        writeCOMMAND(LCDPacket<3>(PUTCHAR).byte(0).byte(c));
         current_col++;
     }
     if (current_col == max_col) {
-        current_col = 0;
-        current_row++;
-        command[0] = MOVECURSOR; //move cursor to next line
-        command[1] = 0;
-        command[2] = current_row;
-        command[3] = 0;
-        command[4] = current_col;
-        writeCOMMAND(command, 5);
+        locate(0, current_row + 1);         //move cursor to next line
     }
     if (current_row == max_row) {
-        current_row = 0;
-        command[0] = MOVECURSOR; //move cursor back to start
-        command[1] = 0;
-        command[2] = current_row;
-        command[3] = 0;
-        command[4] = current_col;
-        writeCOMMAND(command, 5);
+        locate(current_col, 0);             //move cursor back to start
     }
 }
 
@@ -341,3 +207,89 @@ void uLCD_4DGL :: puts(char *s)     // place string at current cursor position
         current_row %= max_row;
     }
 }
+//****************************************************************************************************
+void uLCD_4DGL :: text_print(int col, int row, const char *s, int color)     // write a string in the text grid
+{
+    if (col < 0 || row < 0) return;     // cells are grid subscripts
+    uint16_t color565 = LCD_RGB565(color);
+
+    if (_grid == NULL) {                // starts out as a cleared screen
+        _grid = new TextGrid;
+        memset(_grid->text, ' ', sizeof(_grid->text));
+        memset(_grid->color, 0, sizeof(_grid->color));
+        memset(_grid->dirty, 0, sizeof(_grid->dirty));
+    }
+
+    for (; *s && row < LCD_GRID_ROWS; s++) {
+        if (col >= LCD_GRID_COLS) {     // wrap like putc does
+            col = 0;
+            row++;
+            if (row >= LCD_GRID_ROWS) break;
+        }
+        char &cell = _grid->text[row][col];
+        uint16_t &cell_color = _grid->color[row][col];
+        // a space looks the same in any color
+        if (cell != *s || (*s != ' ' && cell_color != color565)) {
+            cell = *s;
+            cell_color = color565;
+            _grid->dirty[row] |= 1UL << col;
+        }
+        col++;
+    }
+}
+
+//****************************************************************************************************
+int uLCD_4DGL :: text_flush()     // send the changed cells of the text grid
+{
+    if (_grid == NULL) return 0;
+
+    int row, col, start, last;
+    int bytes = 0, sent_color = -1;
+
+    for (row = 0; row < LCD_GRID_ROWS; row++) {
+        uint32_t dirty = _grid->dirty[row];
+        col = 0;
+        while (dirty >> col) {
+            if (!((dirty >> col) & 1)) {
+                col++;
+                continue;
+            }
+            // a run of one color, taking in short gaps of unchanged cells
+            uint16_t color = _grid->color[row][col];
+            start = last = col;
+            for (col++; col < LCD_GRID_COLS && col - last <= LCD_GRID_GAP; col++) {
+                if (_grid->text[row][col] != ' ' && _grid->color[row][col] != color) break;
+                if ((dirty >> col) & 1) last = col;
+            }
+            col = last + 1;
+
+            writeCOMMAND(LCDPacket<5>(MOVECURSOR).byte(0).byte(row).byte(0).byte(start));
+            bytes += 6;
+            if (color != sent_color) {
+                writeCOMMAND(LCDPacket<3>(TEXTCOLOR).word(color));
+                bytes += 4;
+                sent_color = color;
+            }
+            bytes += queueTEXT(&_grid->text[row][start], last + 1 - start);
+        }
+        _grid->dirty[row] = 0;
+    }
+
+    // leave the text color as putc() expects it
+    if (sent_color >= 0 && sent_color != LCD_RGB565(current_color)) {
+        color(current_color);
+        bytes += 4;
+    }
+    return bytes;
+}
+
+//****************************************************************************************************
+void uLCD_4DGL :: text_redraw()     // mark the whole text grid to be sent again
+{
+    if (_grid == NULL) return;
+    for (int row = 0; row < LCD_GRID_ROWS; row++) {
+        for (int col = 0; col < LCD_GRID_COLS; col++) {
+            if (_grid->text[row][col] != ' ') _grid->dirty[row] |= 1UL << col;
+        }
+    }
+}
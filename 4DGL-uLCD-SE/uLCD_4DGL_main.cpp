@@ -26,14 +26,32 @@
 
 
 //******************************************************************************************************
-uLCD_4DGL :: uLCD_4DGL(PinName tx, PinName rx, PinName rst) : _cmd(tx, rx),
+uLCD_4DGL :: uLCD_4DGL(PinName tx, PinName rx, PinName rst, bool init_now, int queue_size) : _cmd(tx, rx),
     _rst(rst)
 #if DEBUGMODE
     ,pc(USBTX, USBRX)
 #endif // DEBUGMODE
 {
     // Constructor
+    int size = 16;
+    while (size < queue_size && size < 0x8000) size <<= 1;   // indices are masked, so a power of 2
+    _tx = new char[size];
+    _tx_mask = size - 1;
+    _tx_in = _tx_out = _tx_left = 0;
+    _tx_paced = _tx_chunk = 0;
+    _tx_paused = false;
+    _p_in = _p_sent = _p_acked = 0;
+    _in_flight = 0;
+    _rx_in = _rx_out = 0;
+    _err_in = _err_out = 0;
+    _errors = 0;
+    _idle_errors = 0;
+    _seq = 0;
+    _grid = NULL;
+    _rate = _baud = 9600;
     _cmd.baud(9600);
+    _cmd.attach(this, &uLCD_4DGL::rxIRQ, RawSerial::RxIrq);
+    _cmd.attach(this, &uLCD_4DGL::txPUMP, RawSerial::TxIrq);
 #if DEBUGMODE
     pc.baud(115200);
 
@@ -44,6 +62,18 @@ uLCD_4DGL :: uLCD_4DGL(PinName tx, PinName rx, PinName rst) : _cmd(tx, rx),
 #endif
 
     _rst = 1;    // put RESET pin to high to start TFT screen
+    current_col         = 0;            // initial cursor col
+    current_row         = 0;            // initial cursor row
+    current_color       = WHITE;        // initial text color
+    current_orientation = IS_PORTRAIT;  // initial screen orientation
+    current_hf = 1;
+    current_wf = 1;
+    if (init_now) init();
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: init()   // reset screen and set up the text state
+{
     reset();
     cls();       // clear screen
     current_col         = 0;            // initial cursor col
@@ -57,77 +87,277 @@ uLCD_4DGL :: uLCD_4DGL(PinName tx, PinName rx, PinName rst) : _cmd(tx, rx),
 }
 
 //******************************************************************************************************
-void uLCD_4DGL :: writeBYTE(char c)   // send a BYTE command to screen
+void uLCD_4DGL :: writeBYTEfast(char c)   // send a BYTE command to screen
 {
 
     _cmd.putc(c);
-    wait_us(500);  //mbed is too fast for LCD at high baud rates in some long commands
+    //wait_ms(0.0);  //mbed is too fast for LCD at high baud rates - but not in short commands
 
 #if DEBUGMODE
     pc.printf("   Char sent : 0x%02X\n",c);
 #endif
 
 }
+//******************************************************************************************************
+void uLCD_4DGL :: freeBUFFER(void)         // Clear serial buffer before writing command
+{
+
+    _rx_out = _rx_in;                     // clear buffer garbage, the RX interrupt has read it
+}
 
 //******************************************************************************************************
-void uLCD_4DGL :: writeBYTEfast(char c)   // send a BYTE command to screen
+int uLCD_4DGL :: writeCOMMAND(const char *command, int number)   // queue a command, the answer is checked when it comes
 {
+    return queueCOMMAND('\xFF', command, number);
+}
 
-    _cmd.putc(c);
-    //wait_ms(0.0);  //mbed is too fast for LCD at high baud rates - but not in short commands
+//******************************************************************************************************
+int uLCD_4DGL :: queueCOMMAND(char prefix, const char *command, int number)   // queue a command for the TX interrupt and return 1
+{
 
 #if DEBUGMODE
-    pc.printf("   Char sent : 0x%02X\n",c);
+    pc.printf("\n");
+    pc.printf("New COMMAND : 0x%02X\n", command[0]);
 #endif
+    int length = number + 1;
+    startCOMMAND(command[0], length, length > LCD_RX_BUFFER ? length : 0);   // long ones are paced
+    queueBYTES(&prefix, 1);
+    queueBYTES(command, number);
+    return 1;
+}
+
+//******************************************************************************************************
+int uLCD_4DGL :: queueTEXT(const char *s, int number)   // queue text as commands that fit the screen buffer, return the bytes
+{
 
+    static const char head[2] = { '\x00', TEXTSTRING };
+    int n, bytes = 0;
+    for (; number > 0; s += n, number -= n) {   // the cursor moves on after each piece
+        n = number < LCD_RX_BUFFER - 3 ? number : LCD_RX_BUFFER - 3;
+        startCOMMAND(TEXTSTRING, n + 3, 0);
+        queueBYTES(head, 2);
+        queueBYTES(s, n);                       // straight from the string, no copy on the stack
+        queueBYTES(head, 1);                    // and its terminating 0
+        bytes += n + 3;
+    }
+    return bytes;
 }
+
 //******************************************************************************************************
-void uLCD_4DGL :: freeBUFFER(void)         // Clear serial buffer before writing command
+void uLCD_4DGL :: startCOMMAND(char command, int length, int paced)   // queue the record of a command, its bytes follow
 {
 
-    while (_cmd.readable()) _cmd.getc();  // clear buffer garbage
+    waitQUEUE(LCD_MAX_PENDING - 1, _tx_mask + 1);   // wait for a free record
+
+    __disable_irq();
+    Pending &p = _pending[_p_in & (LCD_MAX_PENDING - 1)];
+    p.seq     = ++_seq;
+    p.command = command;
+    p.length  = length;
+    p.paced   = paced;
+    _p_in++;
+    __enable_irq();
 }
 
 //******************************************************************************************************
-int uLCD_4DGL :: writeCOMMAND(char *command, int number)   // send several BYTES making a command and return an answer
+void uLCD_4DGL :: queueBYTES(const char *bytes, int number)   // copy bytes of a command to the TX queue
 {
 
-#if DEBUGMODE
-    pc.printf("\n");
-    pc.printf("New COMMAND : 0x%02X\n", command[0]);
-#endif
-    int i, resp = 0;
+    while (number > 0) {
+        waitQUEUE(LCD_MAX_PENDING, _tx_mask);                   // wait for room for a byte at least
+        __disable_irq();
+        int n = _tx_mask + 1 - (uint16_t)(_tx_in - _tx_out);
+        if (n > number) n = number;
+        number -= n;
+        while (n--) _tx[_tx_in++ & _tx_mask] = *bytes++;
+        txPUMP();                               // start sending if the line is idle
+        __enable_irq();
+    }
+}
+
+//******************************************************************************************************
+int uLCD_4DGL :: writeQUERY(const char *command, int number, char *response, int length)   // send a command that returns data, return the bytes received
+{
+
+    int i;
+    waitQUEUE(0, 0);            // or the reply would be taken for the answer to a queued command
     freeBUFFER();
-    writeBYTE(0xFF);
-    for (i = 0; i < number; i++) {
-        if (i<16)
-            writeBYTEfast(command[i]); // send command to serial port
-        else
-            writeBYTE(command[i]); // send command to serial port but slower
+    _seq++;
+    for (i = 0; i < number; i++) writeBYTEfast(command[i]);
+    return readANSWER(response, length);
+}
+
+//******************************************************************************************************
+int uLCD_4DGL :: queryWORD(const char *command, int number)   // send a command answered by ACK and a word, return the word or 0
+{
+
+    char response[3] = "";
+    if (writeQUERY(command, number, response, 3) == 3 && response[0] == ACK) {
+        return ((unsigned char)response[1] << 8) + (unsigned char)response[2];
     }
-    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
-    if (_cmd.readable()) resp = _cmd.getc();           // read response if any
-    switch (resp) {
-        case ACK :                                     // if OK return   1
-            resp =  1;
-            break;
-        case NAK :                                     // if NOK return -1
-            resp = -1;
-            break;
-        default :
-            resp =  0;                                 // else return   0
-            break;
+    return 0;
+}
+
+//******************************************************************************************************
+int uLCD_4DGL :: readANSWER(char *response, int length)   // wait for bytes from the screen, return how many came
+{
+
+    Timer t;
+    int n = 0;
+    t.start();
+    while (n < length && t.read_ms() < LCD_ACK_TIMEOUT) {
+        if (_rx_in != _rx_out) {
+            response[n++] = _rx[_rx_out & (LCD_RX_QUEUE - 1)];
+            _rx_out++;
+        }
     }
-#if DEBUGMODE
-    pc.printf("   Answer received : %d\n",resp);
-#endif
+    return n;
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: waitQUEUE(int commands, int bytes)   // wait until at most this many commands and bytes are queued
+{
+
+    Timer t;
+    uint8_t answered = _p_acked;
+    uint16_t sent = _tx_out;
+    t.start();
+    while ((uint8_t)(_p_in - _p_acked) > commands || (uint16_t)(_tx_in - _tx_out) > bytes) {
+        int ms = t.read_ms();
+        if (_p_acked != answered || _tx_out != sent) {  // the screen is taking commands, start the timeout again
+            answered = _p_acked;
+            sent = _tx_out;
+            t.reset();
+        } else if (ms > LCD_ACK_TIMEOUT) {
+            dropQUEUE();                        // screen stopped answering
+        }
+    }
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: dropQUEUE(void)   // give up on all queued commands, they count as failed
+{
+
+    __disable_irq();
+    while (_p_acked != _p_in) {
+        Pending &p = _pending[_p_acked & (LCD_MAX_PENDING - 1)];
+        addERROR(p.seq, p.command, 0);
+        _p_acked++;
+    }
+    _p_sent    = _p_in;
+    _tx_out    = _tx_in;
+    _tx_left   = 0;
+    _tx_paced  = 0;
+    _tx_paused = false;
+    _resume.detach();
+    _in_flight = 0;
+    __enable_irq();
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: addERROR(uint32_t seq, char command, char answer)   // note a failed command, called with interrupts off
+{
+
+    _errors++;
+    if ((uint8_t)(_err_in - _err_out) < LCD_MAX_ERRORS) {
+        Error &e = _err[_err_in & (LCD_MAX_ERRORS - 1)];
+        e.seq     = seq;
+        e.command = command;
+        e.answer  = answer;
+        _err_in++;
+    }
+}
+
+//******************************************************************************************************
+bool uLCD_4DGL :: get_error(Error &e)   // take the oldest error not reported yet
+{
+
+    if (_err_in == _err_out) return false;
+    e = _err[_err_out & (LCD_MAX_ERRORS - 1)];
+    _err_out++;
+    return true;
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: flush(void)   // wait until every queued byte has been sent
+{
+
+    waitQUEUE(LCD_MAX_PENDING, 0);
+}
 
+//******************************************************************************************************
+int uLCD_4DGL :: wait_idle(void)   // wait until every queued command has been answered
+{
+
+    waitQUEUE(0, 0);
+    int resp = _errors == _idle_errors ? 1 : -1;
+    _idle_errors = _errors;
     return resp;
 }
 
+//******************************************************************************************************
+void uLCD_4DGL :: txPUMP(void)   // TX interrupt: send queued bytes while the next command fits the screen buffer
+{
+
+    while (!_tx_paused && _tx_out != _tx_in && _cmd.writeable()) {
+        if (_tx_left == 0) {                    // next byte starts a command
+            Pending &p = _pending[_p_sent & (LCD_MAX_PENDING - 1)];
+            if (_in_flight && _in_flight + p.length > LCD_RX_BUFFER) break;   // an answer will make room
+            _in_flight += p.length;
+            _tx_left  = p.length;
+            _tx_paced = p.paced;
+            _tx_chunk = 0;
+            _p_sent++;
+        }
+        _cmd.putc(_tx[_tx_out & _tx_mask]);
+        _tx_out++;
+        _tx_left--;
+        if (_tx_paced) {                        // long command: let the screen take in each buffer full
+            _tx_paced--;
+            _tx_chunk++;
+            if (_tx_left && (_tx_chunk == LCD_RX_BUFFER || _tx_paced == 0)) {
+                int us = _tx_chunk * (LCD_BYTE_US - 10000000 / _baud);   // less the time on the wire
+                _tx_chunk = 0;
+                if (us > 0) {
+                    _tx_paused = true;
+                    _resume.attach_us(this, &uLCD_4DGL::txRESUME, us);
+                }
+            }
+        }
+    }
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: txRESUME(void)   // Timeout: the pause in a long command is over
+{
+
+    _tx_paused = false;
+    txPUMP();
+}
+
+//******************************************************************************************************
+void uLCD_4DGL :: rxIRQ(void)   // RX interrupt: match answers to the commands in flight
+{
+
+    while (_cmd.readable()) {
+        char c = _cmd.getc();
+        if (_p_acked != _p_sent) {              // answer to the oldest command on the wire
+            Pending &p = _pending[_p_acked & (LCD_MAX_PENDING - 1)];
+            if (c != ACK) addERROR(p.seq, p.command, c);
+            _in_flight -= p.length;
+            _p_acked++;
+            txPUMP();                           // room for the next ones
+        } else if ((uint8_t)(_rx_in - _rx_out) < LCD_RX_QUEUE) {
+            _rx[_rx_in & (LCD_RX_QUEUE - 1)] = c;   // reply to writeQUERY() or baudrate()
+            _rx_in++;
+        }
+    }
+}
+
 //**************************************************************************
 void uLCD_4DGL :: reset()    // Reset Screen
 {
+    dropQUEUE();            // commands queued now would not survive the reset
     wait_ms(5);
     _rst = 0;               // put RESET pin to low
     wait_ms(5);         // wait a few milliseconds for command reception
@@ -137,49 +367,19 @@ void uLCD_4DGL :: reset()    // Reset Screen
     freeBUFFER();           // clean buffer from possible garbage
 }
 //******************************************************************************************************
-int uLCD_4DGL :: writeCOMMANDnull(char *command, int number)   // send several BYTES making a command and return an answer
+int uLCD_4DGL :: writeCOMMANDnull(const char *command, int number)   // same for a command with a null prefix byte
 {
-
-#if DEBUGMODE
-    pc.printf("\n");
-    pc.printf("New COMMAND : 0x%02X\n", command[0]);
-#endif
-    int i, resp = 0;
-    freeBUFFER();
-    writeBYTE(0x00); //command has a null prefix byte
-    for (i = 0; i < number; i++) {
-        if (i<16) //don't overflow LCD UART buffer
-            writeBYTEfast(command[i]); // send command to serial port
-        else
-            writeBYTE(command[i]); // send command to serial port with delay
-    }
-    while (!_cmd.readable()) wait_ms(TEMPO);              // wait for screen answer
-    if (_cmd.readable()) resp = _cmd.getc();           // read response if any
-    switch (resp) {
-        case ACK :                                     // if OK return   1
-            resp =  1;
-            break;
-        case NAK :                                     // if NOK return -1
-            resp = -1;
-            break;
-        default :
-            resp =  0;                                 // else return   0
-            break;
-    }
-#if DEBUGMODE
-    pc.printf("   Answer received : %d\n",resp);
-#endif
-
-    return resp;
+    return queueCOMMAND('\x00', command, number);
 }
 
 //**************************************************************************
 void uLCD_4DGL :: cls()    // clear screen
 {
-    char command[1] = "";
-
-    command[0] = CLS;
-    writeCOMMAND(command, 1);
+    writeCOMMAND(LCDPacket<1>(CLS));
+    if (_grid) {                        // the text grid is blank now too
+        memset(_grid->text, ' ', sizeof(_grid->text));
+        memset(_grid->dirty, 0, sizeof(_grid->dirty));
+    }
     current_row=0;
     current_col=0;
     current_hf = 1;
@@ -198,10 +398,12 @@ int uLCD_4DGL :: version()    // get API version
 }
 
 //**************************************************************************
-void uLCD_4DGL :: baudrate(int speed)    // set screen baud rate
+int uLCD_4DGL :: baudrate(int speed)    // set screen baud rate
 {
     char command[3]= "";
-    writeBYTE(0x00);
+    int rate = speed;
+    waitQUEUE(0, 0);
+    writeBYTEfast(0x00);
     command[0] = BAUDRATE;
     command[1] = 0;
     int newbaud = BAUD_9600;
@@ -284,6 +486,7 @@ void uLCD_4DGL :: baudrate(int speed)    // set screen baud rate
         default   :
             newbaud = BAUD_9600;
             speed = 9600;
+            rate = 9600;
             break;
     }
 
@@ -294,15 +497,13 @@ void uLCD_4DGL :: baudrate(int speed)    // set screen baud rate
     command[2] = char(newbaud % 256);
     wait_ms(1);
     for (i = 0; i <3; i++) writeBYTEfast(command[i]);      // send command to serial port
-    for (i = 0; i<10; i++) wait_ms(1); 
-    //dont change baud until all characters get sent out
+    wait_us(40000000 / _baud + 1000);  //dont change baud until all characters get sent out
     _cmd.baud(speed);                                  // set mbed to same speed
-    i=0;
-    while ((!_cmd.readable()) && (i<25000)) {
-        wait_ms(TEMPO);           // wait for screen answer - comes 100ms after change
-        i++; //timeout if ack character missed by baud change
-    }
-    if (_cmd.readable()) resp = _cmd.getc();           // read response if any
+    _baud = speed;
+    _rate = rate;
+    char answer = 0;
+    readANSWER(&answer, 1);   // wait for screen answer - comes 100ms after change, or times out if missed
+    resp = answer;
     switch (resp) {
         case ACK :                                     // if OK return   1
             resp =  1;
@@ -314,29 +515,48 @@ void uLCD_4DGL :: baudrate(int speed)    // set screen baud rate
             resp =  0;                                 // else return   0
             break;
     }
+    return resp;
 }
 
-//******************************************************************************************************
-int uLCD_4DGL :: readVERSION(char *command, int number)   // read screen info and populate data
+//**************************************************************************
+int uLCD_4DGL :: negotiate_baud(int max)    // raise the baud rate while the screen keeps answering
 {
+    static const int rates[] = { 9600, 19200, 38400, 57600, 115200, 256000, 500000, 1000000, 1500000, 3000000 };
+    unsigned int i;
 
-    int i, temp = 0, resp = 0;
-    char response[5] = "";
+    if (version() != 1) {               // try the rate the screen starts up with
+        _cmd.baud(9600);
+        _rate = _baud = 9600;
+        if (version() != 1) return 0;
+    }
+    int good = _rate;
 
-    freeBUFFER();
+    for (i = 0; i < ARRAY_SIZE(rates) && rates[i] <= max; i++) {
+        if (rates[i] <= good) continue;
+        if (baudrate(rates[i]) == 1 && version() == 1) {
+            good = rates[i];
+            continue;
+        }
+        // the screen may have switched or not: ask it to go back at the new
+        // rate, then check at the old one, twice in case it saw garbage first
+        baudrate(good);
+        if (version() != 1 && version() != 1) return 0;
+        break;
+    }
+    return good;
+}
 
-    for (i = 0; i < number; i++) writeBYTE(command[i]);    // send all chars to serial port
+//******************************************************************************************************
+int uLCD_4DGL :: readVERSION(char *command, int number)   // read screen info and populate data
+{
 
-    while (!_cmd.readable()) wait_ms(TEMPO);               // wait for screen answer
+    int resp = 0;
+    char response[3] = "";
 
-    while (_cmd.readable() && resp < ARRAY_SIZE(response)) {
-        temp = _cmd.getc();
-        response[resp++] = (char)temp;
-    }
-    switch (resp) {
-        case 2 :                                           // if OK populate data and return 1
-            revision  = response[0]<<8 + response[1];
-            resp      = 1;
+    switch (writeQUERY(command, number, response, 3)) {
+        case 3 :                                           // if OK populate data and return 1
+            revision  = ((unsigned char)response[1] << 8) + (unsigned char)response[2];
+            resp      = response[0] == ACK ? 1 : 0;
             break;
         default :
             resp =  0;                                     // else return 0
@@ -348,46 +568,18 @@ int uLCD_4DGL :: readVERSION(char *command, int number)   // read screen info an
 //****************************************************************************************************
 void uLCD_4DGL :: background_color(int color)              // set screen background color
 {
-    char command[3]= "";                                  // input color is in 24bits like 0xRRGGBB
-
-    command[0] = BCKGDCOLOR;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[1] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[2] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(BCKGDCOLOR).color(color));  // input color is in 24bits like 0xRRGGBB
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: textbackground_color(int color)              // set screen background color
 {
-    char command[3]= "";                                  // input color is in 24bits like 0xRRGGBB
-
-    command[0] = TXTBCKGDCOLOR;
-
-    int red5   = (color >> (16 + 3)) & 0x1F;              // get red on 5 bits
-    int green6 = (color >> (8 + 2))  & 0x3F;              // get green on 6 bits
-    int blue5  = (color >> (0 + 3))  & 0x1F;              // get blue on 5 bits
-
-    command[1] = ((red5 << 3)   + (green6 >> 3)) & 0xFF;  // first part of 16 bits color
-    command[2] = ((green6 << 5) + (blue5 >>  0)) & 0xFF;  // second part of 16 bits color
-
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(TXTBCKGDCOLOR).color(color));  // input color is in 24bits like 0xRRGGBB
 }
 
 //****************************************************************************************************
 void uLCD_4DGL :: display_control(char mode)     // set screen mode to value
 {
-    char command[3]= "";
-
-    command[0] = DISPCONTROL;
-    command[1] = 0;
-    command[2] = mode;
-
     if (mode ==  ORIENTATION) {
         switch (mode) {
             case LANDSCAPE :
@@ -404,28 +596,18 @@ void uLCD_4DGL :: display_control(char mode)     // set screen mode to value
                 break;
         }
     }
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(DISPCONTROL).byte(0).byte(mode));
     set_font(current_font);
 }
 //****************************************************************************************************
 void uLCD_4DGL :: display_power(char mode)     // set screen mode to value
 {
-    char command[3]= "";
-
-    command[0] = DISPPOWER;
-    command[1] = 0;
-    command[2] = mode;
-    writeCOMMAND(command, 3);
+    writeCOMMAND(LCDPacket<3>(DISPPOWER).byte(0).byte(mode));
 }
 //****************************************************************************************************
 void uLCD_4DGL :: set_volume(char value)     // set sound volume to value
 {
-    char command[2]= "";
-
-    command[0] = SETVOLUME;
-    command[1] = value;
-
-    writeCOMMAND(command, 2);
+    writeCOMMAND(LCDPacket<2>(SETVOLUME).byte(value));
 }
 
 
@@ -438,20 +620,10 @@ int uLCD_4DGL :: getSTATUS(char *command, int number)   // read screen info and
     pc.printf("New COMMAND : 0x%02X\n", command[0]);
 #endif
 
-    int i, temp = 0, resp = 0;
-    char response[5] = "";
+    int resp = 0;
+    char response[4] = "";
 
-    freeBUFFER();
-
-    for (i = 0; i < number; i++) writeBYTE(command[i]);    // send all chars to serial port
-
-    while (!_cmd.readable()) wait_ms(TEMPO);    // wait for screen answer
-
-    while (_cmd.readable() && resp < ARRAY_SIZE(response)) {
-        temp = _cmd.getc();
-        response[resp++] = (char)temp;
-    }
-    switch (resp) {
+    switch (writeQUERY(command, number, response, 4)) {
         case 4 :
             resp = (int)response[1];         // if OK populate data
             break;
@@ -0,0 +1,229 @@
+#include "EventLog.h"
+#include "SDCRC.h"
+#include "diskio.h"
+#include "mbed_debug.h"
+#include <stddef.h>
+
+#define EVENTLOG_DBG 0
+
+// A sector has to hold a whole number of records
+typedef char eventlog_record_size[sizeof(EventRecord) * EVENTLOG_RECORDS_PER_SECTOR == 512 ? 1 : -1];
+
+EventLog::EventLog() : _fs(NULL), _first(NULL) {
+    _base = 0;
+    _sectors = 0;
+    _head = 0;
+    _slot = 0;
+    _next_seq = 1;
+    _dirty = false;
+}
+
+EventLog::~EventLog() {
+    close();
+}
+
+int EventLog::open(FATFileSystem &fs, const char *name, uint32_t sectors) {
+    close();
+    char n[64];
+    sprintf(n, "%s/%s", fs._fsid, name);
+
+    FIL fh;
+    FRESULT res = f_open(&fh, n, FA_READ|FA_WRITE|FA_OPEN_ALWAYS);
+    if (res) {
+        debug_if(EVENTLOG_DBG, "f_open(%s) failed: %d\n", n, res);
+        return -1;
+    }
+
+    // a new log is one run of clusters, cleared so no old data looks like records
+    if (fh.fsize == 0 && sectors >= 2) {
+        res = f_expand(&fh, sectors * 512, 1);
+        memset(_buf, 0, sizeof(_buf));
+        for (uint32_t i = 0; res == FR_OK && i < sectors; i++) {
+            UINT bw;
+            res = f_write(&fh, _buf, 512, &bw);
+        }
+    }
+
+    // appends go straight to the sectors, which needs the file in one piece
+    DWORD frags = 0;
+    if (res == FR_OK) {
+        res = f_fragments(&fh, &frags);
+    }
+    if (res == FR_OK && (frags != 1 || fh.fsize < 1024)) {
+        res = FR_DENIED;
+    }
+    if (res == FR_OK) {
+        _sectors = fh.fsize / 512;
+        _base = fh.fs->database + (fh.sclust - 2) * fh.fs->csize;
+        _fs = fh.fs;
+    }
+    FRESULT cres = f_close(&fh);
+    if (res == FR_OK) {
+        res = cres;
+    }
+    if (res) {
+        debug_if(EVENTLOG_DBG, "EventLog %s unusable: %d (%d fragments)\n", n, res, (int)frags);
+        _fs = NULL;
+        return -1;
+    }
+
+    // one pass over the file: index every sector and find the newest record
+    _first = new uint32_t[_sectors];
+    uint32_t last = 0;
+    _head = 0;
+    _slot = 0;
+    for (uint32_t s = 0; s < _sectors; s++) {
+        if (_load(s, _buf)) {
+            close();
+            return -1;
+        }
+        _first[s] = _valid(_buf[0]) ? _buf[0].seq : 0;
+        uint32_t i = 0;
+        while (i < EVENTLOG_RECORDS_PER_SECTOR && _valid(_buf[i]) && _buf[i].seq == _buf[0].seq + i) {
+            i++;
+        }
+        if (i && _buf[i - 1].seq > last) {
+            last = _buf[i - 1].seq;
+            _head = s;
+            _slot = i;
+        }
+    }
+    _next_seq = last + 1;
+
+    // carry on filling the newest sector, or start the next one
+    if (_slot == EVENTLOG_RECORDS_PER_SECTOR) {
+        _head = (_head + 1) % _sectors;
+        _slot = 0;
+    }
+    if (_slot == 0 || _load(_head, _buf)) {
+        _slot = 0;
+        memset(_buf, 0, sizeof(_buf));
+    } else {
+        memset(&_buf[_slot], 0, (EVENTLOG_RECORDS_PER_SECTOR - _slot) * sizeof(EventRecord));
+    }
+    _dirty = false;
+    debug_if(EVENTLOG_DBG, "EventLog %s: %d sectors, records %d..%d\n", n, _sectors, first_seq(), last_seq());
+    return 0;
+}
+
+void EventLog::close() {
+    if (_fs) {
+        flush();
+    }
+    delete[] _first;
+    _first = NULL;
+    _fs = NULL;
+}
+
+uint32_t EventLog::append(uint16_t type, const void *data, uint32_t length, uint32_t time) {
+    if (_fs == NULL || length > EVENTLOG_DATA_LEN) {
+        return 0;
+    }
+    uint32_t seq = _next_seq++;
+    EventRecord &r = _buf[_slot++];
+    memset(&r, 0, sizeof(r));
+    r.seq = seq;
+    r.time = time;
+    r.type = type;
+    memcpy(r.data, data, length);
+    r.crc = sd_crc16((const uint8_t*)&r, offsetof(EventRecord, crc));
+    _dirty = true;
+
+    // a full sector goes out now, the next one (the oldest) is reused
+    if (_slot == EVENTLOG_RECORDS_PER_SECTOR) {
+        int err = flush();
+        _head = (_head + 1) % _sectors;
+        _slot = 0;
+        memset(_buf, 0, sizeof(_buf));
+        if (err) {
+            return 0;
+        }
+    }
+    return seq;
+}
+
+int EventLog::flush() {
+    if (_fs == NULL) {
+        return -1;
+    }
+    if (!_dirty) {
+        return 0;
+    }
+    if (_store(_head, _buf)) {
+        return -1;
+    }
+    _first[_head] = _buf[0].seq;
+    _dirty = false;
+    return 0;
+}
+
+int EventLog::read(uint32_t seq, EventRecord *record) {
+    if (_fs == NULL || seq == 0 || seq >= _next_seq) {
+        return -1;
+    }
+
+    // still in the buffer
+    uint32_t buffered = _next_seq - _slot;
+    if (seq >= buffered) {
+        *record = _buf[seq - buffered];
+        return 0;
+    }
+
+    for (uint32_t s = 0; s < _sectors; s++) {
+        if (_first[s] && seq >= _first[s] && seq < _first[s] + EVENTLOG_RECORDS_PER_SECTOR) {
+            EventRecord *records = new EventRecord[EVENTLOG_RECORDS_PER_SECTOR];
+            int err = _load(s, records);
+            EventRecord &r = records[seq - _first[s]];
+            if (!err && _valid(r) && r.seq == seq) {
+                *record = r;
+            } else {
+                err = -1;
+            }
+            delete[] records;
+            return err;
+        }
+    }
+    return -1;
+}
+
+uint32_t EventLog::first_seq() {
+    uint32_t first = _slot ? _buf[0].seq : 0;
+    for (uint32_t s = 0; _first && s < _sectors; s++) {
+        if (_first[s] && (first == 0 || _first[s] < first)) {
+            first = _first[s];
+        }
+    }
+    return first;
+}
+
+// Raw sector access, under the volume lock so it does not cut into FatFs
+int EventLog::_load(uint32_t sector, EventRecord *records) {
+#if _FS_REENTRANT
+    if (!ff_req_grant(_fs->sobj)) {
+        return -1;
+    }
+#endif
+    DRESULT res = disk_read(_fs->drv, (BYTE*)records, _base + sector, 1);
+#if _FS_REENTRANT
+    ff_rel_grant(_fs->sobj);
+#endif
+    return res == RES_OK ? 0 : -1;
+}
+
+int EventLog::_store(uint32_t sector, const EventRecord *records) {
+#if _FS_REENTRANT
+    if (!ff_req_grant(_fs->sobj)) {
+        return -1;
+    }
+#endif
+    DRESULT res = disk_write(_fs->drv, (const BYTE*)records, _base + sector, 1);
+#if _FS_REENTRANT
+    ff_rel_grant(_fs->sobj);
+#endif
+    return res == RES_OK ? 0 : -1;
+}
+
+bool EventLog::_valid(const EventRecord &record) {
+    return record.seq != 0 && record.seq != 0xFFFFFFFF
+        && record.crc == sd_crc16((const uint8_t*)&record, offsetof(EventRecord, crc));
+}
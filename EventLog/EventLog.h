@@ -0,0 +1,111 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "mbed.h"
+#include "FATFileSystem.h"
+#include <stdint.h>
+
+#define EVENTLOG_DATA_LEN           20
+#define EVENTLOG_RECORDS_PER_SECTOR 16  // 512 / sizeof(EventRecord)
+
+/** One fixed-size record of the event log, 32 bytes on the card */
+struct EventRecord {
+    uint32_t seq;                       // 1, 2, 3... given by EventLog::append()
+    uint32_t time;                      // timestamp chosen by the caller
+    uint16_t type;                      // record type chosen by the caller
+    uint8_t  data[EVENTLOG_DATA_LEN];   // payload, zero padded
+    uint16_t crc;                       // CRC16 of the fields above
+};
+
+/** Append-only record store in a preallocated file
+ *
+ * The file is allocated once as one contiguous run of clusters and is then
+ * written sector by sector straight to the disk, so appending never touches
+ * the FAT or the directory entry. Records collect in a one sector buffer
+ * which goes to the card when it fills up or on flush(): a batch of appends
+ * costs one sector write. When the last sector is full, writing wraps around
+ * to the first one and the oldest 16 records are dropped.
+ *
+ * Records not flushed yet are lost on a reset or power cut. Flushing after
+ * every append keeps each record safe as soon as append() returns, at one
+ * sector write per record, rewriting the same sector until it fills; batch
+ * appends and flush less often when records come faster than the card
+ * should be written.
+ *
+ * open() reads the whole file once to find the newest record and to index
+ * the first sequence number of every sector, so read() needs one sector read.
+ * Records that fail their CRC, e.g. after a reset in the middle of a write,
+ * are skipped. An EventLog is not locked against use from several threads.
+ *
+ * @code
+ * EventLog log;
+ * log.open(sd, "rounds.log", 64);     // 32kB, 1024 records
+ * log.append(ROUND_END, &round, sizeof(round), t.read_ms());
+ * log.flush();
+ * @endcode
+ */
+class EventLog {
+public:
+
+    EventLog();
+    ~EventLog();
+
+    /** Open the log, creating and preallocating the file if needed
+     *
+     * @param fs Filesystem to keep the file on
+     * @param name File name on the filesystem
+     * @param sectors Size of a new log in 512-byte sectors, at least 2
+     * @returns 0 on success, -1 on failure or if an existing file is fragmented
+     */
+    int open(FATFileSystem &fs, const char *name, uint32_t sectors);
+
+    /** Write out buffered records and release the index */
+    void close();
+
+    /** Add a record, buffered until the sector is full or flush() is called
+     *
+     * @param type Record type
+     * @param data Payload, up to EVENTLOG_DATA_LEN bytes
+     * @param length Bytes of payload
+     * @param time Timestamp to store with it
+     * @returns the sequence number of the record, 0 on failure
+     */
+    uint32_t append(uint16_t type, const void *data, uint32_t length, uint32_t time);
+
+    /** Write the buffered records to the card
+     *
+     * @returns 0 on success, -1 on failure
+     */
+    int flush();
+
+    /** Read a record back by its sequence number
+     *
+     * @returns 0 on success, -1 if the record is not (or no longer) in the log
+     */
+    int read(uint32_t seq, EventRecord *record);
+
+    /** Sequence number of the oldest record, 0 when the log is empty */
+    uint32_t first_seq();
+
+    /** Sequence number of the newest record, 0 when the log is empty */
+    uint32_t last_seq() { return _next_seq - 1; }
+
+protected:
+
+    int _load(uint32_t sector, EventRecord *records);
+    int _store(uint32_t sector, const EventRecord *records);
+    static bool _valid(const EventRecord &record);
+
+    FATFS *_fs;             // Volume of the file, NULL when closed
+    uint32_t _base;         // First sector of the file on the disk
+    uint32_t _sectors;      // Sectors in the file
+    uint32_t *_first;       // Sequence number of the first record in each sector, 0 if none
+
+    uint32_t _head;         // Sector being filled
+    uint32_t _slot;         // Next free record in it
+    uint32_t _next_seq;
+    bool _dirty;            // Buffer holds records not on the card yet
+    EventRecord _buf[EVENTLOG_RECORDS_PER_SECTOR];
+};
+
+#endif
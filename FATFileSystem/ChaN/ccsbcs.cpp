@@ -24,6 +24,13 @@
 #include "ff.h"
 
 
+/* Reverse lookups (Unicode to OEM code, lower to upper case) use open addressing
+/  hash tables with linear probing, generated off-line from Tbl[] and lower[] with
+/  the hash functions below. They must be regenerated when those tables change. */
+#define HASH_OEM(c)	((WORD)((c) * 48527U) >> 8)		/* Index into Rev[] (256 slots) */
+#define HASH_UPR(c)	((WORD)((c) * 65359U) >> 6)		/* Index into idx[] (1024 slots) */
+
+
 #if _CODE_PAGE == 437
 #define _TBLDEF 1
 static
@@ -38,6 +45,26 @@ const WCHAR Tbl[] = {	/*  CP437(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP437(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0xC7, 0x00, 0x00, 0xE6, 0x00, 0xB0, 0xF3, 0x00, 0x00, 0x87, 0xBE, 0x00, 0xF1,
+	0xE5, 0x00, 0x00, 0x00, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0xD6, 0x8E, 0x00, 0x00, 0xFE, 0x00, 0xB3, 0x94, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x9D, 0x00, 0x00,
+	0x00, 0x95, 0xCB, 0x00, 0xEC, 0xAC, 0xAD, 0x00, 0x00, 0xE9, 0x8C, 0xB6, 0x00, 0x00, 0xF4, 0xC2,
+	0xFB, 0x00, 0x00, 0x00, 0x88, 0xC6, 0x00, 0x00, 0x00, 0xED, 0x00, 0xDE, 0x00, 0x00, 0x91, 0xC8,
+	0xF7, 0x00, 0xF8, 0xB4, 0x00, 0xDD, 0x00, 0x00, 0x83, 0xB7, 0x80, 0xEF, 0xAA, 0x00, 0xDB, 0xE4,
+	0x97, 0x00, 0xD5, 0x00, 0x00, 0xA9, 0xC3, 0x00, 0xDC, 0x00, 0xCA, 0x00, 0x00, 0xA8, 0x00, 0x00,
+	0xD9, 0x00, 0xDF, 0xA4, 0xD2, 0x99, 0x00, 0xAF, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0xA1, 0xB5, 0x00,
+	0xF9, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0xE2, 0x82, 0x9E, 0xBC, 0x00, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x86, 0xD3, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE8, 0x81, 0x00, 0xA0, 0xB8, 0x92, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x00, 0xCE, 0x00, 0xBA, 0x00, 0x00, 0x00, 0x00, 0x9F, 0xC4, 0x93, 0xD0, 0x00, 0x00,
+	0x00, 0x00, 0x9C, 0xEE, 0x00, 0x00, 0xD1, 0x00, 0x00, 0xA7, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x8D,
+	0xCC, 0xA5, 0x00, 0x00, 0x00, 0x00, 0xB1, 0xF2, 0x00, 0x8A, 0xBD, 0x00, 0x00, 0xFD, 0xE7, 0x00,
+	0xEA, 0x98, 0xF0, 0x84, 0xD4, 0x90, 0x00, 0x00, 0xE3, 0x00, 0x00, 0x96, 0x00, 0x85, 0xC9, 0x8F,
+	0xA6, 0x00, 0x00, 0x00, 0xF6, 0xD7, 0x9A, 0xCD, 0x00, 0xFC, 0x00, 0x00, 0x00, 0x00, 0xA2, 0xCF,
+	0x00, 0x00, 0xAB, 0x00, 0x9B, 0xEB, 0x00, 0x00, 0x8B, 0xB9, 0x00, 0x00, 0xF5, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 720
 #define _TBLDEF 1
 static
@@ -52,6 +79,26 @@ const WCHAR Tbl[] = {	/*  CP720(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x064B, 0x064C, 0x064D, 0x064E, 0x064F, 0x0650, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP720(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0x9B, 0xC7, 0x00, 0xE6, 0x00, 0xB0, 0x00, 0x00, 0x00, 0x87, 0xBE, 0x00, 0x00,
+	0x00, 0x92, 0x00, 0xE1, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0x00, 0xF4, 0x00, 0xAB, 0x00, 0x00,
+	0xD6, 0x00, 0x00, 0x00, 0xFE, 0xEF, 0xB3, 0xA7, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x00, 0x00, 0xEB,
+	0x00, 0xA3, 0xCB, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE7, 0x00, 0x8C, 0x9F, 0xB6, 0x00, 0xFB, 0xC2,
+	0x00, 0x00, 0x00, 0x00, 0x88, 0x9A, 0xC6, 0x00, 0x00, 0x00, 0x00, 0xDE, 0xE4, 0x00, 0xF7, 0xC8,
+	0x00, 0x00, 0xF8, 0xB4, 0x91, 0xDD, 0xE0, 0x00, 0x83, 0xB7, 0x00, 0x00, 0x00, 0x00, 0xDB, 0xAA,
+	0x97, 0xF3, 0xD5, 0x00, 0x00, 0x00, 0xC3, 0xEE, 0xDC, 0xA6, 0xCA, 0x00, 0x00, 0x00, 0x00, 0x94,
+	0xD9, 0xEA, 0xDF, 0xA2, 0xD2, 0x00, 0x00, 0xAF, 0x00, 0xFF, 0xC0, 0xE5, 0x00, 0x9E, 0xB5, 0x00,
+	0xF9, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0x99, 0x82, 0xBC, 0x00, 0x00, 0x00, 0x00, 0xDA, 0xE3, 0x00,
+	0x00, 0xD3, 0x00, 0x00, 0x00, 0x00, 0xF6, 0x00, 0xAD, 0x00, 0x00, 0xB8, 0x00, 0x00, 0xAE, 0x00,
+	0xF2, 0x00, 0xA9, 0xCE, 0x00, 0xBA, 0x00, 0x00, 0x00, 0x00, 0xED, 0xC4, 0x93, 0xA5, 0xD0, 0x00,
+	0x00, 0x00, 0x9C, 0xE9, 0x00, 0xA1, 0xD1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x95, 0x00, 0x9D,
+	0xCC, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB1, 0x00, 0x00, 0x8A, 0x98, 0xBD, 0x00, 0xFD, 0x00, 0x00,
+	0x00, 0xE2, 0xF0, 0x00, 0xD4, 0x00, 0x00, 0x00, 0x00, 0xF5, 0x00, 0x96, 0xAC, 0x85, 0xC9, 0x00,
+	0x00, 0x00, 0xF1, 0x00, 0xA8, 0xD7, 0x00, 0xCD, 0x00, 0xFC, 0x00, 0x00, 0xEC, 0x00, 0xA4, 0xCF,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE8, 0x00, 0x8B, 0xA0, 0xB9, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 737
 #define _TBLDEF 1
 static
@@ -66,6 +113,26 @@ const WCHAR Tbl[] = {	/*  CP737(0x80-0xFF) to Unicode conversion table */
 	0x038F, 0x00B1, 0x2265, 0x2264, 0x03AA, 0x03AB, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP737(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x84, 0x00, 0xC7, 0x00, 0x00, 0x00, 0xAE, 0xB0, 0xE1, 0x80, 0xF3, 0xBE, 0x00, 0x00, 0xF1,
+	0xA9, 0x00, 0x96, 0x00, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0xA6, 0x00, 0x92, 0x00, 0xEC, 0x00,
+	0xD6, 0x00, 0x00, 0x00, 0xA2, 0xFE, 0x8F, 0xB3, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x00, 0x9E, 0x00,
+	0x8B, 0xCB, 0x00, 0x00, 0x00, 0x00, 0xE9, 0x9A, 0x00, 0x87, 0x00, 0xB6, 0x00, 0x00, 0xFB, 0xC2,
+	0xE4, 0xE5, 0x00, 0x83, 0x00, 0xC6, 0x00, 0x00, 0x00, 0xAD, 0x00, 0xDE, 0xF5, 0x00, 0xF7, 0xC8,
+	0x00, 0x00, 0xF8, 0xAA, 0xB4, 0x95, 0xDD, 0xEE, 0x00, 0xB7, 0x00, 0x00, 0x00, 0xA5, 0xDB, 0x91,
+	0xEB, 0x00, 0xD5, 0x00, 0x00, 0x00, 0xA1, 0xC3, 0x8E, 0xDC, 0xCA, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x9D, 0xD9, 0x8A, 0xDF, 0xD2, 0x00, 0x00, 0x00, 0xE7, 0xFF, 0x99, 0xC0, 0x86, 0x00, 0xB5, 0x00,
+	0xF9, 0xFA, 0xE0, 0xBF, 0xB2, 0xE3, 0x82, 0xBC, 0x00, 0x00, 0x00, 0x00, 0xAC, 0xDA, 0xF4, 0xF0,
+	0x00, 0xD3, 0x00, 0x00, 0x00, 0xA8, 0x00, 0x94, 0x00, 0x00, 0x00, 0xB8, 0x00, 0x00, 0x00, 0xA4,
+	0x00, 0x00, 0x00, 0xCE, 0x00, 0xBA, 0x00, 0x00, 0x00, 0xA0, 0x00, 0x8D, 0xC4, 0xD0, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x9C, 0x00, 0x89, 0xD1, 0x00, 0x00, 0x00, 0xE6, 0x00, 0x98, 0x00, 0x85, 0x00,
+	0xCC, 0x00, 0x00, 0x00, 0xAF, 0x00, 0xB1, 0xE2, 0x81, 0xF2, 0xBD, 0x00, 0x00, 0xFD, 0xAB, 0x00,
+	0x97, 0x00, 0xEF, 0x00, 0xD4, 0x00, 0x00, 0x00, 0xA7, 0x00, 0x93, 0x00, 0xED, 0xC9, 0x00, 0x00,
+	0x00, 0x00, 0xA3, 0x90, 0xF6, 0xD7, 0xEA, 0xCD, 0x00, 0xFC, 0x00, 0x9F, 0x00, 0x8C, 0x00, 0xCF,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x9B, 0x00, 0x88, 0x00, 0xB9, 0x00, 0x00, 0x00, 0xE8, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 771
 #define _TBLDEF 1
 static
@@ -80,6 +147,26 @@ const WCHAR Tbl[] = {	/*  CP771(0x80-0xFF) to Unicode conversion table */
 	0x0118, 0x0119, 0x0116, 0x0117, 0x012E, 0x012F, 0x0160, 0x0161, 0x0172, 0x0173, 0x016A, 0x016B, 0x017D, 0x017E, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP771(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x88, 0x00, 0xC7, 0x00, 0x00, 0x00, 0xEA, 0xB0, 0x9F, 0x00, 0x84, 0xFA, 0x00, 0x00, 0x00,
+	0x00, 0xE6, 0xF1, 0x9B, 0x80, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0xE2, 0x00, 0x97, 0xFC, 0x00, 0x00,
+	0xD6, 0x00, 0x00, 0x00, 0xAE, 0xFE, 0x93, 0xB3, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x00, 0xAA, 0xDF,
+	0x8F, 0xCB, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA6, 0x00, 0x8B, 0xB6, 0x00, 0x00, 0x00, 0xC2,
+	0xED, 0xA2, 0xDD, 0x87, 0x00, 0xC6, 0x00, 0x00, 0x00, 0xE9, 0x00, 0x9E, 0x00, 0x83, 0x00, 0xC8,
+	0x00, 0x00, 0x00, 0xB4, 0xE5, 0x9A, 0xF0, 0x00, 0x00, 0xB7, 0x00, 0x00, 0xF5, 0xE1, 0xDB, 0x96,
+	0x00, 0x00, 0xD5, 0xF7, 0x00, 0x00, 0xC3, 0xAD, 0x92, 0x00, 0xCA, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xA9, 0xD9, 0x8E, 0xDE, 0xD2, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xA5, 0xC0, 0x8A, 0x00, 0xB5, 0x00,
+	0x00, 0x00, 0xEC, 0xBF, 0xA1, 0xB2, 0x86, 0xBC, 0xDC, 0x00, 0x00, 0x00, 0xE8, 0xDA, 0x9D, 0x00,
+	0x82, 0xD3, 0x00, 0x00, 0x00, 0xE4, 0xF3, 0x99, 0x00, 0x00, 0x00, 0xB8, 0x00, 0x00, 0xF4, 0xE0,
+	0x00, 0x95, 0x00, 0xCE, 0xF6, 0xBA, 0x00, 0x00, 0x00, 0xAC, 0x00, 0x91, 0xC4, 0xD0, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xA8, 0x00, 0x8D, 0xD1, 0xF9, 0x00, 0x00, 0x00, 0xEF, 0x00, 0xA4, 0x89, 0x00,
+	0xCC, 0x00, 0x00, 0x00, 0xEB, 0x00, 0xA0, 0xB1, 0x85, 0xFB, 0xBD, 0x00, 0x00, 0x00, 0xE7, 0x00,
+	0x9C, 0x00, 0x81, 0x00, 0xBE, 0x00, 0x00, 0x00, 0xE3, 0xF2, 0x98, 0xFD, 0x00, 0xC9, 0x00, 0x00,
+	0x00, 0x00, 0xAF, 0x00, 0x94, 0xD7, 0x00, 0xCD, 0x00, 0x00, 0x00, 0xAB, 0x00, 0x90, 0x00, 0xCF,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xA7, 0x00, 0x8C, 0xF8, 0xB9, 0x00, 0x00, 0x00, 0xEE, 0x00, 0xA3
+};
+
 #elif _CODE_PAGE == 775
 #define _TBLDEF 1
 static
@@ -94,6 +181,26 @@ const WCHAR Tbl[] = {	/*  CP775(0x80-0xFF) to Unicode conversion table */
 	0x00AD, 0x00B1, 0x201C, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x201E, 0x00B0, 0x2219, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP775(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE6, 0x00, 0xB0, 0x00, 0x00, 0x00, 0xC7, 0x00, 0x00, 0xF1,
+	0x00, 0xD2, 0x00, 0x00, 0x00, 0x00, 0xBB, 0xF7, 0xC5, 0xF0, 0x00, 0x00, 0x00, 0xCF, 0x00, 0xE1,
+	0x00, 0x8E, 0x00, 0xA8, 0xFE, 0x00, 0xB3, 0x8D, 0x94, 0x00, 0x00, 0xE3, 0xC1, 0x00, 0x00, 0xD1,
+	0x00, 0xCB, 0x00, 0x97, 0x9E, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE0, 0x8A, 0xEA, 0xC2,
+	0x00, 0x00, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE9, 0x00, 0x00, 0xDE, 0x83, 0x00, 0x91, 0xC8,
+	0x00, 0x00, 0xF8, 0xB4, 0xB7, 0xDD, 0x00, 0x00, 0x00, 0xA6, 0x00, 0x00, 0xAA, 0xD4, 0xDB, 0x00,
+	0xA4, 0x00, 0xD5, 0xEF, 0xEC, 0x00, 0x8C, 0xC3, 0xDC, 0xE4, 0xCA, 0x00, 0x00, 0x88, 0x00, 0x9F,
+	0xD9, 0xB6, 0xDF, 0x00, 0x00, 0x99, 0x00, 0xAF, 0x00, 0x85, 0xC0, 0xFF, 0x00, 0x00, 0x00, 0x00,
+	0xF9, 0xFA, 0x00, 0xBF, 0xB2, 0xB5, 0x00, 0x82, 0xBC, 0x00, 0xFC, 0xE8, 0x00, 0xDA, 0x00, 0xA0,
+	0x86, 0x00, 0x00, 0x93, 0x00, 0x00, 0xD3, 0x00, 0x81, 0x00, 0x00, 0xF2, 0x92, 0x00, 0xAE, 0xBD,
+	0x89, 0x00, 0x9B, 0xA3, 0xBE, 0xBA, 0xCE, 0xEE, 0xA1, 0xF5, 0x00, 0xC4, 0x00, 0x00, 0x00, 0x00,
+	0xAD, 0xF3, 0x9C, 0x00, 0x00, 0x00, 0xD6, 0xE5, 0x00, 0x00, 0x00, 0x95, 0x00, 0x87, 0x00, 0x00,
+	0xCC, 0x00, 0x00, 0xF4, 0x00, 0x00, 0xB1, 0x00, 0x00, 0xD7, 0x00, 0x00, 0x00, 0xFD, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x84, 0x00, 0x90, 0xE2, 0xA9, 0x00, 0xB8, 0x00, 0xD8, 0x00, 0xC9, 0x00, 0x8F,
+	0x00, 0x00, 0x00, 0xED, 0xF6, 0xA5, 0x9A, 0xCD, 0xE7, 0x00, 0xA7, 0x00, 0x00, 0x00, 0xA2, 0x00,
+	0x98, 0x9D, 0xAB, 0x00, 0x96, 0x00, 0x00, 0x00, 0xC6, 0xB9, 0x8B, 0x00, 0xEB, 0xFB, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 850
 #define _TBLDEF 1
 static
@@ -108,6 +215,26 @@ const WCHAR Tbl[] = {	/*  CP850(0x80-0xFF) to Unicode conversion table */
 	0x00AD, 0x00B1, 0x2017, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x00B8, 0x00B0, 0x00A8, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP850(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0x00, 0xD1, 0x00, 0xE6, 0x00, 0xB0, 0x00, 0x00, 0x00, 0x87, 0xDE, 0x00, 0xF1,
+	0x00, 0x00, 0x00, 0xE7, 0x00, 0xC6, 0xBB, 0xD4, 0xC5, 0xF0, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0x00, 0x8E, 0x00, 0xB8, 0xFE, 0x00, 0xB3, 0x94, 0x00, 0xEA, 0x00, 0xB7, 0xC1, 0xBE, 0x00, 0x00,
+	0x00, 0x95, 0xCB, 0x9E, 0x00, 0xAC, 0xAD, 0x00, 0x00, 0x00, 0x8C, 0x00, 0xE0, 0x00, 0xF7, 0xC2,
+	0x00, 0x00, 0x00, 0x00, 0x88, 0x00, 0xD8, 0x00, 0xEF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x91, 0xC8,
+	0xD3, 0x00, 0xF8, 0xB4, 0x00, 0x00, 0xEC, 0x00, 0x83, 0x00, 0x80, 0x00, 0xAA, 0x00, 0xDB, 0x00,
+	0x97, 0x00, 0xE8, 0xC7, 0x00, 0xF9, 0xC3, 0x00, 0xDC, 0xE4, 0xCA, 0xE9, 0x00, 0xA8, 0x00, 0xCF,
+	0xD9, 0x00, 0xDF, 0xA4, 0x00, 0x99, 0x00, 0xAF, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0xA1, 0x00, 0xE3,
+	0x00, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0x00, 0x82, 0xBC, 0xD7, 0xFC, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x86, 0x00, 0xD2, 0x00, 0xEE, 0x00, 0x00, 0x00, 0x81, 0x00, 0xA0, 0x00, 0x92, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x9B, 0xCE, 0xED, 0xBA, 0xB6, 0x00, 0xF5, 0x00, 0x9F, 0xC4, 0x93, 0x00, 0xEB, 0x00,
+	0xF3, 0x00, 0x9C, 0x00, 0x00, 0x00, 0xD0, 0xE5, 0x00, 0xA7, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8D,
+	0xCC, 0xA5, 0x00, 0xF4, 0x00, 0x00, 0xB1, 0x00, 0x00, 0x8A, 0x00, 0xD6, 0x00, 0xFD, 0x00, 0x00,
+	0x00, 0x98, 0x00, 0x84, 0x00, 0x90, 0x00, 0xA9, 0xD5, 0x00, 0x00, 0x96, 0x00, 0x85, 0xC9, 0x8F,
+	0xA6, 0x00, 0x00, 0x00, 0xF6, 0x00, 0x9A, 0xCD, 0xB5, 0xF2, 0xDD, 0x00, 0x00, 0x00, 0xA2, 0x00,
+	0x9D, 0x00, 0xAB, 0x00, 0xBD, 0x00, 0x00, 0x00, 0x8B, 0xB9, 0xE2, 0x00, 0xFB, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 852
 #define _TBLDEF 1
 static
@@ -122,6 +249,26 @@ const WCHAR Tbl[] = {	/*  CP852(0x80-0xFF) to Unicode conversion table */
 	0x00AD, 0x02DD, 0x02DB, 0x02C7, 0x02D8, 0x00A7, 0x00F7, 0x00B8, 0x00B0, 0x00A8, 0x02D9, 0x0171, 0x0158, 0x0159, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP852(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x8F, 0x00, 0x89, 0xDE, 0x00, 0x00, 0x00, 0x00, 0xB0, 0x00, 0xC6, 0x00, 0x87, 0x00, 0xF4, 0x00,
+	0x00, 0xA9, 0x00, 0x00, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0xF0, 0x00, 0x00, 0x00, 0xA3, 0xA6, 0xDD,
+	0xE1, 0x8E, 0xD5, 0x00, 0xFE, 0xD0, 0xB3, 0x8D, 0x94, 0xB8, 0x00, 0xE3, 0xC1, 0x00, 0x00, 0x9F,
+	0x00, 0xCB, 0x00, 0x97, 0x9E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8C, 0xFB, 0xE0, 0x00, 0xF7, 0xC2,
+	0x00, 0x00, 0xA5, 0x00, 0x00, 0x00, 0x00, 0xF2, 0xEF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC8,
+	0xD3, 0x00, 0xF8, 0xB4, 0xA8, 0x00, 0xEC, 0x00, 0x83, 0x9C, 0x80, 0x00, 0xAA, 0x00, 0xDB, 0x00,
+	0xBE, 0x00, 0xE7, 0x00, 0x00, 0xF9, 0xC3, 0xD1, 0xDC, 0x00, 0xCA, 0xE9, 0x00, 0x88, 0x00, 0xCF,
+	0xD9, 0xAC, 0xDF, 0x00, 0x00, 0x99, 0xFD, 0x96, 0xAF, 0xF3, 0xC0, 0xFF, 0x00, 0xA1, 0xEB, 0xEA,
+	0x00, 0x92, 0x00, 0xBF, 0xB2, 0xA4, 0x00, 0x82, 0xBC, 0x8B, 0xD7, 0x00, 0x00, 0xD8, 0xDA, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x81, 0x00, 0x9B, 0xA0, 0x00, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0xBD, 0xCE, 0xE6, 0xBA, 0xB6, 0xED, 0xF5, 0x00, 0xD4, 0xC4, 0x93, 0x00, 0x00, 0x00,
+	0x9D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFC, 0x00, 0x95, 0x00, 0x00, 0x86, 0x00, 0x00,
+	0x85, 0xCC, 0xE8, 0x91, 0xF1, 0x00, 0xB1, 0xC7, 0x00, 0x00, 0x00, 0x8A, 0xD6, 0xFA, 0x00, 0xB7,
+	0x00, 0x00, 0x00, 0x84, 0x00, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA7, 0x00, 0xC9, 0xEE, 0xE5,
+	0x00, 0x00, 0x00, 0x00, 0xF6, 0xAB, 0x9A, 0xAD, 0xB5, 0xCD, 0xE4, 0x00, 0xD2, 0x00, 0xA2, 0x00,
+	0x98, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB9, 0xE2, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 855
 #define _TBLDEF 1
 static
@@ -136,6 +283,26 @@ const WCHAR Tbl[] = {	/*  CP855(0x80-0xFF) to Unicode conversion table */
 	0x00AD, 0x044B, 0x042B, 0x0437, 0x0417, 0x0448, 0x0428, 0x044D, 0x042D, 0x0449, 0x0429, 0x0447, 0x0427, 0x00A7, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP855(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0xB8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9E, 0xB0, 0xE0, 0x00, 0xA7, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0xA4, 0x00, 0xF2, 0xA1, 0x00, 0xBB, 0x00, 0xC5, 0xF0, 0xE5, 0x00, 0xFC, 0x00, 0x97, 0x00,
+	0x00, 0x00, 0x90, 0x00, 0xD6, 0xFE, 0xB3, 0xE8, 0x8F, 0x00, 0x00, 0x00, 0x88, 0xC1, 0xC6, 0x00,
+	0xDD, 0xCB, 0x87, 0x00, 0x00, 0x00, 0x84, 0x00, 0xE9, 0x00, 0xD1, 0x00, 0x00, 0x00, 0x00, 0xC2,
+	0xF7, 0xEB, 0x00, 0xF4, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF9, 0x00, 0x9D, 0x00, 0xAD, 0x00, 0xC8,
+	0x00, 0x00, 0x00, 0xB4, 0xB5, 0x9F, 0x00, 0x9B, 0x00, 0x00, 0x00, 0x96, 0x00, 0xE3, 0xDB, 0xA5,
+	0x00, 0x95, 0x00, 0x00, 0x00, 0x8E, 0xC3, 0xD4, 0xDC, 0xE6, 0x8D, 0xCA, 0x00, 0x00, 0x86, 0xCF,
+	0xBD, 0xD9, 0xD7, 0xDF, 0x83, 0x00, 0x00, 0xAF, 0x00, 0xFF, 0xA8, 0xC0, 0xC7, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0xED, 0xBF, 0xA2, 0xB2, 0xEA, 0xBC, 0x00, 0x00, 0x00, 0x00, 0xF5, 0xDA, 0xF8, 0x00,
+	0xEC, 0x00, 0x00, 0x00, 0x9A, 0xAA, 0x00, 0xFA, 0x00, 0x99, 0x00, 0x00, 0x00, 0x94, 0xAE, 0xE1,
+	0x00, 0xB6, 0x00, 0x93, 0xCE, 0xBA, 0x00, 0x8C, 0xFD, 0xD2, 0x00, 0xC4, 0xE4, 0x8B, 0x00, 0x00,
+	0x00, 0x82, 0x00, 0xB7, 0x00, 0xD5, 0x00, 0x81, 0x00, 0xEF, 0x00, 0xDE, 0x00, 0xA6, 0xBE, 0x00,
+	0xCC, 0x00, 0x00, 0x00, 0xF1, 0x00, 0xA0, 0xB1, 0xA9, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFB, 0x00,
+	0xEE, 0x00, 0xA3, 0x00, 0x00, 0x00, 0x98, 0x00, 0xE7, 0x00, 0xF6, 0x00, 0x00, 0xC9, 0x00, 0x00,
+	0x92, 0x00, 0xD8, 0x00, 0xAB, 0x00, 0x91, 0xCD, 0x00, 0x00, 0x8A, 0xD0, 0x00, 0xE2, 0x00, 0x89,
+	0x00, 0x00, 0x00, 0x80, 0x00, 0xF3, 0x00, 0xD3, 0x00, 0x85, 0xB9, 0x00, 0x00, 0x9C, 0x00, 0xAC
+};
+
 #elif _CODE_PAGE == 857
 #define _TBLDEF 1
 static
@@ -150,6 +317,26 @@ const WCHAR Tbl[] = {	/*  CP857(0x80-0xFF) to Unicode conversion table */
 	0x00AD, 0x00B1, 0x0000, 0x00BE, 0x00B6, 0x00A7, 0x00F7, 0x00B8, 0x00B0, 0x00A8, 0x00B7, 0x00B9, 0x00B3, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP857(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0x00, 0x00, 0x00, 0xE6, 0x00, 0xB0, 0x00, 0x00, 0x00, 0x87, 0xDE, 0x00, 0xF1,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xC6, 0xBB, 0xD4, 0xC5, 0x98, 0xF0, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0x00, 0x8E, 0x00, 0xB8, 0xFE, 0x00, 0xB3, 0x94, 0x00, 0x9E, 0xEA, 0xB7, 0xC1, 0xBE, 0x00, 0x00,
+	0x00, 0x95, 0xCB, 0xE8, 0x00, 0xAC, 0xAD, 0x00, 0x00, 0x00, 0x8C, 0x00, 0xE0, 0x00, 0xF7, 0xC2,
+	0x00, 0x00, 0x00, 0x00, 0x88, 0x00, 0xD8, 0x00, 0xEF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x91, 0xC8,
+	0xD3, 0x00, 0xF8, 0xB4, 0x00, 0x00, 0x00, 0x00, 0x83, 0x00, 0x80, 0x00, 0xAA, 0x00, 0xDB, 0x00,
+	0x97, 0x00, 0x00, 0xC7, 0x00, 0xF9, 0xC3, 0x00, 0xDC, 0xE4, 0xCA, 0xE9, 0x00, 0xA8, 0x00, 0xCF,
+	0xD9, 0x00, 0xDF, 0xA4, 0x00, 0x99, 0x00, 0xAF, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0xA1, 0x00, 0xE3,
+	0x00, 0xFA, 0x00, 0xA7, 0xB2, 0xBF, 0x00, 0x82, 0xBC, 0xD7, 0xFC, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x86, 0x00, 0xD2, 0x00, 0xEE, 0x00, 0x00, 0x00, 0x81, 0x00, 0xA0, 0x00, 0x92, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x9B, 0xCE, 0x00, 0xBA, 0xB6, 0x00, 0xF5, 0x00, 0x00, 0xC4, 0x93, 0x00, 0xEB, 0x00,
+	0xF3, 0x00, 0x9C, 0x00, 0x00, 0x00, 0x00, 0xE5, 0x00, 0xD0, 0x00, 0x00, 0x00, 0x00, 0x00, 0xEC,
+	0xCC, 0xA5, 0x00, 0xF4, 0x00, 0xA6, 0xB1, 0x00, 0x00, 0x8A, 0x00, 0xD6, 0x00, 0xFD, 0x00, 0x00,
+	0x00, 0xED, 0x00, 0x84, 0x00, 0x90, 0x00, 0x8D, 0xA9, 0x00, 0x00, 0x96, 0x00, 0x85, 0xC9, 0x8F,
+	0xD1, 0x00, 0x00, 0x00, 0xF6, 0x00, 0x9A, 0x9F, 0xB5, 0xCD, 0xDD, 0x00, 0x00, 0x00, 0xA2, 0x00,
+	0x9D, 0x00, 0xAB, 0x00, 0xBD, 0x00, 0x00, 0x00, 0x8B, 0xB9, 0xE2, 0x00, 0xFB, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 860
 #define _TBLDEF 1
 static
@@ -164,6 +351,26 @@ const WCHAR Tbl[] = {	/*  CP860(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP860(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x00, 0xC7, 0x00, 0x00, 0xE6, 0x00, 0xB0, 0xF3, 0x00, 0x00, 0x87, 0x98, 0x00, 0xF1,
+	0xE5, 0x00, 0x00, 0x00, 0x00, 0x84, 0xBB, 0x92, 0xC5, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0xD6, 0x00, 0x00, 0x00, 0xFE, 0x00, 0xB3, 0x00, 0xD8, 0x00, 0x00, 0x91, 0xC1, 0x00, 0x00, 0x00,
+	0x00, 0x95, 0xCB, 0x00, 0xEC, 0xAC, 0xAD, 0x00, 0x00, 0xE9, 0x00, 0xB6, 0x9F, 0x00, 0xF4, 0xC2,
+	0xFB, 0x00, 0x00, 0x00, 0x88, 0xC6, 0x00, 0x00, 0x00, 0xED, 0x00, 0xDE, 0x00, 0x00, 0xF7, 0xC8,
+	0x00, 0x00, 0xF8, 0xB4, 0x00, 0xDD, 0x00, 0x00, 0x83, 0xB7, 0x80, 0xEF, 0xAA, 0x00, 0xDB, 0xE4,
+	0x97, 0x00, 0xD5, 0x8E, 0x00, 0x00, 0xC3, 0x00, 0xDC, 0x94, 0xCA, 0x96, 0x00, 0xA8, 0x00, 0x00,
+	0xD9, 0x00, 0xDF, 0xA4, 0xD2, 0x00, 0x00, 0xAF, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0xA1, 0xB5, 0xA9,
+	0xF9, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0xE2, 0x82, 0x9E, 0xBC, 0x00, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x00, 0xD3, 0x89, 0x00, 0x00, 0x00, 0x00, 0xE8, 0x81, 0x00, 0xA0, 0xB8, 0x00, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x00, 0xCE, 0x00, 0xBA, 0x8F, 0x00, 0x00, 0x00, 0x00, 0xC4, 0x93, 0xD0, 0x9D, 0x00,
+	0x00, 0x00, 0x9C, 0xEE, 0x00, 0x00, 0xD1, 0x99, 0x00, 0xA7, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x8D,
+	0xCC, 0xA5, 0x00, 0x00, 0x00, 0x00, 0xB1, 0xF2, 0x00, 0x8A, 0xBD, 0x8B, 0x00, 0xFD, 0xE7, 0x00,
+	0xEA, 0xF0, 0x00, 0x00, 0xBE, 0x90, 0x00, 0x00, 0xE3, 0x00, 0x00, 0x00, 0x00, 0x85, 0xC9, 0x00,
+	0xA6, 0x00, 0x00, 0x00, 0xF6, 0xD7, 0x9A, 0xCD, 0x86, 0xFC, 0x00, 0x00, 0x00, 0x00, 0xA2, 0xCF,
+	0x00, 0x00, 0xAB, 0x00, 0x9B, 0xEB, 0x00, 0x00, 0x00, 0xB9, 0x8C, 0x00, 0xF5, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 861
 #define _TBLDEF 1
 static
@@ -178,6 +385,26 @@ const WCHAR Tbl[] = {	/*  CP861(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP861(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0xC7, 0x8B, 0x00, 0xE6, 0x00, 0xB0, 0xF3, 0x00, 0x00, 0x87, 0xBE, 0x00, 0xF1,
+	0xE5, 0x00, 0x00, 0x95, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0xD6, 0x8E, 0x00, 0x00, 0xFE, 0x00, 0xB3, 0x94, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x00, 0x00, 0x00,
+	0x00, 0xCB, 0x00, 0x00, 0xEC, 0xAC, 0xAD, 0x00, 0x00, 0xE9, 0x00, 0xB6, 0xA6, 0x00, 0xF4, 0xC2,
+	0xFB, 0x00, 0x00, 0x00, 0x88, 0xC6, 0x00, 0x00, 0x00, 0xED, 0x00, 0xDE, 0x00, 0x00, 0x86, 0xC8,
+	0xF7, 0x00, 0xF8, 0xB4, 0x00, 0xDD, 0x98, 0x00, 0x83, 0xB7, 0x80, 0xEF, 0xAA, 0x00, 0xDB, 0xE4,
+	0x00, 0x00, 0x8D, 0xD5, 0x00, 0xA9, 0xC3, 0x00, 0xDC, 0x00, 0xCA, 0xA7, 0x00, 0xA8, 0x00, 0x00,
+	0xD9, 0x00, 0xDF, 0x00, 0xD2, 0x99, 0x00, 0xAF, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0xA1, 0xB5, 0x00,
+	0xF9, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0xE2, 0x82, 0x9E, 0xBC, 0x00, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x00, 0xD3, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE8, 0x81, 0x00, 0xA0, 0xB8, 0x92, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x9B, 0xCE, 0x97, 0xBA, 0x00, 0x00, 0x00, 0x00, 0x9F, 0xC4, 0x93, 0xD0, 0x00, 0x00,
+	0x00, 0x00, 0x9C, 0xEE, 0x00, 0x00, 0x8C, 0xD1, 0x00, 0x00, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x00,
+	0xCC, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB1, 0xF2, 0x00, 0x8A, 0xBD, 0xA5, 0x00, 0xFD, 0xE7, 0x00,
+	0xEA, 0xF0, 0x00, 0x84, 0xD4, 0x90, 0x00, 0x00, 0xE3, 0x00, 0x00, 0x96, 0x00, 0x85, 0xC9, 0x8F,
+	0x00, 0x00, 0x00, 0x00, 0xF6, 0xD7, 0x9A, 0xCD, 0xA4, 0xFC, 0x00, 0x00, 0x00, 0x00, 0xA2, 0xCF,
+	0x9D, 0x00, 0xAB, 0x00, 0x00, 0xEB, 0x00, 0x00, 0x00, 0xB9, 0x00, 0x00, 0xF5, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 862
 #define _TBLDEF 1
 static
@@ -192,6 +419,26 @@ const WCHAR Tbl[] = {	/*  CP862(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP862(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x00, 0xC7, 0x00, 0x00, 0xE6, 0x83, 0xB0, 0xF3, 0x00, 0x00, 0xBE, 0x00, 0x00, 0x9A,
+	0xE5, 0xF1, 0x00, 0x00, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0x96, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0xD6, 0x00, 0x00, 0x92, 0xFE, 0x00, 0xB3, 0x00, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x8E, 0x9D, 0x00,
+	0x00, 0xCB, 0x00, 0x00, 0xEC, 0xAC, 0x8A, 0xAD, 0x00, 0xE9, 0x00, 0xB6, 0x00, 0x00, 0xF4, 0xC2,
+	0x86, 0xFB, 0x00, 0x00, 0x00, 0xC6, 0x00, 0x00, 0x00, 0xED, 0x82, 0xDE, 0x00, 0x00, 0xF7, 0xC8,
+	0x00, 0x00, 0x99, 0xB4, 0xF8, 0xDD, 0x00, 0x00, 0x00, 0xB7, 0xEF, 0x95, 0xAA, 0x00, 0xDB, 0xE4,
+	0x00, 0x00, 0xD5, 0x00, 0x00, 0x91, 0xA9, 0xC3, 0xDC, 0x00, 0xCA, 0x00, 0x00, 0xA8, 0x00, 0x8D,
+	0xD9, 0x00, 0xDF, 0xA4, 0xD2, 0x00, 0x00, 0xAF, 0x00, 0x89, 0xC0, 0xFF, 0x00, 0xA1, 0xB5, 0x00,
+	0xF9, 0xFA, 0x85, 0xBF, 0xB2, 0x00, 0xE2, 0xBC, 0x9E, 0x00, 0x00, 0x00, 0x81, 0xDA, 0x00, 0x00,
+	0x00, 0xD3, 0x00, 0x00, 0x98, 0x00, 0x00, 0xE8, 0x00, 0x00, 0xA0, 0xB8, 0x00, 0x00, 0x94, 0xAE,
+	0x00, 0x00, 0x00, 0xCE, 0x00, 0xBA, 0x00, 0x00, 0x90, 0x00, 0x9F, 0xC4, 0x00, 0xD0, 0x00, 0x00,
+	0x00, 0x8C, 0x9C, 0xEE, 0x00, 0x00, 0xD1, 0x00, 0x00, 0xA7, 0x00, 0x88, 0xE0, 0x00, 0x00, 0x00,
+	0xCC, 0xA5, 0x00, 0x00, 0x00, 0x84, 0xB1, 0xF2, 0x00, 0x00, 0xBD, 0x00, 0x00, 0xFD, 0xE7, 0x80,
+	0xEA, 0xF0, 0x00, 0x00, 0xD4, 0x00, 0x00, 0x97, 0xE3, 0x00, 0x00, 0x00, 0x00, 0xC9, 0x00, 0x00,
+	0x93, 0xA6, 0x00, 0x00, 0xF6, 0xD7, 0x00, 0xCD, 0x00, 0xFC, 0x8F, 0x00, 0x00, 0x00, 0xA2, 0xCF,
+	0x00, 0x00, 0xAB, 0x00, 0x8B, 0x9B, 0xEB, 0x00, 0x00, 0xB9, 0x00, 0x00, 0xF5, 0x00, 0x87, 0x00
+};
+
 #elif _CODE_PAGE == 863
 #define _TBLDEF 1
 static
@@ -206,6 +453,26 @@ const WCHAR Tbl[] = {	/*  CP863(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP863(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0xC7, 0x00, 0x00, 0xE6, 0x00, 0xB0, 0xF3, 0x00, 0x00, 0x87, 0xBE, 0x00, 0xF1,
+	0xE5, 0x00, 0x00, 0x00, 0x00, 0x00, 0xBB, 0x91, 0xC5, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0xD6, 0x00, 0x00, 0x00, 0xFE, 0x00, 0xB3, 0x00, 0xD8, 0x9E, 0x00, 0x8F, 0xC1, 0x00, 0x00, 0x00,
+	0x00, 0xCB, 0x00, 0x00, 0xEC, 0xAC, 0x00, 0x00, 0x00, 0xE9, 0x8C, 0xB6, 0x00, 0x00, 0xF4, 0xC2,
+	0xFB, 0x00, 0x00, 0x00, 0x88, 0xC6, 0x95, 0x00, 0xA1, 0xED, 0x00, 0xDE, 0x00, 0x00, 0xF7, 0xC8,
+	0x94, 0x00, 0xF8, 0xB4, 0x00, 0xDD, 0x00, 0x00, 0x83, 0xB7, 0x80, 0x00, 0xAA, 0x00, 0xDB, 0xE4,
+	0x97, 0x00, 0xD5, 0x00, 0x00, 0xA4, 0xC3, 0x00, 0xDC, 0x00, 0xCA, 0x00, 0x00, 0x00, 0x00, 0x98,
+	0xD9, 0x00, 0xDF, 0x00, 0xD2, 0x00, 0x00, 0xA5, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0x00, 0xB5, 0x00,
+	0xEF, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0xE2, 0x82, 0xBC, 0xA8, 0xA6, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x00, 0xD3, 0x92, 0x00, 0xA7, 0x00, 0x00, 0xE8, 0x81, 0x00, 0x00, 0xB8, 0x00, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x00, 0xCE, 0x00, 0xBA, 0x84, 0x00, 0x00, 0x00, 0x9F, 0xC4, 0x93, 0xD0, 0x9D, 0x00,
+	0xAD, 0x00, 0x9C, 0xEE, 0x00, 0x00, 0xD1, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x8D,
+	0xCC, 0x00, 0x00, 0x86, 0x00, 0x00, 0xA9, 0xB1, 0xF2, 0x8A, 0xBD, 0x00, 0x00, 0xFD, 0xE7, 0x00,
+	0xEA, 0xF0, 0x00, 0x00, 0xD4, 0x90, 0x00, 0x00, 0xE3, 0x00, 0x00, 0x96, 0x00, 0x85, 0xC9, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xF6, 0xD7, 0x9A, 0x8E, 0xCD, 0xFC, 0xA0, 0x00, 0x00, 0x00, 0xA2, 0xCF,
+	0x00, 0x00, 0xAB, 0x00, 0x9B, 0xEB, 0x00, 0x00, 0x8B, 0xB9, 0x99, 0x00, 0xF5, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 864
 #define _TBLDEF 1
 static
@@ -220,6 +487,26 @@ const WCHAR Tbl[] = {	/*  CP864(0x80-0xFF) to Unicode conversion table */
 	0xFE7D, 0x0651, 0xFEE5, 0xFEE9, 0xFEEC, 0xFEF0, 0xFEF2, 0xFED0, 0xFED5, 0xFEF5, 0xFEF6, 0xFEDD, 0xFED9, 0xFEF1, 0x25A0, 0x0000
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP864(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0xE4, 0x00, 0x00, 0x00, 0xCF, 0x00, 0xA8, 0x00, 0xFA, 0x00, 0xE3, 0x00, 0x00, 0x00, 0x93,
+	0xAF, 0x00, 0x00, 0xF6, 0x00, 0xE2, 0x00, 0x00, 0x87, 0xA1, 0xAE, 0xB9, 0x00, 0x00, 0xE1, 0x00,
+	0x00, 0x00, 0xAD, 0xB5, 0xA2, 0xFE, 0x86, 0x00, 0xDA, 0x00, 0x00, 0x00, 0x8B, 0xAB, 0xB1, 0x00,
+	0x00, 0x00, 0xD9, 0xDE, 0x91, 0x95, 0xAA, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA7, 0xAC, 0x83, 0x89,
+	0xC8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x92, 0xC7, 0xF9, 0x00, 0x00, 0x96, 0xBF,
+	0xD6, 0x00, 0x80, 0x88, 0xF1, 0xFD, 0x00, 0x00, 0xBB, 0xD5, 0x00, 0x00, 0xB8, 0xC4, 0xDC, 0xE8,
+	0x00, 0x00, 0x00, 0xD4, 0x00, 0xB4, 0x8A, 0xC2, 0x00, 0xF3, 0x00, 0xED, 0xD3, 0x00, 0x00, 0xA4,
+	0x8F, 0xB0, 0xF0, 0xF2, 0xC5, 0x00, 0xD2, 0x98, 0x00, 0xA0, 0x8E, 0x90, 0x9E, 0xEF, 0x00, 0x00,
+	0x82, 0x81, 0xD0, 0x8C, 0x9A, 0x00, 0xFB, 0x00, 0x00, 0x00, 0xCE, 0x00, 0x00, 0x8D, 0x00, 0x00,
+	0xFC, 0x00, 0x00, 0x00, 0xCD, 0x00, 0x00, 0x00, 0xF5, 0xF8, 0x00, 0x00, 0x00, 0xCC, 0x97, 0xA5,
+	0xB7, 0xF4, 0x00, 0xBA, 0x00, 0x00, 0x00, 0xCB, 0xB3, 0xC1, 0x00, 0x85, 0x00, 0xEE, 0x00, 0x00,
+	0x00, 0xCA, 0xA3, 0x00, 0x00, 0x00, 0x00, 0xDF, 0x00, 0x00, 0x00, 0xC9, 0x00, 0x9D, 0xE0, 0x00,
+	0x00, 0xD8, 0x00, 0x00, 0xA9, 0x00, 0x84, 0x99, 0x00, 0x00, 0xD7, 0x00, 0x00, 0x00, 0xC6, 0x00,
+	0xEA, 0x00, 0x00, 0x00, 0xEB, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE9, 0x00, 0x00, 0x00, 0xBE, 0x00,
+	0xB6, 0x00, 0xC3, 0x00, 0xDD, 0xE7, 0xF7, 0x00, 0xBD, 0x00, 0xB2, 0xDB, 0x00, 0x00, 0xE6, 0xEC,
+	0x00, 0xBC, 0x94, 0x00, 0xC0, 0x00, 0x00, 0xE5, 0x00, 0x00, 0x00, 0xD1, 0x00, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 865
 #define _TBLDEF 1
 static
@@ -234,6 +521,26 @@ const WCHAR Tbl[] = {	/*  CP865(0x80-0xFF) to Unicode conversion table */
 	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP865(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x00, 0x89, 0xC7, 0x00, 0x00, 0xE6, 0x00, 0xB0, 0xF3, 0x00, 0x00, 0x87, 0x00, 0x00, 0xF1,
+	0xE5, 0x00, 0x00, 0x00, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0x00, 0x00, 0x00, 0xA3, 0x00, 0xE1,
+	0xD6, 0x8E, 0x00, 0x00, 0xFE, 0x00, 0xB3, 0x94, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x00, 0x00, 0x00,
+	0x00, 0x95, 0xCB, 0x00, 0xEC, 0xAC, 0xAD, 0x00, 0x00, 0xE9, 0x8C, 0xB6, 0x00, 0x00, 0xF4, 0xC2,
+	0xFB, 0x00, 0x00, 0x00, 0x88, 0xC6, 0x00, 0x00, 0x00, 0xED, 0x00, 0xDE, 0x00, 0x00, 0x91, 0xC8,
+	0xF7, 0x00, 0xF8, 0xB4, 0x00, 0xDD, 0x00, 0x00, 0x83, 0xB7, 0x80, 0xEF, 0xAA, 0x00, 0xDB, 0xE4,
+	0x97, 0x00, 0xD5, 0x00, 0x00, 0xA9, 0xC3, 0x00, 0xDC, 0x00, 0xCA, 0x00, 0x00, 0xA8, 0x00, 0xAF,
+	0xD9, 0x00, 0xDF, 0xA4, 0xD2, 0x99, 0x00, 0x00, 0x00, 0xFF, 0xC0, 0x00, 0x00, 0xA1, 0xB5, 0x00,
+	0xF9, 0xFA, 0x00, 0xBF, 0xB2, 0x00, 0xE2, 0x82, 0x9E, 0xBC, 0x00, 0x00, 0x00, 0xDA, 0x00, 0x00,
+	0x86, 0xD3, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE8, 0x81, 0x00, 0xA0, 0xB8, 0x92, 0x00, 0xAE, 0x00,
+	0x00, 0x00, 0x9B, 0xCE, 0x00, 0xBA, 0x00, 0x00, 0x00, 0x00, 0x9F, 0xC4, 0x93, 0xD0, 0x00, 0x00,
+	0x00, 0x00, 0x9C, 0xEE, 0x00, 0x00, 0xD1, 0x00, 0x00, 0xA7, 0x00, 0x00, 0xE0, 0x00, 0x00, 0x8D,
+	0xCC, 0xA5, 0x00, 0x00, 0x00, 0x00, 0xB1, 0xF2, 0x00, 0x8A, 0xBD, 0x00, 0x00, 0xFD, 0xE7, 0x00,
+	0xEA, 0x98, 0xF0, 0x84, 0xBE, 0x00, 0x00, 0x00, 0xE3, 0x00, 0x00, 0x96, 0x00, 0x85, 0xC9, 0x8F,
+	0xA6, 0x00, 0x00, 0x00, 0xF6, 0xD7, 0x9A, 0xCD, 0x00, 0xFC, 0x00, 0x00, 0x00, 0x00, 0xA2, 0xCF,
+	0x9D, 0x00, 0xAB, 0x00, 0x00, 0xEB, 0x00, 0x00, 0x8B, 0xB9, 0x00, 0x00, 0xF5, 0x00, 0x00, 0x00
+};
+
 #elif _CODE_PAGE == 866
 #define _TBLDEF 1
 static
@@ -248,6 +555,26 @@ const WCHAR Tbl[] = {	/*  CP866(0x80-0xFF) to Unicode conversion table */
 	0x0401, 0x0451, 0x0404, 0x0454, 0x0407, 0x0457, 0x040E, 0x045E, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x2116, 0x00A4, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP866(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0x88, 0x00, 0xC7, 0x00, 0x00, 0x00, 0xEA, 0xB0, 0x9F, 0x00, 0x84, 0xBE, 0x00, 0x00, 0x00,
+	0x00, 0xE6, 0x00, 0x9B, 0x80, 0x00, 0xBB, 0x00, 0xC5, 0x00, 0xE2, 0x00, 0x97, 0x00, 0x00, 0x00,
+	0xD6, 0x00, 0x00, 0x00, 0xAE, 0xFE, 0x93, 0xB3, 0xD8, 0x00, 0x00, 0x00, 0xC1, 0x00, 0xAA, 0x00,
+	0x8F, 0xCB, 0xF2, 0x00, 0x00, 0x00, 0xF1, 0x00, 0xA6, 0x00, 0x8B, 0xB6, 0x00, 0x00, 0xFB, 0xC2,
+	0xED, 0xA2, 0x00, 0x87, 0x00, 0xC6, 0x00, 0x00, 0x00, 0xE9, 0x00, 0x9E, 0xDE, 0x83, 0x00, 0xC8,
+	0x00, 0x00, 0xF8, 0xB4, 0xE5, 0x9A, 0xDD, 0x00, 0x00, 0xB7, 0x00, 0x00, 0x00, 0xE1, 0xDB, 0x96,
+	0x00, 0x00, 0xD5, 0x00, 0x00, 0x00, 0xC3, 0xAD, 0x92, 0xDC, 0xCA, 0xF4, 0x00, 0x00, 0xF3, 0xFD,
+	0xA9, 0xD9, 0x8E, 0xDF, 0xD2, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xA5, 0xC0, 0x8A, 0x00, 0xB5, 0x00,
+	0xF9, 0xFA, 0xEC, 0xBF, 0xA1, 0xB2, 0x86, 0xBC, 0x00, 0x00, 0x00, 0x00, 0xE8, 0xDA, 0x9D, 0x00,
+	0x82, 0xD3, 0x00, 0x00, 0x00, 0xE4, 0x00, 0x99, 0x00, 0xF6, 0x00, 0xB8, 0x00, 0x00, 0x00, 0xE0,
+	0x00, 0x95, 0x00, 0xCE, 0x00, 0xBA, 0x00, 0xF5, 0x00, 0xAC, 0x00, 0x91, 0xC4, 0xD0, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xA8, 0x00, 0x8D, 0xD1, 0x00, 0x00, 0xFC, 0x00, 0xEF, 0x00, 0xA4, 0x89, 0x00,
+	0xCC, 0x00, 0x00, 0x00, 0xEB, 0x00, 0xA0, 0xB1, 0x85, 0x00, 0xBD, 0x00, 0x00, 0x00, 0xE7, 0x00,
+	0x9C, 0x00, 0x81, 0x00, 0xD4, 0x00, 0xF7, 0x00, 0xE3, 0x00, 0x98, 0x00, 0x00, 0xC9, 0x00, 0x00,
+	0x00, 0x00, 0xAF, 0x00, 0x94, 0xD7, 0x00, 0xCD, 0x00, 0x00, 0x00, 0xAB, 0x00, 0x90, 0x00, 0xCF,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xA7, 0x00, 0x8C, 0x00, 0xB9, 0xF0, 0x00, 0x00, 0xEE, 0x00, 0xA3
+};
+
 #elif _CODE_PAGE == 869
 #define _TBLDEF 1
 static
@@ -262,6 +589,26 @@ const WCHAR Tbl[] = {	/*  CP869(0x80-0xFF) to Unicode conversion table */
 	0x00AD, 0x00B1, 0x03C5, 0x03C6, 0x03C7, 0x00A7, 0x03C8, 0x0385, 0x00B0, 0x00A8, 0x03C9, 0x03CB, 0x03B0, 0x03CE, 0x25A0, 0x00A0
 };
 
+static
+const BYTE Rev[] = {	/*  Unicode to CP869(0x80-0xFF) hash table, indexed by HASH_OEM(), 0:empty */
+	0x00, 0xA8, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF4, 0xB0, 0x9B, 0xA4, 0x00, 0x00, 0x00, 0x00, 0xF1,
+	0xEC, 0x00, 0xD4, 0x00, 0x00, 0x00, 0xBB, 0x00, 0xC5, 0xF0, 0xE9, 0x00, 0xD0, 0x00, 0x8F, 0x00,
+	0xC6, 0x00, 0x00, 0x97, 0xE5, 0xFE, 0xB3, 0x00, 0xF7, 0x00, 0x00, 0x00, 0xC1, 0x00, 0xE1, 0x00,
+	0xB7, 0xCB, 0x00, 0x00, 0x00, 0x00, 0xFD, 0xD8, 0x00, 0xAC, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA0,
+	0xC2, 0x9F, 0x00, 0xA7, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF3, 0x00, 0x96, 0x00, 0xA1, 0x00, 0xC8,
+	0x00, 0x00, 0xF8, 0xB4, 0xED, 0xD3, 0x00, 0x92, 0x00, 0x00, 0x00, 0x00, 0x89, 0xE8, 0xDB, 0xCF,
+	0x8D, 0x00, 0x8C, 0x00, 0x00, 0xF9, 0xC3, 0xE4, 0xBE, 0xDC, 0xCA, 0xEF, 0x8E, 0x00, 0x00, 0x00,
+	0xD9, 0xE0, 0xB6, 0xDF, 0x00, 0x00, 0x00, 0xAF, 0xA3, 0xFF, 0xC0, 0xD7, 0xAA, 0x00, 0x00, 0x00,
+	0x00, 0x80, 0xFA, 0xBF, 0x9E, 0xB2, 0xA6, 0xBC, 0x00, 0x00, 0x9A, 0x00, 0xF2, 0x91, 0xDA, 0x98,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xEB, 0x00, 0xD2, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xAE, 0xE7,
+	0x00, 0x00, 0x00, 0xCE, 0x00, 0x8B, 0xBA, 0x00, 0xF5, 0xE3, 0x00, 0xBD, 0xC4, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x9C, 0xDE, 0x00, 0xB5, 0x00, 0x00, 0x00, 0x00, 0xA2, 0x00, 0xD6, 0x00, 0xA9, 0x00,
+	0xCC, 0x00, 0x00, 0x00, 0xF6, 0x00, 0x9D, 0xB1, 0xA5, 0x00, 0x00, 0x00, 0x00, 0x99, 0xEE, 0x00,
+	0xD5, 0x00, 0x95, 0x00, 0x00, 0x00, 0x00, 0x00, 0xEA, 0x00, 0xD1, 0x00, 0x90, 0xC9, 0x00, 0x00,
+	0x00, 0x00, 0xE6, 0xC7, 0x00, 0x86, 0x00, 0xCD, 0x00, 0x00, 0x8A, 0xE2, 0x00, 0xB8, 0x00, 0x00,
+	0x00, 0x00, 0xAB, 0x00, 0x00, 0xDD, 0x00, 0xAD, 0x00, 0xB9, 0x00, 0x00, 0x00, 0xFB, 0x00, 0xFC
+};
+
 #endif
 
 
@@ -278,6 +625,7 @@ WCHAR ff_convert (	/* Converted character, Returns zero on error */
 )
 {
 	WCHAR c;
+	UINT i;
 
 
 	if (chr < 0x80) {	/* ASCII */
@@ -288,10 +636,9 @@ WCHAR ff_convert (	/* Converted character, Returns zero on error */
 			c = (chr >= 0x100) ? 0 : Tbl[chr - 0x80];
 
 		} else {		/* Unicode to OEM code */
-			for (c = 0; c < 0x80; c++) {
-				if (chr == Tbl[c]) break;
+			for (i = HASH_OEM(chr); (c = Rev[i]) != 0; i = (i + 1) & 0xFF) {
+				if (chr == Tbl[c - 0x80]) break;
 			}
-			c = (c + 0x80) & 0xFF;
 		}
 	}
 
@@ -327,20 +674,85 @@ WCHAR ff_wtoupper (	/* Returns upper converted character */
 									0x2160,0x2161,0x2162,0x2163,0x2164,0x2165,0x2166,0x2167,0x2168,0x2169,0x216A,0x216B,0x216C,0x216D,0x216E,0x216F,
 									0xFF21,0xFF22,0xFF23,0xFF24,0xFF25,0xFF26,0xFF27,0xFF28,0xFF29,0xFF2A,0xFF2B,0xFF2C,0xFF2D,0xFF2E,0xFF2F,0xFF30,0xFF31,0xFF32,0xFF33,0xFF34,0xFF35,0xFF36,0xFF37,0xFF38,0xFF39,0xFF3A
 	};
-	UINT i, n, hi, li;
+	static const WORD idx[] = {	/* Hash table of lower[] (index + 1), indexed by HASH_UPR(), 0:empty */
+		0, 375, 217, 87, 216, 0, 374, 215, 0, 86, 214, 0, 373, 213, 85, 0,
+		0, 372, 0, 0, 84, 212, 0, 371, 211, 83, 0, 210, 370, 209, 0, 82,
+		208, 0, 369, 207, 81, 0, 206, 368, 205, 0, 80, 204, 0, 367, 203, 79,
+		0, 202, 0, 201, 366, 78, 200, 0, 365, 199, 77, 0, 198, 0, 364, 197,
+		76, 196, 0, 363, 195, 75, 0, 194, 0, 362, 193, 74, 192, 0, 361, 191,
+		73, 0, 190, 0, 360, 189, 72, 188, 0, 359, 187, 71, 0, 186, 0, 358,
+		185, 70, 184, 0, 357, 183, 0, 69, 182, 0, 356, 181, 68, 0, 0, 355,
+		0, 0, 0, 0, 67, 354, 0, 0, 0, 0, 66, 353, 0, 0, 0, 65,
+		352, 0, 0, 0, 0, 64, 351, 0, 0, 0, 0, 63, 350, 0, 0, 0,
+		62, 349, 0, 0, 0, 0, 61, 348, 0, 0, 0, 60, 347, 0, 0, 0,
+		0, 346, 0, 59, 0, 0, 0, 345, 0, 58, 0, 0, 344, 0, 57, 0,
+		0, 0, 343, 0, 56, 0, 0, 342, 0, 327, 55, 0, 326, 341, 325, 54,
+		0, 324, 340, 0, 323, 53, 0, 322, 339, 0, 52, 321, 320, 338, 0, 319,
+		51, 0, 318, 337, 0, 50, 317, 316, 336, 0, 315, 49, 0, 314, 335, 0,
+		48, 313, 312, 0, 334, 311, 47, 0, 310, 333, 0, 46, 309, 308, 0, 332,
+		307, 45, 0, 306, 331, 0, 44, 305, 0, 304, 330, 303, 43, 0, 302, 329,
+		0, 42, 301, 0, 300, 328, 299, 41, 0, 298, 0, 0, 40, 297, 0, 296,
+		0, 295, 39, 0, 294, 0, 0, 293, 38, 0, 292, 0, 291, 37, 0, 290,
+		0, 0, 0, 36, 0, 0, 0, 0, 35, 0, 180, 0, 0, 0, 34, 179,
+		0, 0, 0, 33, 0, 178, 0, 0, 0, 32, 177, 0, 0, 0, 31, 0,
+		176, 30, 0, 0, 29, 0, 0, 28, 0, 27, 0, 0, 26, 0, 0, 25,
+		0, 0, 24, 0, 0, 0, 0, 23, 0, 0, 22, 0, 0, 21, 0, 20,
+		0, 0, 19, 0, 0, 18, 0, 0, 17, 0, 0, 16, 0, 15, 0, 0,
+		14, 0, 0, 13, 0, 0, 12, 0, 11, 0, 175, 10, 0, 174, 9, 173,
+		0, 8, 172, 7, 0, 171, 6, 0, 170, 5, 169, 0, 4, 168, 3, 0,
+		167, 2, 0, 166, 1, 165, 0, 0, 164, 0, 0, 0, 0, 0, 163, 0,
+		0, 162, 0, 161, 0, 0, 160, 0, 0, 159, 0, 0, 158, 0, 157, 0,
+		0, 156, 0, 0, 155, 0, 0, 154, 0, 153, 0, 0, 152, 0, 0, 151,
+		0, 0, 150, 0, 149, 0, 0, 148, 0, 0, 147, 494, 0, 493, 0, 0,
+		492, 0, 0, 491, 0, 0, 490, 0, 489, 0, 0, 488, 0, 0, 487, 0,
+		0, 486, 0, 485, 0, 0, 484, 0, 0, 483, 0, 0, 482, 0, 0, 481,
+		0, 480, 0, 0, 479, 0, 0, 478, 0, 0, 477, 0, 476, 0, 0, 475,
+		0, 0, 474, 0, 0, 473, 0, 472, 0, 0, 471, 0, 0, 470, 0, 0,
+		469, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 146, 0, 0, 0, 0, 145, 0, 289,
+		0, 0, 0, 144, 0, 0, 0, 0, 143, 0, 288, 0, 0, 0, 142, 287,
+		0, 0, 0, 0, 141, 286, 0, 452, 0, 140, 0, 285, 451, 0, 0, 139,
+		284, 0, 450, 0, 138, 0, 283, 449, 0, 0, 137, 282, 0, 448, 0, 136,
+		0, 281, 0, 447, 0, 135, 280, 0, 446, 0, 134, 0, 279, 0, 445, 0,
+		133, 278, 0, 444, 0, 132, 0, 277, 0, 443, 0, 0, 276, 0, 442, 0,
+		0, 0, 275, 0, 441, 0, 131, 274, 0, 440, 0, 130, 0, 273, 0, 439,
+		0, 0, 272, 0, 438, 0, 0, 129, 271, 0, 437, 0, 128, 270, 0, 436,
+		0, 0, 127, 0, 0, 435, 0, 126, 0, 0, 434, 0, 0, 125, 0, 0,
+		433, 0, 124, 0, 0, 432, 269, 0, 123, 0, 0, 431, 0, 122, 0, 0,
+		0, 268, 430, 121, 0, 0, 429, 267, 120, 0, 0, 119, 428, 0, 0, 266,
+		0, 118, 427, 0, 0, 265, 117, 426, 0, 0, 264, 0, 116, 425, 0, 0,
+		263, 115, 424, 0, 0, 262, 0, 114, 423, 0, 0, 261, 113, 422, 0, 0,
+		260, 0, 112, 421, 0, 0, 259, 111, 420, 0, 0, 0, 258, 419, 0, 0,
+		110, 257, 0, 418, 0, 0, 0, 256, 109, 417, 0, 0, 255, 0, 416, 0,
+		0, 0, 254, 0, 415, 0, 0, 253, 0, 414, 0, 0, 0, 252, 0, 413,
+		0, 108, 251, 0, 412, 0, 0, 0, 250, 0, 411, 0, 107, 249, 0, 410,
+		0, 0, 0, 248, 106, 409, 0, 0, 247, 0, 105, 408, 0, 0, 246, 0,
+		407, 0, 0, 245, 0, 104, 406, 0, 0, 244, 0, 405, 468, 103, 243, 467,
+		404, 0, 466, 0, 0, 465, 403, 464, 0, 0, 463, 102, 402, 462, 0, 0,
+		461, 401, 460, 0, 0, 459, 400, 0, 458, 101, 0, 457, 399, 456, 100, 0,
+		455, 0, 398, 454, 0, 0, 453, 397, 0, 0, 0, 242, 0, 396, 0, 0,
+		241, 0, 395, 0, 99, 0, 240, 0, 394, 0, 0, 239, 0, 393, 0, 0,
+		0, 238, 0, 392, 0, 0, 237, 0, 98, 391, 0, 0, 236, 0, 390, 0,
+		0, 235, 0, 389, 0, 0, 0, 234, 97, 388, 0, 0, 0, 233, 387, 0,
+		0, 0, 232, 96, 386, 0, 0, 0, 231, 385, 0, 0, 95, 230, 0, 384,
+		0, 94, 0, 229, 0, 383, 0, 0, 228, 0, 382, 0, 0, 0, 227, 93,
+		381, 0, 0, 226, 0, 92, 380, 0, 0, 225, 91, 379, 224, 0, 0, 0,
+		378, 223, 90, 0, 222, 0, 377, 221, 89, 220, 0, 376, 219, 88, 0, 218
+	};
+	UINT i, n;
 
 
 	if (chr < 0x80) {	/* ASCII characters (acceleration) */
 		if (chr >= 0x61 && chr <= 0x7A) chr -= 0x20;
 
-	} else {			/* Non ASCII characters (table search) */
-		n = 12; li = 0; hi = sizeof lower / sizeof lower[0];
-		do {
-			i = li + (hi - li) / 2;
-			if (chr == lower[i]) break;
-			if (chr > lower[i]) li = i; else hi = i;
-		} while (--n);
-		if (n) chr = upper[i];
+	} else {			/* Non ASCII characters (hash table search) */
+		for (i = HASH_UPR(chr); (n = idx[i]) != 0; i = (i + 1) & 0x3FF) {
+			if (chr == lower[n - 1]) {
+				chr = upper[n - 1];
+				break;
+			}
+		}
 	}
 
 	return chr;
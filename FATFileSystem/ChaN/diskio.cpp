@@ -108,7 +108,20 @@ DRESULT disk_ioctl (
                 }
             }
         case GET_BLOCK_SIZE:
-            *((DWORD*)buff) = 1; // default when not known
+            if(FATFileSystem::_ffs[pdrv] == NULL) {
+                return RES_NOTRDY;
+            }
+            *((DWORD*)buff) = FATFileSystem::_ffs[pdrv]->disk_block_size(); // erase block in sectors, 1 when not known
+            return RES_OK;
+        case CTRL_TRIM:
+            if(FATFileSystem::_ffs[pdrv] == NULL) {
+                return RES_NOTRDY;
+            } else {
+                DWORD *range = (DWORD*)buff; // first and last sector
+                if(FATFileSystem::_ffs[pdrv]->disk_trim(range[0], range[1] - range[0] + 1)) {
+                    return RES_ERROR;
+                }
+            }
             return RES_OK;
 
     }
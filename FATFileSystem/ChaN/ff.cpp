@@ -475,7 +475,7 @@ static WCHAR LfnBuf[_MAX_LFN + 1];
 #define	FREE_BUF()
 #elif _USE_LFN == 3 		/* LFN feature with dynamic working buffer on the heap */
 #define	DEFINE_NAMEBUF		BYTE sfn[12]; WCHAR *lfn
-#define INIT_BUF(dobj)		{ lfn = ff_memalloc((_MAX_LFN + 1) * 2); if (!lfn) LEAVE_FF((dobj).fs, FR_NOT_ENOUGH_CORE); (dobj).lfn = lfn; (dobj).fn = sfn; }
+#define INIT_BUF(dobj)		{ lfn = (WCHAR*)ff_memalloc((_MAX_LFN + 1) * 2); if (!lfn) LEAVE_FF((dobj).fs, FR_NOT_ENOUGH_CORE); (dobj).lfn = lfn; (dobj).fn = sfn; }
 #define	FREE_BUF()			ff_memfree(lfn)
 #else
 #error Wrong _USE_LFN setting
@@ -864,6 +864,33 @@ DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x0FFFFFFF:Cluste
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Free cluster map - Mark a cluster group in use or not                 */
+/*-----------------------------------------------------------------------*/
+#if _FS_FREEMAP && !_FS_READONLY
+static
+void fmap_put (
+	FATFS* fs,		/* File system object */
+	DWORD clst,		/* Cluster# in the group to be marked */
+	int full		/* 1:All clusters in the group are in use, 0:Group may have a free cluster */
+)
+{
+	DWORD grp = clst >> fs->fmap_gs;
+
+
+	if (full) {
+		fs->fmap[grp / 8] |= (BYTE)(1 << (grp % 8));
+	} else {
+		fs->fmap[grp / 8] &= (BYTE)~(1 << (grp % 8));
+	}
+}
+
+#define FMAP_FULL(fs, clst)	((fs)->fmap[((clst) >> (fs)->fmap_gs) / 8] & (1 << (((clst) >> (fs)->fmap_gs) % 8)))
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* FAT access - Change value of a FAT entry                              */
 /*-----------------------------------------------------------------------*/
@@ -920,6 +947,15 @@ FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 		default :
 			res = FR_INT_ERR;
 		}
+#if _FS_FREEMAP
+		if (res == FR_OK) {
+			if ((val & 0x0FFFFFFF) == 0) {
+				fmap_put(fs, clst, 0);		/* The group has a free cluster */
+			} else if (fs->fmap_gs == 0) {
+				fmap_put(fs, clst, 1);		/* One cluster per group: it is in use */
+			}
+		}
+#endif
 	}
 
 	return res;
@@ -982,6 +1018,68 @@ FRESULT remove_chain (	/* FR_OK(0):succeeded, !=0:error */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Find a run of free clusters                            */
+/*-----------------------------------------------------------------------*/
+#if !_FS_READONLY && (_FS_FREEMAP || _USE_EXPAND)
+static
+DWORD find_free (	/* 0:No free run, 1:Internal error, 0xFFFFFFFF:Disk error, >=2:Top of the run */
+	FATFS* fs,		/* File system object */
+	DWORD scl,		/* Cluster# to start the search after */
+	DWORD ncl		/* Number of contiguous free clusters needed */
+)
+{
+	DWORD clst, top, len, cnt, stat;
+#if _FS_FREEMAP
+	DWORD gtop, gend;
+	int whole = 0, used = 0;
+#endif
+
+
+	clst = scl; top = len = 0;
+	for (cnt = fs->n_fatent - 2; cnt; cnt--) {
+		clst++;							/* Next cluster */
+		if (clst >= fs->n_fatent) {		/* Check wrap around */
+			clst = 2; len = 0;
+		}
+#if _FS_FREEMAP
+		gtop = clst >> fs->fmap_gs << fs->fmap_gs;		/* First cluster of the group */
+		gend = gtop + (1UL << fs->fmap_gs);				/* First cluster of the next group */
+		if (gtop < 2) gtop = 2;
+		if (gend > fs->n_fatent) gend = fs->n_fatent;
+		if (FMAP_FULL(fs, clst)) {		/* Skip the group without reading the FAT */
+			if (gend - clst > cnt) break;
+			cnt -= gend - clst - 1;
+			clst = gend - 1; len = 0;
+			continue;
+		}
+		if (clst == gtop) whole = used = 1;	/* The group is to be scanned from its top */
+#endif
+		stat = get_fat(fs, clst);		/* Get the cluster status */
+		if (stat == 0xFFFFFFFF || stat == 1) return stat;	/* An error occurred */
+		if (stat == 0) {				/* Found a free cluster */
+#if _FS_FREEMAP
+			used = 0;
+#endif
+			if (!len) top = clst;
+			if (++len >= ncl) return top;
+		} else {
+			len = 0;
+		}
+#if _FS_FREEMAP
+		if (clst + 1 == gend && whole && used) {
+			fmap_put(fs, clst, 1);		/* Every cluster in the group is in use */
+		}
+#endif
+	}
+
+	return 0;
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* FAT handling - Stretch or Create a cluster chain                      */
 /*-----------------------------------------------------------------------*/
@@ -1008,6 +1106,10 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 		scl = clst;
 	}
 
+#if _FS_FREEMAP
+	ncl = find_free(fs, scl, 1);		/* Find a free cluster skipping the groups in use */
+	if (ncl < 2 || ncl == 0xFFFFFFFF) return ncl;
+#else
 	ncl = scl;				/* Start cluster */
 	for (;;) {
 		ncl++;							/* Next cluster */
@@ -1021,6 +1123,7 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 			return cs;
 		if (ncl == scl) return 0;		/* No free cluster */
 	}
+#endif
 
 	res = put_fat(fs, ncl, 0x0FFFFFFF);	/* Mark the new cluster "last link" */
 	if (res == FR_OK && clst != 0) {
@@ -1450,6 +1553,87 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory lookup cache - Hash, look up and update                     */
+/*-----------------------------------------------------------------------*/
+#if _FS_DCACHE
+static
+DWORD dcache_hash (	/* Hash of the directory and the object name */
+	FATFS_DIR* dp		/* Directory object with the name to be found */
+)
+{
+	DWORD h = 2166136261UL ^ dp->sclust;	/* FNV-1a */
+	UINT i;
+
+
+#if _USE_LFN
+	if (dp->lfn) {		/* Long name, case insensitive as in cmp_lfn() */
+		for (i = 0; dp->lfn[i]; i++) h = (h ^ ff_wtoupper(dp->lfn[i])) * 16777619UL;
+		return h;
+	}
+#endif
+	for (i = 0; i < 11; i++) h = (h ^ dp->fn[i]) * 16777619UL;
+	return h;
+}
+
+
+static
+UINT dcache_seek (	/* 0:Miss, >0:Number of entries to check from the cached top entry */
+	FATFS_DIR* dp,		/* Directory object to be moved to the cached entry */
+	DWORD hash			/* Hash from dcache_hash() */
+)
+{
+	DCENT *ce = &dp->fs->dcache[hash & (_FS_DCACHE - 1)];
+
+
+	if (ce->index == 0xFFFF || ce->hash != hash || ce->dclust != dp->sclust) return 0;
+	dp->index = ce->index;
+	dp->clust = ce->clust;
+	dp->sect = ce->sect;
+	dp->dir = dp->fs->win + (ce->index % (SS(dp->fs) / SZ_DIRE)) * SZ_DIRE;
+	return ce->nent;
+}
+
+
+static
+void dcache_put (
+	FATFS_DIR* dp,		/* Directory object pointing the SFN entry of the object found */
+	DWORD hash,			/* Hash from dcache_hash() */
+	UINT idx,			/* Index of the top entry of the object */
+	DWORD clst,			/* Cluster# of the top entry */
+	DWORD sect			/* Sector# of the top entry */
+)
+{
+	DCENT *ce = &dp->fs->dcache[hash & (_FS_DCACHE - 1)];
+
+
+	ce->dclust = dp->sclust;
+	ce->hash = hash;
+	ce->clust = clst;
+	ce->sect = sect;
+	ce->index = (WORD)idx;
+	ce->nent = (WORD)(dp->index - idx + 1);
+}
+
+
+static
+void dcache_drop (
+	FATFS* fs,			/* File system object */
+	DWORD dclst			/* Directory whose entries are to be dropped (0xFFFFFFFF:All) */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_DCACHE; i++) {
+		if (dclst == 0xFFFFFFFF || fs->dcache[i].dclust == dclst) fs->dcache[i].index = 0xFFFF;
+	}
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
@@ -1464,9 +1648,24 @@ FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #if _USE_LFN
 	BYTE a, ord, sum;
 #endif
-
+#if _FS_DCACHE
+	DWORD hash, tclst = 0, tsect = 0;
+	UINT nent;
+	BYTE hint;
+
+	hash = dcache_hash(dp);
+	nent = dcache_seek(dp, hash);	/* Go to the cached entry if any */
+	hint = nent ? 1 : 0;
+	if (!hint) {
+		dp->fs->dc_miss++;
+		res = dir_sdi(dp, 0);		/* Rewind directory object */
+		if (res != FR_OK) return res;
+	}
+	for (;;) {
+#else
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
+#endif
 
 #if _USE_LFN
 	ord = sum = 0xFF; dp->lfn_idx = 0xFFFF;	/* Reset LFN sequence */
@@ -1488,6 +1687,9 @@ FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 						sum = dir[LDIR_Chksum];
 						c &= ~LLEF; ord = c;	/* LFN start order */
 						dp->lfn_idx = dp->index;	/* Start index of LFN */
+#if _FS_DCACHE
+						tclst = dp->clust; tsect = dp->sect;
+#endif
 					}
 					/* Check validity of the LFN entry and compare it with given name */
 					ord = (c == ord && sum == dir[LDIR_Chksum] && cmp_lfn(dp->lfn, dir)) ? ord - 1 : 0xFF;
@@ -1501,10 +1703,35 @@ FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #else		/* Non LFN configuration */
 		if (!(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dp->fn, 11)) /* Is it a valid entry? */
 			break;
+#endif
+#if _FS_DCACHE
+		if (nent && !--nent) { res = FR_NO_FILE; break; }	/* Not at the cached location */
 #endif
 		res = dir_next(dp, 0);		/* Next entry */
 	} while (res == FR_OK);
 
+#if _FS_DCACHE
+		if (res == FR_OK) {			/* Found */
+			if (hint) {
+				dp->fs->dc_hit++;
+			} else {
+#if _USE_LFN
+				if (dp->lfn_idx != 0xFFFF) {
+					dcache_put(dp, hash, dp->lfn_idx, tclst, tsect);
+				} else
+#endif
+				dcache_put(dp, hash, dp->index, dp->clust, dp->sect);
+			}
+			break;
+		}
+		if (!hint || res != FR_NO_FILE) break;	/* Not found or error */
+		hint = 0; nent = 0;			/* The cached location is stale: scan from the top */
+		dp->fs->dc_miss++;
+		res = dir_sdi(dp, 0);
+		if (res != FR_OK) break;
+	}
+#endif
+
 	return res;
 }
 
@@ -1687,6 +1914,9 @@ FRESULT dir_remove (	/* FR_OK:Succeeded, FR_DISK_ERR:A disk error */
 		}
 	}
 #endif
+#if _FS_DCACHE
+	dcache_drop(dp->fs, dp->sclust);	/* Entries of the directory may have gone */
+#endif
 
 	return res;
 }
@@ -2119,7 +2349,6 @@ int get_ldnumber (		/* Returns logical drive number (-1:invalid drive) */
 	UINT i;
 	int vol = -1;
 #if _STR_VOLUME_ID		/* Find string drive id */
-	static const char* const str[] = {_VOLUME_STRS};
 	const char *sp;
 	char c;
 	TCHAR tc;
@@ -2141,7 +2370,8 @@ int get_ldnumber (		/* Returns logical drive number (-1:invalid drive) */
 			 else {	/* No numeric drive number, find string drive id */
 				i = 0; tt++;
 				do {
-					sp = str[i]; tp = *path;
+					sp = VolStr[i]; tp = *path;
+					if (!sp) { c = 1; continue; }	/* No string ID registered for this drive */
 					do {	/* Compare a string drive id with path name */
 						c = *sp++; tc = *tp++;
 						if (IsLower(tc)) tc -= 0x20;
@@ -2326,6 +2556,10 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #if !_FS_READONLY
 	/* Initialize cluster allocation information */
 	fs->last_clust = fs->free_clust = 0xFFFFFFFF;
+#if _FS_FREEMAP
+	for (fs->fmap_gs = 0; ((fs->n_fatent - 1) >> fs->fmap_gs) >= _FS_FREEMAP * 8; fs->fmap_gs++) ;
+	mem_set(fs->fmap, 0, _FS_FREEMAP);	/* Nothing is known about the free clusters yet */
+#endif
 
 	/* Get fsinfo if available */
 	fs->fsi_flag = 0x80;
@@ -2351,6 +2585,10 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #endif
 	fs->fs_type = fmt;	/* FAT sub-type */
 	fs->id = ++Fsid;	/* File system mount ID */
+#if _FS_DCACHE			/* Clear directory lookup cache */
+	dcache_drop(fs, 0xFFFFFFFF);
+	fs->dc_hit = fs->dc_miss = 0;
+#endif
 #if _FS_RPATH
 	fs->cdir = 0;		/* Set current directory to root */
 #endif
@@ -2679,6 +2917,81 @@ FRESULT f_read (
 
 
 
+#if !_FS_TINY
+/*-----------------------------------------------------------------------*/
+/* Read File in Place                                                    */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_readview (
+	FIL* fp, 		/* Pointer to the file object */
+	const BYTE** rbuf,	/* Pointer to return pointer to the data in the sector cache */
+	UINT btr,		/* Maximum number of bytes to read */
+	UINT* br		/* Pointer to number of bytes read (up to the sector boundary) */
+)
+{
+	FRESULT res;
+	DWORD clst, sect, remain;
+	UINT rcnt;
+	BYTE csect;
+
+
+	*rbuf = 0; *br = 0;	/* Clear read byte counter */
+
+	res = validate(fp);							/* Check validity */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->err)								/* Check error */
+		LEAVE_FF(fp->fs, (FRESULT)fp->err);
+	if (!(fp->flag & FA_READ)) 					/* Check access mode */
+		LEAVE_FF(fp->fs, FR_DENIED);
+	remain = fp->fsize - fp->fptr;
+	if (btr > remain) btr = (UINT)remain;		/* Truncate btr by remaining bytes */
+	if (!btr) LEAVE_FF(fp->fs, FR_OK);
+
+	if ((fp->fptr % SS(fp->fs)) == 0) {			/* On the sector boundary? */
+		csect = (BYTE)(fp->fptr / SS(fp->fs) & (fp->fs->csize - 1));	/* Sector offset in the cluster */
+		if (!csect) {							/* On the cluster boundary? */
+			if (fp->fptr == 0) {				/* On the top of the file? */
+				clst = fp->sclust;				/* Follow from the origin */
+			} else {							/* Middle or end of the file */
+#if _USE_FASTSEEK
+				if (fp->cltbl)
+					clst = clmt_clust(fp, fp->fptr);	/* Get cluster# from the CLMT */
+				else
+#endif
+					clst = get_fat(fp->fs, fp->clust);	/* Follow cluster chain on the FAT */
+			}
+			if (clst < 2) ABORT(fp->fs, FR_INT_ERR);
+			if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
+			fp->clust = clst;					/* Update current cluster */
+		}
+		sect = clust2sect(fp->fs, fp->clust);	/* Get current sector */
+		if (!sect) ABORT(fp->fs, FR_INT_ERR);
+		sect += csect;
+		if (fp->dsect != sect) {				/* Load data sector if not in cache */
+#if !_FS_READONLY
+			if (fp->flag & FA__DIRTY) {			/* Write-back dirty sector cache */
+				if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
+					ABORT(fp->fs, FR_DISK_ERR);
+				fp->flag &= ~FA__DIRTY;
+			}
+#endif
+			if (disk_read(fp->fs->drv, fp->buf, sect, 1) != RES_OK)	/* Fill sector cache */
+				ABORT(fp->fs, FR_DISK_ERR);
+		}
+		fp->dsect = sect;
+	}
+	rcnt = SS(fp->fs) - ((UINT)fp->fptr % SS(fp->fs));	/* Rest of the sector in the cache */
+	if (rcnt > btr) rcnt = btr;
+	*rbuf = &fp->buf[fp->fptr % SS(fp->fs)];
+	fp->fptr += rcnt; *br = rcnt;
+
+	LEAVE_FF(fp->fs, FR_OK);
+}
+#endif
+
+
+
+
 #if !_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* Write File                                                            */
@@ -3439,13 +3752,21 @@ FRESULT f_getfree (
 			/* Get number of free clusters */
 			fat = fs->fs_type;
 			nfree = 0;
+#if _FS_FREEMAP
+			mem_set(fs->fmap, 0xFF, _FS_FREEMAP);	/* Rebuild the free cluster map in this scan */
+#endif
 			if (fat == FS_FAT12) {	/* Sector unalighed entries: Search FAT via regular routine. */
 				clst = 2;
 				do {
 					stat = get_fat(fs, clst);
 					if (stat == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
 					if (stat == 1) { res = FR_INT_ERR; break; }
-					if (stat == 0) nfree++;
+					if (stat == 0) {
+						nfree++;
+#if _FS_FREEMAP
+						fmap_put(fs, clst, 0);
+#endif
+					}
 				} while (++clst < fs->n_fatent);
 			} else {				/* Sector alighed entries: Accelerate the FAT search. */
 				clst = fs->n_fatent; sect = fs->fatbase;
@@ -3458,14 +3779,23 @@ FRESULT f_getfree (
 						i = SS(fs);
 					}
 					if (fat == FS_FAT16) {
-						if (LD_WORD(p) == 0) nfree++;
+						stat = LD_WORD(p);
 						p += 2; i -= 2;
 					} else {
-						if ((LD_DWORD(p) & 0x0FFFFFFF) == 0) nfree++;
+						stat = LD_DWORD(p) & 0x0FFFFFFF;
 						p += 4; i -= 4;
 					}
+					if (stat == 0) {
+						nfree++;
+#if _FS_FREEMAP
+						fmap_put(fs, fs->n_fatent - clst, 0);
+#endif
+					}
 				} while (--clst);
 			}
+#if _FS_FREEMAP
+			if (res != FR_OK) mem_set(fs->fmap, 0, _FS_FREEMAP);	/* Partial scan: forget it */
+#endif
 			fs->free_clust = nfree;	/* free_clust is valid */
 			fs->fsi_flag |= 1;		/* FSInfo is to be updated */
 			*nclst = nfree;			/* Return the free clusters */
@@ -3477,6 +3807,33 @@ FRESULT f_getfree (
 
 
 
+#if _FS_DCACHE
+/*-----------------------------------------------------------------------*/
+/* Get Hit/Miss Counts of the Directory Lookup Cache                     */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_dcstat (
+	const TCHAR* path,	/* Path name of the logical drive number */
+	DWORD* hit,			/* Pointer to return number of lookups served from the cache */
+	DWORD* miss			/* Pointer to return number of lookups scanned from the top */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+
+
+	res = find_volume(&fs, &path, 0);
+	if (res == FR_OK) {
+		*hit = fs->dc_hit;
+		*miss = fs->dc_miss;
+	}
+	LEAVE_FF(fs, res);
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Truncate File                                                         */
 /*-----------------------------------------------------------------------*/
@@ -3590,6 +3947,9 @@ FRESULT f_unlink (
 				res = dir_remove(&dj);		/* Remove the directory entry */
 				if (res == FR_OK && dclst)	/* Remove the cluster chain if exist */
 					res = remove_chain(dj.fs, dclst);
+#if _FS_DCACHE
+				if (dclst) dcache_drop(dj.fs, dclst);	/* Forget the objects in the removed directory */
+#endif
 				if (res == FR_OK) res = sync_fs(dj.fs);
 			}
 		}
@@ -3655,6 +4015,9 @@ FRESULT f_mkdir (
 					mem_set(dir, 0, SS(dj.fs));
 				}
 			}
+#if _FS_DCACHE
+			if (res == FR_OK) dcache_drop(dj.fs, dcl);	/* The table may reuse a removed one */
+#endif
 			if (res == FR_OK) res = dir_register(&dj);	/* Register the object to the directoy */
 			if (res != FR_OK) {
 				remove_chain(dj.fs, dcl);			/* Could not register, remove cluster chain */
@@ -4066,6 +4429,107 @@ FRESULT f_forward (
 
 
 
+#if _USE_EXPAND && !_FS_READONLY
+/*-----------------------------------------------------------------------*/
+/* Allocate a Contiguous Blocks to the File                              */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_expand (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD fsz,		/* File size to be expanded to */
+	BYTE opt		/* Operation mode 0:Find and prepare or 1:Find and allocate */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD n, clst, scl, tcl;
+
+
+	res = validate(fp);								/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->err)									/* Check error */
+		LEAVE_FF(fp->fs, (FRESULT)fp->err);
+	if (fsz == 0 || fp->fsize != 0 || fp->sclust != 0 || !(fp->flag & FA_WRITE))
+		LEAVE_FF(fp->fs, FR_DENIED);				/* Check access mode and the file is empty */
+
+	fs = fp->fs;
+	n = (DWORD)fs->csize * SS(fs);					/* Cluster size */
+	tcl = fsz / n + ((fsz % n) ? 1 : 0);			/* Number of clusters required */
+	if (tcl > fs->n_fatent - 2) LEAVE_FF(fs, FR_DENIED);
+
+	scl = fs->last_clust;							/* Search from the last allocated cluster */
+	if (!scl || scl >= fs->n_fatent) scl = 1;
+	scl = find_free(fs, scl, tcl);					/* Find a contiguous cluster block */
+	if (scl == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+	if (scl == 1) ABORT(fs, FR_INT_ERR);
+	if (scl == 0) LEAVE_FF(fs, FR_DENIED);			/* No contiguous cluster block was found */
+
+	if (opt) {		/* Allocate the block as a cluster chain of the file */
+		for (clst = scl, n = tcl; n; clst++, n--) {
+			res = put_fat(fs, clst, (n == 1) ? 0x0FFFFFFF : clst + 1);
+			if (res != FR_OK) break;
+		}
+		if (res == FR_OK) {
+			fs->last_clust = scl + tcl - 1;			/* Update FSINFO */
+			if (fs->free_clust != 0xFFFFFFFF) {
+				fs->free_clust -= tcl;
+				fs->fsi_flag |= 1;
+			}
+			fp->sclust = scl;						/* Set the block to the file */
+			fp->fsize = fsz;
+			fp->flag |= FA__WRITTEN;
+		} else if (clst > scl) {					/* Release the part already linked */
+			put_fat(fs, clst - 1, 0x0FFFFFFF);
+			remove_chain(fs, scl);
+		}
+	} else {		/* Let the next allocation start at the block */
+		fs->last_clust = scl - 1;
+	}
+
+	LEAVE_FF(fs, res);
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Count Fragments of the File                                           */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_fragments (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD* nfrag	/* Pointer to return number of contiguous cluster blocks */
+)
+{
+	FRESULT res;
+	DWORD clst, nxt;
+
+
+	*nfrag = 0;
+	res = validate(fp);								/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->err)									/* Check error */
+		LEAVE_FF(fp->fs, (FRESULT)fp->err);
+
+	clst = fp->sclust;
+	if (clst) {
+		*nfrag = 1;
+		for (;;) {									/* Follow the cluster chain */
+			nxt = get_fat(fp->fs, clst);
+			if (nxt == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
+			if (nxt < 2) ABORT(fp->fs, FR_INT_ERR);
+			if (nxt >= fp->fs->n_fatent) break;		/* End of the chain */
+			if (nxt != clst + 1) (*nfrag)++;		/* Not contiguous */
+			clst = nxt;
+		}
+	}
+
+	LEAVE_FF(fp->fs, FR_OK);
+}
+#endif /* _USE_EXPAND */
+
+
+
 #if _USE_MKFS && !_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* Create file system on the logical drive                               */
@@ -4084,14 +4548,14 @@ FRESULT f_mkfs (
 	static const WORD cst[] = {32768, 16384, 8192, 4096, 2048, 16384, 8192, 4096, 2048, 1024, 512};
 	int vol;
 	BYTE fmt, md, sys, *tbl, pdrv, part;
-	DWORD n_clst, vs, n, wsect;
+	DWORD n_clst, vs, n, wsect, eb;
 	UINT i;
 	DWORD b_vol, b_fat, b_dir, b_data;	/* LBA */
 	DWORD n_vol, n_rsv, n_fat, n_dir;	/* Size */
 	FATFS *fs;
 	DSTATUS stat;
 #if _USE_TRIM
-	DWORD eb[2];
+	DWORD rt[2];
 #endif
 
 
@@ -4106,13 +4570,17 @@ FRESULT f_mkfs (
 	part = LD2PT(vol);	/* Partition (0:auto detect, 1-4:get from partition table)*/
 
 	/* Get disk statics */
-	stat = disk_initialize(pdrv);
+	stat = disk_status(pdrv);
+	if (stat & STA_NOINIT) stat = disk_initialize(pdrv);	/* Initialize the drive unless the caller did already */
 	if (stat & STA_NOINIT) return FR_NOT_READY;
 	if (stat & STA_PROTECT) return FR_WRITE_PROTECTED;
 #if _MAX_SS != _MIN_SS		/* Get disk sector size */
 	if (disk_ioctl(pdrv, GET_SECTOR_SIZE, &SS(fs)) != RES_OK || SS(fs) > _MAX_SS || SS(fs) < _MIN_SS)
 		return FR_DISK_ERR;
 #endif
+	/* Get erase block size to align the partition, FAT and data area (for flash memory media) */
+	if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &eb) != RES_OK || !eb || eb > 32768 || (eb & (eb - 1))) eb = 1;
+
 	if (_MULTI_PARTITION && part) {
 		/* Get partition information from partition table in the MBR */
 		if (disk_read(pdrv, fs->win, 0, 1) != RES_OK) return FR_DISK_ERR;
@@ -4126,6 +4594,7 @@ FRESULT f_mkfs (
 		if (disk_ioctl(pdrv, GET_SECTOR_COUNT, &n_vol) != RES_OK || n_vol < 128)
 			return FR_DISK_ERR;
 		b_vol = (sfd) ? 0 : 63;		/* Volume start sector */
+		if (!sfd && eb > b_vol && n_vol / 16 >= eb) b_vol = eb;	/* Start the partition at an erase block */
 		n_vol -= b_vol;				/* Volume size */
 	}
 
@@ -4162,14 +4631,30 @@ FRESULT f_mkfs (
 	if (n_vol < b_data + au - b_vol) return FR_MKFS_ABORTED;	/* Too small volume */
 
 	/* Align data start sector to erase block boundary (for flash memory media) */
-	if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &n) != RES_OK || !n || n > 32768) n = 1;
-	n = (b_data + n - 1) & ~(n - 1);	/* Next nearest erase block from current data start */
-	n = (n - b_data) / N_FATS;
-	if (fmt == FS_FAT32) {		/* FAT32: Move FAT offset */
+	if (fmt == FS_FAT32 && N_FATS == 1 && eb > 1 && n_rsv + eb * 2 <= 0xFFFF) {
+		n = ((b_fat + eb - 1) & ~(eb - 1)) - b_fat;	/* FAT32: Move FAT offset to the next erase block */
 		n_rsv += n;
 		b_fat += n;
-	} else {					/* FAT12/16: Expand FAT size */
-		n_fat += n;
+		n_fat = (n_fat + eb - 1) & ~(eb - 1);	/* and expand FAT to whole erase blocks */
+		b_data = b_fat + n_fat;
+		if (n_vol < b_data + au - b_vol) return FR_MKFS_ABORTED;	/* Too small volume */
+	} else {
+		if (fmt != FS_FAT32 && eb > 1 && n_rsv + eb <= 0xFFFF && n_vol / 16 >= eb) {	/* FAT12/16: Move FAT offset to the next erase block */
+			n = ((b_fat + eb - 1) & ~(eb - 1)) - b_fat;
+			if (fmt == FS_FAT12 || (n_vol - n_rsv - n - n_fat * N_FATS - n_dir - eb) / au >= MIN_FAT16) {	/* unless it drops below FAT16 */
+				n_rsv += n;
+				b_fat += n;
+				b_data += n;
+			}
+		}
+		n = (b_data + eb - 1) & ~(eb - 1);	/* Next nearest erase block from current data start */
+		n = (n - b_data) / N_FATS;
+		if (fmt == FS_FAT32) {		/* FAT32: Move FAT offset */
+			n_rsv += n;
+			b_fat += n;
+		} else {					/* FAT12/16: Expand FAT size */
+			n_fat += n;
+		}
 	}
 
 	/* Determine number of clusters and final check of validity of the FAT sub-type */
@@ -4202,15 +4687,16 @@ FRESULT f_mkfs (
 		} else {	/* Create partition table (FDISK) */
 			mem_set(fs->win, 0, SS(fs));
 			tbl = fs->win + MBR_Table;	/* Create partition table for single partition in the drive */
-			tbl[1] = 1;						/* Partition start head */
-			tbl[2] = 1;						/* Partition start sector */
-			tbl[3] = 0;						/* Partition start cylinder */
+			n = b_vol / 63 / 255;
+			tbl[1] = (BYTE)(b_vol / 63 % 255);	/* Partition start head */
+			tbl[2] = (BYTE)((n >> 2 & 0xC0) | (b_vol % 63 + 1));	/* Partition start sector */
+			tbl[3] = (BYTE)n;				/* Partition start cylinder */
 			tbl[4] = sys;					/* System type */
 			tbl[5] = 254;					/* Partition end head */
 			n = (b_vol + n_vol) / 63 / 255;
 			tbl[6] = (BYTE)(n >> 2 | 63);	/* Partition end sector */
 			tbl[7] = (BYTE)n;				/* End cylinder */
-			ST_DWORD(tbl + 8, 63);			/* Partition start in LBA */
+			ST_DWORD(tbl + 8, b_vol);		/* Partition start in LBA */
 			ST_DWORD(tbl + 12, n_vol);		/* Partition size in LBA */
 			ST_WORD(fs->win + BS_55AA, 0xAA55);	/* MBR signature */
 			if (disk_write(pdrv, fs->win, 0, 1) != RES_OK)	/* Write it to the MBR */
@@ -4294,8 +4780,8 @@ FRESULT f_mkfs (
 
 #if _USE_TRIM	/* Erase data area if needed */
 	{
-		eb[0] = wsect; eb[1] = wsect + (n_clst - ((fmt == FS_FAT32) ? 1 : 0)) * au - 1;
-		disk_ioctl(pdrv, CTRL_TRIM, eb);
+		rt[0] = wsect; rt[1] = wsect + (n_clst - ((fmt == FS_FAT32) ? 1 : 0)) * au - 1;
+		disk_ioctl(pdrv, CTRL_TRIM, rt);
 	}
 #endif
 
@@ -48,6 +48,10 @@ extern PARTITION VolToPart[];	/* Volume - Partition resolution table */
 
 #endif
 
+#if _STR_VOLUME_ID
+extern const char* VolStr[];	/* Volume - Drive ID string table (NULL:no string ID) */
+#endif
+
 
 
 /* Type of path name strings on FatFs API */
@@ -73,6 +77,21 @@ typedef char TCHAR;
 
 
 
+/* Directory lookup cache entry (DCENT) */
+
+#if _FS_DCACHE
+typedef struct {
+	DWORD	dclust;			/* Start cluster of the directory (0:root) */
+	DWORD	hash;			/* Hash of the directory and the object name */
+	DWORD	clust;			/* Cluster# of the top entry of the object */
+	DWORD	sect;			/* Sector# of the top entry of the object */
+	WORD	index;			/* Index of the top entry of the object (0xFFFF:Empty) */
+	WORD	nent;			/* Number of entries of the object (LFN entries + SFN entry) */
+} DCENT;
+#endif
+
+
+
 /* File system object structure (FATFS) */
 
 typedef struct {
@@ -93,6 +112,10 @@ typedef struct {
 #if !_FS_READONLY
 	DWORD	last_clust;		/* Last allocated cluster */
 	DWORD	free_clust;		/* Number of free clusters */
+#if _FS_FREEMAP
+	BYTE	fmap_gs;		/* Cluster group size of the free cluster map (log2) */
+	BYTE	fmap[_FS_FREEMAP];	/* Free cluster map (1:All clusters in the group are in use) */
+#endif
 #endif
 #if _FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
@@ -104,6 +127,11 @@ typedef struct {
 	DWORD	dirbase;		/* Root directory start sector (FAT32:Cluster#) */
 	DWORD	database;		/* Data start sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
+#if _FS_DCACHE
+	DWORD	dc_hit;			/* Number of directory lookups served from the cache */
+	DWORD	dc_miss;		/* Number of directory lookups scanned from the top */
+	DCENT	dcache[_FS_DCACHE];	/* Directory lookup cache */
+#endif
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
 } FATFS;
 
@@ -212,10 +240,13 @@ typedef enum {
 FRESULT f_open (FIL* fp, const TCHAR* path, BYTE mode);				/* Open or create a file */
 FRESULT f_close (FIL* fp);											/* Close an open file object */
 FRESULT f_read (FIL* fp, void* buff, UINT btr, UINT* br);			/* Read data from a file */
+FRESULT f_readview (FIL* fp, const BYTE** rbuf, UINT btr, UINT* br);	/* Read data from a file in place */
 FRESULT f_write (FIL* fp, const void* buff, UINT btw, UINT* bw);	/* Write data to a file */
 FRESULT f_forward (FIL* fp, UINT(*func)(const BYTE*,UINT), UINT btf, UINT* bf);	/* Forward data to the stream */
 FRESULT f_lseek (FIL* fp, DWORD ofs);								/* Move file pointer of a file object */
 FRESULT f_truncate (FIL* fp);										/* Truncate file */
+FRESULT f_expand (FIL* fp, DWORD fsz, BYTE opt);					/* Allocate a contiguous block to the file */
+FRESULT f_fragments (FIL* fp, DWORD* nfrag);						/* Get number of contiguous blocks of the file */
 FRESULT f_sync (FIL* fp);											/* Flush cached data of a writing file */
 FRESULT f_opendir (FATFS_DIR* dp, const TCHAR* path);						/* Open a directory */
 FRESULT f_closedir (FATFS_DIR* dp);										/* Close an open directory */
@@ -232,6 +263,7 @@ FRESULT f_chdir (const TCHAR* path);								/* Change current directory */
 FRESULT f_chdrive (const TCHAR* path);								/* Change current drive */
 FRESULT f_getcwd (TCHAR* buff, UINT len);							/* Get current directory */
 FRESULT f_getfree (const TCHAR* path, DWORD* nclst, FATFS** fatfs);	/* Get number of free clusters on the drive */
+FRESULT f_dcstat (const TCHAR* path, DWORD* hit, DWORD* miss);		/* Get hit/miss counts of the directory lookup cache */
 FRESULT f_getlabel (const TCHAR* path, TCHAR* label, DWORD* vsn);	/* Get volume label */
 FRESULT f_setlabel (const TCHAR* label);							/* Set volume label */
 FRESULT f_mount (FATFS* fs, const TCHAR* path, BYTE opt);			/* Mount/Unmount a logical drive */
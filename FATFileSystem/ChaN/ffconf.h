@@ -5,6 +5,8 @@
 #define _FFCONF 64180	/* Revision ID */
 
 #define FFS_DBG			0
+#define FFS_MAX_OPEN_FILES	4	/* FATFileHandle slots in the handle pool */
+#define FFS_MAX_OPEN_DIRS	2	/* FATDirHandle slots in the handle pool */
 
 /*---------------------------------------------------------------------------/
 / Function Configurations
@@ -45,10 +47,14 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_FASTSEEK	0
+#define	_USE_FASTSEEK	1
 /* This option switches fast seek feature. (0:Disable or 1:Enable) */
 
 
+#define	_USE_EXPAND		1
+/* This option switches f_expand() and f_fragments() functions. (0:Disable or 1:Enable) */
+
+
 #define _USE_LABEL		0
 /* This option switches volume label functions, f_getlabel() and f_setlabel().
 /  (0:Disable or 1:Enable) */
@@ -63,7 +69,9 @@
 / Locale and Namespace Configurations
 /---------------------------------------------------------------------------*/
 
+#ifndef _CODE_PAGE
 #define _CODE_PAGE	850
+#endif
 /* This option specifies the OEM code page to be used on the target system.
 /  Incorrect setting of the code page can cause a file open failure.
 /
@@ -92,7 +100,7 @@
 */
 
 
-#define	_USE_LFN	1
+#define	_USE_LFN	3
 #define	_MAX_LFN	255
 /* The _USE_LFN option switches the LFN feature.
 /
@@ -140,17 +148,19 @@
 / Drive/Volume Configurations
 /---------------------------------------------------------------------------*/
 
-#define _VOLUMES	1
-/* Number of volumes (logical drives) to be used. */
+#define _VOLUMES	2
+/* Number of volumes (logical drives) to be used. Each FATFileSystem instance takes
+/  one drive when it is constructed and gives it back when destroyed, so this is the
+/  number of file systems that can exist at the same time (e.g. /sd and a RAM disk). */
 
 
-#define _STR_VOLUME_ID	0
-#define _VOLUME_STRS	"RAM","NAND","CF","SD1","SD2","USB1","USB2","USB3"
+#define _STR_VOLUME_ID	1
 /* _STR_VOLUME_ID option switches string volume ID feature.
-/  When _STR_VOLUME_ID is set to 1, also pre-defined strings can be used as drive
-/  number in the path name. _VOLUME_STRS defines the drive ID strings for each
-/  logical drives. Number of items must be equal to _VOLUMES. Valid characters for
-/  the drive ID strings are: A-Z and 0-9. */
+/  When _STR_VOLUME_ID is set to 1, also strings can be used as drive number in the
+/  path name. The drive ID strings are held in VolStr[], which must be defined by
+/  the application like VolToPart[]. FATFileSystem registers the upper-cased mount
+/  name of each instance there, so "sd:/file" and "0:/file" name the same file.
+/  Valid characters for the drive ID strings are: A-Z and 0-9. */
 
 
 #define	_MULTI_PARTITION	0
@@ -171,10 +181,12 @@
 /  disk_ioctl() function. */
 
 
-#define	_USE_TRIM	0
+#define	_USE_TRIM	1
 /* This option switches ATA-TRIM feature. (0:Disable or 1:Enable)
 /  To enable Trim feature, also CTRL_TRIM command should be implemented to the
-/  disk_ioctl() function. */
+/  disk_ioctl() function.
+/  In this port CTRL_TRIM calls FATFileSystem::disk_trim(), which erases the freed
+/  sectors on an SD card and releases them on a MemFileSystem. */
 
 
 #define _FS_NOFSINFO	0
@@ -189,6 +201,23 @@
 */
 
 
+#ifndef _FS_FREEMAP
+#define	_FS_FREEMAP	0
+#endif
+/* This option sets the size in bytes of the free cluster map held in RAM by each
+/  file system object. (0:Disable or >0:Enable)
+/  The map costs _FS_FREEMAP bytes of RAM per volume, so with _VOLUMES 2 a size of
+/  512 takes 1KB. It only pays off on big, nearly full volumes, so it is off by
+/  default and can be turned on from the build (-D_FS_FREEMAP=512).
+/  Each bit of the map covers a group of clusters and is set when every cluster
+/  in the group is known to be in use, so that the cluster allocator can skip it
+/  without reading the FAT. The group size is the smallest power of two that lets
+/  the whole volume fit in the map, e.g. 512 bytes cover a 4GB volume with 32KB
+/  clusters at 32 clusters per bit. The map starts empty at mount and is filled
+/  lazily by the allocator and by f_getfree(). This option has no effect at
+/  read-only configuration. */
+
+
 
 /*---------------------------------------------------------------------------/
 / System Configurations
@@ -216,6 +245,17 @@
 /  These options have no effect at read-only configuration (_FS_READONLY == 1). */
 
 
+#ifndef _FS_DCACHE
+#define	_FS_DCACHE	8
+#endif
+/* This option sets the number of entries of the directory lookup cache held by
+/  each file system object. (0:Disable or >0:Enable, power of 2)
+/  The cache maps a directory and an object name to the location of its entries,
+/  so that looking up the same path again does not scan the directory from the
+/  top. A hit is always verified against the directory entries, so a stale entry
+/  only costs a full scan. */
+
+
 #define	_FS_LOCK	0
 /* The _FS_LOCK option switches file lock feature to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when _FS_READONLY
@@ -228,9 +268,9 @@
 /      lock feature is independent of re-entrancy. */
 
 
-#define _FS_REENTRANT	0
-#define _FS_TIMEOUT		1000
-#define	_SYNC_t			HANDLE
+#define _FS_REENTRANT	1
+#define _FS_TIMEOUT		10000
+#define	_SYNC_t			void*
 /* The _FS_REENTRANT option switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
 /  volume is always re-entrant and volume control functions, f_mount(), f_mkfs()
@@ -246,7 +286,15 @@
 /  The _FS_TIMEOUT defines timeout period in unit of time tick.
 /  The _SYNC_t defines O/S dependent sync object type. e.g. HANDLE, ID, OS_EVENT*,
 /  SemaphoreHandle_t and etc.. A header file for O/S definitions needs to be
-/  included somewhere in the scope of ff.c. */
+/  included somewhere in the scope of ff.c.
+/  In this port the handlers in syscall.cpp lock one rtos::Mutex per volume, the
+/  _FS_TIMEOUT is in milliseconds and the LFN working buffers (_USE_LFN 3) come
+/  from a fixed pool of one buffer per volume.
+/  A single call can hold the lock for seconds: the first f_getfree() on a 4GB
+/  card scans the whole FAT in about 4.3s, an open in a 1000-file directory
+/  missing the cache takes about 0.8s (tools/host freemap and dircache). The
+/  timeout is well above that so it only fires on a hung card, not when another
+/  thread is busy with the volume. */
 
 
 #define _WORD_ACCESS	0
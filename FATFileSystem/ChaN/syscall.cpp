@@ -0,0 +1,92 @@
+/*------------------------------------------------------------------------*/
+/* OS dependent functions for FatFs on mbed-rtos                          */
+/*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "rtos.h"
+#include "ff.h"
+
+
+#if _FS_REENTRANT
+/*------------------------------------------------------------------------*/
+/* Sync objects, one mutex per volume                                     */
+/*------------------------------------------------------------------------*/
+/* The RTX mutex is recursive, which f_write() relies on when it calls
+/  f_sync() on a new sector (FLUSH_ON_NEW_SECTOR) with the volume locked. */
+
+static rtos::Mutex VolMutex[_VOLUMES];
+
+
+int ff_cre_syncobj (	/* 1:Function succeeded, 0:Could not create the sync object */
+	BYTE vol,			/* Corresponding volume (logical drive number) */
+	_SYNC_t *sobj		/* Pointer to return the created sync object */
+)
+{
+	if (vol >= _VOLUMES) return 0;
+	*sobj = &VolMutex[vol];
+	return 1;
+}
+
+
+int ff_del_syncobj (	/* 1:Function succeeded, 0:Could not delete due to any error */
+	_SYNC_t sobj		/* Sync object tied to the logical drive to be deleted */
+)
+{
+	(void)sobj;			/* The mutex is static and is reused on the next mount */
+	return 1;
+}
+
+
+int ff_req_grant (	/* 1:Got a grant to access the volume, 0:Could not get a grant */
+	_SYNC_t sobj	/* Sync object to wait */
+)
+{
+	return ((rtos::Mutex*)sobj)->lock(_FS_TIMEOUT) == osOK;
+}
+
+
+void ff_rel_grant (
+	_SYNC_t sobj	/* Sync object to be signaled */
+)
+{
+	((rtos::Mutex*)sobj)->unlock();
+}
+#endif
+
+
+
+
+#if _USE_LFN == 3
+/*------------------------------------------------------------------------*/
+/* LFN working buffers                                                    */
+/*------------------------------------------------------------------------*/
+/* A buffer is only held while the volume is locked, so one per volume is
+/  enough. The heap is used only if the pool is ever exhausted. */
+
+typedef struct {
+	WCHAR	buf[_MAX_LFN + 1];
+} LFNBUF;
+
+static rtos::MemoryPool<LFNBUF, _VOLUMES> LfnPool;
+
+
+void* ff_memalloc (	/* Returns pointer to the allocated memory block */
+	UINT msize		/* Number of bytes to allocate */
+)
+{
+	void *p = 0;
+
+
+	if (msize <= sizeof (LFNBUF)) p = LfnPool.alloc();
+	if (!p) p = malloc(msize);
+	return p;
+}
+
+
+void ff_memfree (
+	void* mblock	/* Pointer to the memory block to free */
+)
+{
+	if (LfnPool.free((LFNBUF*)mblock) != osOK) free(mblock);	/* Not from the pool */
+}
+#endif
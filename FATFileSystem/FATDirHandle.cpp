@@ -25,13 +25,27 @@
 
 using namespace mbed;
 
+static FATHandlePool<FATDirHandle, FFS_MAX_OPEN_DIRS> handle_pool;
+
+FATDirHandle *FATDirHandle::create(const FATFS_DIR &the_dir) {
+    void *slot = handle_pool.alloc();
+    if (slot == NULL) {
+        return NULL;
+    }
+    return new (slot) FATDirHandle(the_dir);
+}
+
+FATHandleStats FATDirHandle::stats() {
+    return handle_pool.stats();
+}
+
 FATDirHandle::FATDirHandle(const FATFS_DIR &the_dir) {
     dir = the_dir;
 }
 
 int FATDirHandle::closedir() {
     int retval = f_closedir(&dir);
-    delete this;
+    handle_pool.release(this);
     return retval;
 }
 
@@ -23,13 +23,22 @@
 #define MBED_FATDIRHANDLE_H
 
 #include "DirHandle.h"
+#include "FATHandlePool.h"
 
 using namespace mbed;
 
 class FATDirHandle : public DirHandle {
 
  public:
-    FATDirHandle(const FATFS_DIR &the_dir);
+    /** Construct a handle for an open directory in the handle pool
+     *
+     *  @returns the handle, or NULL if FFS_MAX_OPEN_DIRS handles are open
+     */
+    static FATDirHandle *create(const FATFS_DIR &the_dir);
+
+    /** Usage counters of the directory handle pool */
+    static FATHandleStats stats();
+
     virtual int closedir();
     virtual struct dirent *readdir();
     virtual void rewinddir();
@@ -43,6 +52,8 @@ class FATDirHandle : public DirHandle {
     virtual void rewind() { rewinddir(); };
 
  private:
+    FATDirHandle(const FATFS_DIR &the_dir);
+
     FATFS_DIR dir;
     struct dirent cur_entry;
 
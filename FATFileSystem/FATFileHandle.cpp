@@ -25,13 +25,28 @@
 
 #include "FATFileHandle.h"
 
-FATFileHandle::FATFileHandle(FIL fh) {
+static FATHandlePool<FATFileHandle, FFS_MAX_OPEN_FILES> handle_pool;
+
+FATFileHandle *FATFileHandle::create(const FIL &fh) {
+    void *slot = handle_pool.alloc();
+    if (slot == NULL) {
+        debug_if(FFS_DBG, "No free file handle\n");
+        return NULL;
+    }
+    return new (slot) FATFileHandle(fh);
+}
+
+FATHandleStats FATFileHandle::stats() {
+    return handle_pool.stats();
+}
+
+FATFileHandle::FATFileHandle(const FIL &fh) {
     _fh = fh;
 }
 
 int FATFileHandle::close() {
     int retval = f_close(&_fh);
-    delete this;
+    handle_pool.release(this);
     return retval;
 }
 
@@ -56,6 +71,18 @@ ssize_t FATFileHandle::read(void* buffer, size_t length) {
     return n;
 }
 
+ssize_t FATFileHandle::read_view(const void **data, size_t length) {
+    const BYTE *p;
+    UINT n;
+    FRESULT res = f_readview(&_fh, &p, length, &n);
+    if (res) {
+        debug_if(FFS_DBG, "f_readview() failed: %d\n", res);
+        return -1;
+    }
+    *data = p;
+    return n;
+}
+
 int FATFileHandle::isatty() {
     return 0;
 }
@@ -88,3 +115,53 @@ int FATFileHandle::fsync() {
 off_t FATFileHandle::flen() {
     return _fh.fsize;
 }
+
+int FATFileHandle::preallocate(off_t bytes, bool contiguous) {
+    FRESULT res;
+    if (_fh.fsize != 0) {
+        debug_if(FFS_DBG, "preallocate(): the file is not empty\n");
+        return -1;
+    }
+    if (contiguous) {
+        res = f_expand(&_fh, bytes, 1);
+    } else {
+        res = f_lseek(&_fh, bytes);     // Seeking past the end stretches the chain
+        if (res == FR_OK && _fh.fptr != (DWORD)bytes) {
+            res = FR_DENIED;            // Volume is full
+        }
+        if (res == FR_OK) {
+            res = f_lseek(&_fh, 0);
+        }
+    }
+    if (res) {
+        debug_if(FFS_DBG, "preallocate(%ld) failed: %d\n", (long)bytes, res);
+        return -1;
+    }
+    return 0;
+}
+
+int FATFileHandle::fast_seek(DWORD *table, DWORD entries) {
+    _fh.cltbl = NULL;
+    if (table == NULL) {
+        return 0;
+    }
+    table[0] = entries;
+    _fh.cltbl = table;
+    FRESULT res = f_lseek(&_fh, CREATE_LINKMAP);
+    if (res) {
+        debug_if(FFS_DBG, "CREATE_LINKMAP failed: %d, %lu entries needed\n", res, (unsigned long)table[0]);
+        _fh.cltbl = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int FATFileHandle::fragments() {
+    DWORD n;
+    FRESULT res = f_fragments(&_fh, &n);
+    if (res) {
+        debug_if(FFS_DBG, "f_fragments() failed: %d\n", res);
+        return -1;
+    }
+    return n;
+}
@@ -23,16 +23,36 @@
 #define MBED_FATFILEHANDLE_H
 
 #include "FileHandle.h"
+#include "FATHandlePool.h"
 
 using namespace mbed;
 
 class FATFileHandle : public FileHandle {
 public:
 
-    FATFileHandle(FIL fh);
+    /** Construct a handle for an open file in the handle pool
+     *
+     *  @returns the handle, or NULL if FFS_MAX_OPEN_FILES handles are open
+     */
+    static FATFileHandle *create(const FIL &fh);
+
+    /** Usage counters of the file handle pool */
+    static FATHandleStats stats();
+
     virtual int close();
     virtual ssize_t write(const void* buffer, size_t length);
     virtual ssize_t read(void* buffer, size_t length);
+
+    /** Read without copying, straight out of the sector cache of the file
+     *
+     *  At most the rest of the current sector is returned per call. The data
+     *  stays valid until the next operation on this handle.
+     *
+     *  @param data Set to point at the data read
+     *  @param length Maximum number of bytes to read
+     *  @returns number of bytes read, 0 at the end of the file, -1 on failure
+     */
+    ssize_t read_view(const void **data, size_t length);
     virtual int isatty();
     virtual off_t lseek(off_t position, int whence);
     virtual int fsync();
@@ -41,8 +61,42 @@ public:
     virtual off_t seek(off_t position, int whence) { return lseek(position, whence); }
     virtual off_t size() { return flen(); }
 
+    /** Reserve space for an empty file opened for writing
+     *
+     *  The file size becomes bytes and the file pointer stays at the top, so
+     *  the reserved area is then filled by overwriting it.
+     *
+     *  @param bytes Size of the area to reserve
+     *  @param contiguous Allocate the area as one run of clusters so it can be
+     *         streamed with multi-block transfers; fails if no run is large enough
+     *  @returns 0 on success, -1 on failure or if the file is not empty
+     */
+    int preallocate(off_t bytes, bool contiguous = true);
+
+    /** Number of contiguous cluster runs the file is stored in
+     *
+     *  @returns 1 for an unfragmented file, 0 for an empty one, -1 on failure
+     */
+    int fragments();
+
+    /** Seek through a cluster link map instead of following the FAT chain
+     *
+     *  The map is built once by walking the chain, after that lseek() finds
+     *  any position without reading the FAT. The file size cannot grow while
+     *  the map is in use.
+     *
+     *  @param table Space for the map, which has to stay valid until the file
+     *         is closed or fast_seek(NULL, 0) is called. Two entries per
+     *         fragment plus one are needed
+     *  @param entries Number of entries in table
+     *  @returns 0 on success, -1 if the table is too small
+     */
+    int fast_seek(DWORD *table, DWORD entries);
+
 protected:
-    
+
+    FATFileHandle(const FIL &fh);
+
     FIL _fh;
 
 };
@@ -41,6 +41,26 @@ DWORD get_fattime(void) {
 }
 
 FATFileSystem *FATFileSystem::_ffs[_VOLUMES] = {0};
+const char *VolStr[_VOLUMES] = {0};
+
+// Drive ID string for a mount name: the name upper-cased, or empty if it
+// does not fit or holds characters FatFs does not accept in a drive ID
+static void volume_id(char *id, const char *name) {
+    int i;
+    for (i = 0; name[i] && i < FFS_VOLID_LEN - 1; i++) {
+        char c = name[i];
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        } else if (!(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9')) {
+            break;
+        }
+        id[i] = c;
+    }
+    if (name[i]) {
+        i = 0;
+    }
+    id[i] = '\0';
+}
 
 FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n) {
     debug_if(FFS_DBG, "FATFileSystem(%s)\n", n);
@@ -48,28 +68,41 @@ FATFileSystem::FATFileSystem(const char* n) : FileSystemLike(n) {
         if(_ffs[i] == 0) {
             _ffs[i] = this;
             _fsid[0] = '0' + i;
-            _fsid[1] = '\0';
-            debug_if(FFS_DBG, "Mounting [%s] on ffs drive [%s]\n", getName(), _fsid);
+            _fsid[1] = ':';
+            _fsid[2] = '\0';
+            volume_id(_volid, n);
+            VolStr[i] = _volid[0] ? _volid : NULL;
+            debug_if(FFS_DBG, "Mounting [%s] on ffs drive [%s] [%s]\n", getName(), _fsid, _volid);
             f_mount(&_fs, _fsid, 0);
             return;
         }
     }
-    error("Couldn't create %s in FATFileSystem::FATFileSystem\n", n);
+    error("Couldn't create %s in FATFileSystem::FATFileSystem, all %d drives (_VOLUMES) in use\n", n, _VOLUMES);
 }
 
 FATFileSystem::~FATFileSystem() {
     for (int i=0; i<_VOLUMES; i++) {
         if (_ffs[i] == this) {
-            _ffs[i] = 0;
             f_mount(NULL, _fsid, 0);
+            VolStr[i] = NULL;
+            _ffs[i] = 0;
         }
     }
 }
 
+FATFileSystem *FATFileSystem::find(const char *name) {
+    for (int i=0; i<_VOLUMES; i++) {
+        if (_ffs[i] && strcmp(_ffs[i]->getName(), name) == 0) {
+            return _ffs[i];
+        }
+    }
+    return NULL;
+}
+
 FileHandle *FATFileSystem::open(const char* name, int flags) {
     debug_if(FFS_DBG, "open(%s) on filesystem [%s], drv [%s]\n", name, getName(), _fsid);
     char n[64];
-    sprintf(n, "%s:/%s", _fsid, name);
+    snprintf(n, sizeof(n), "%s/%s", _fsid, name);
 
     /* POSIX flags -> FatFS open mode */
     BYTE openmode;
@@ -97,7 +130,11 @@ FileHandle *FATFileSystem::open(const char* name, int flags) {
     if (flags & O_APPEND) {
         f_lseek(&fh, fh.fsize);
     }
-    return new FATFileHandle(fh);
+    FATFileHandle *handle = FATFileHandle::create(fh);
+    if (handle == NULL) {
+        f_close(&fh);
+    }
+    return handle;
 }
 
 int FATFileSystem::open(FileHandle **file, const char *name, int flags) {
@@ -111,7 +148,9 @@ int FATFileSystem::open(FileHandle **file, const char *name, int flags) {
 }
 
 int FATFileSystem::remove(const char *filename) {
-    FRESULT res = f_unlink(filename);
+    char n[64];
+    snprintf(n, sizeof(n), "%s/%s", _fsid, filename);
+    FRESULT res = f_unlink(n);
     if (res) {
         debug_if(FFS_DBG, "f_unlink() failed: %d\n", res);
         return -1;
@@ -120,7 +159,10 @@ int FATFileSystem::remove(const char *filename) {
 }
 
 int FATFileSystem::rename(const char *oldname, const char *newname) {
-    FRESULT res = f_rename(oldname, newname);
+    char o[64], n[64];
+    snprintf(o, sizeof(o), "%s/%s", _fsid, oldname);
+    snprintf(n, sizeof(n), "%s/%s", _fsid, newname);
+    FRESULT res = f_rename(o, n);
     if (res) {
         debug_if(FFS_DBG, "f_rename() failed: %d\n", res);
         return -1;
@@ -128,8 +170,42 @@ int FATFileSystem::rename(const char *oldname, const char *newname) {
     return 0;
 }
 
+// Cluster size for a volume, after the SD Association recommendations for
+// cards and scaled down for small RAM/flash volumes
+static uint32_t cluster_size_for(uint32_t sectors) {
+    if (sectors < 8192) {           // < 4 MB
+        return 1024;
+    } else if (sectors < 16384) {   // < 8 MB
+        return 8192;
+    } else if (sectors < 2097152) { // < 1 GB
+        return 16384;
+    }
+    return 32768;
+}
+
 int FATFileSystem::format() {
-    FRESULT res = f_mkfs(_fsid, 0, 512); // Logical drive number, Partitioning rule, Allocation unit size (bytes per cluster)
+    FATFormatOptions options;
+    return format(options);
+}
+
+int FATFileSystem::format(const FATFormatOptions &options) {
+    uint32_t au = options.cluster_size;
+    if (au == 0) {
+        // f_mkfs() only initialises the disk when this has not
+        if (disk_status() && disk_initialize()) {
+            debug_if(FFS_DBG, "format: disk_initialize() failed\n");
+            return -1;
+        }
+        au = cluster_size_for(disk_sectors());
+    }
+    // f_mkfs() aligns the partition, FAT and data area to disk_block_size()
+    FRESULT res = f_mkfs(_fsid, options.partition ? 0 : 1, au); // Logical drive number, Partitioning rule, Allocation unit size (bytes per cluster)
+    // The alignment padding can leave a cluster count just below a FAT type
+    // boundary, retry a picked cluster size with smaller ones
+    while (res == FR_MKFS_ABORTED && options.cluster_size == 0 && au > 512) {
+        au /= 2;
+        res = f_mkfs(_fsid, options.partition ? 0 : 1, au);
+    }
     if (res) {
         debug_if(FFS_DBG, "f_mkfs() failed: %d\n", res);
         return -1;
@@ -139,11 +215,17 @@ int FATFileSystem::format() {
 
 DirHandle *FATFileSystem::opendir(const char *name) {
     FATFS_DIR dir;
-    FRESULT res = f_opendir(&dir, name);
+    char n[64];
+    snprintf(n, sizeof(n), "%s/%s", _fsid, name);
+    FRESULT res = f_opendir(&dir, n);
     if (res != 0) {
         return NULL;
     }
-    return new FATDirHandle(dir);
+    FATDirHandle *handle = FATDirHandle::create(dir);
+    if (handle == NULL) {
+        f_closedir(&dir);
+    }
+    return handle;
 }
 
 int FATFileSystem::open(DirHandle **dir, const char *name) {
@@ -157,7 +239,9 @@ int FATFileSystem::open(DirHandle **dir, const char *name) {
 }
 
 int FATFileSystem::mkdir(const char *name, mode_t mode) {
-    FRESULT res = f_mkdir(name);
+    char n[64];
+    snprintf(n, sizeof(n), "%s/%s", _fsid, name);
+    FRESULT res = f_mkdir(n);
     return res == 0 ? 0 : -1;
 }
 
@@ -1,96 +1,116 @@
-/* mbed Microcontroller Library
- * Copyright (c) 2006-2012 ARM Limited
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- * SOFTWARE.
- */
-#ifndef MBED_FATFILESYSTEM_H
-#define MBED_FATFILESYSTEM_H
-
-#include "FileSystemLike.h"
-#include "FileHandle.h"
-#include "ff.h"
-#include <stdint.h>
-
-using namespace mbed;
-
-/**
- * FATFileSystem based on ChaN's Fat Filesystem library v0.8 
- */
-class FATFileSystem : public FileSystemLike {
-public:
-
-    FATFileSystem(const char* n);
-    virtual ~FATFileSystem();
-
-    static FATFileSystem * _ffs[_VOLUMES];   // FATFileSystem objects, as parallel to FatFs drives array
-    FATFS _fs;                               // Work area (file system object) for logical drive
-    char _fsid[2];
-
-    /**
-     * Opens a file on the filesystem
-     */
-    virtual FileHandle *open(const char* name, int flags);
-    virtual int open(FileHandle **file, const char *name, int flags);
-    
-    /**
-     * Removes a file path
-     */
-    virtual int remove(const char *filename);
-    
-    /**
-     * Renames a file
-     */
-    virtual int rename(const char *oldname, const char *newname);
-    
-    /**
-     * Formats a logical drive, FDISK artitioning rule, 512 bytes per cluster
-     */
-    virtual int format();
-    
-    /**
-     * Opens a directory on the filesystem
-     */
-    virtual DirHandle *opendir(const char *name);
-    virtual int open(DirHandle **dir, const char *name);
-    
-    /**
-     * Creates a directory path
-     */
-    virtual int mkdir(const char *name, mode_t mode);
-    
-    /**
-     * Mounts the filesystem
-     */
-    virtual int mount();
-    
-    /**
-     * Unmounts the filesystem
-     */
-    virtual int unmount();
-
-    virtual int disk_initialize() { return 0; }
-    virtual int disk_status() { return 0; }
-    virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
-    virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
-    virtual int disk_sync() { return 0; }
-    virtual uint32_t disk_sectors() = 0;
-
-};
-
-#endif
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_FATFILESYSTEM_H
+#define MBED_FATFILESYSTEM_H
+
+#include "FileSystemLike.h"
+#include "FileHandle.h"
+#include "ff.h"
+#include <stdint.h>
+
+using namespace mbed;
+
+#define FFS_VOLID_LEN 8     // Longest mount name usable as a FatFs drive ID string, plus NUL
+
+/** Layout options for FATFileSystem::format() */
+struct FATFormatOptions {
+    uint32_t cluster_size;  // Bytes per cluster, 0 to pick from the volume size
+    bool partition;         // Write an MBR partition table (FDISK) instead of a bare volume (SFD)
+
+    FATFormatOptions() : cluster_size(0), partition(true) {}
+};
+
+/**
+ * FATFileSystem based on ChaN's Fat Filesystem library v0.8 
+ */
+class FATFileSystem : public FileSystemLike {
+public:
+
+    FATFileSystem(const char* n);
+    virtual ~FATFileSystem();
+
+    static FATFileSystem * _ffs[_VOLUMES];   // FATFileSystem objects, as parallel to FatFs drives array
+    FATFS _fs;                               // Work area (file system object) for logical drive
+    char _fsid[3];                           // Drive prefix of FatFs paths ("0:", "1:", ...)
+    char _volid[FFS_VOLID_LEN];              // Drive ID string from the mount name ("SD"), registered in VolStr[]
+
+    /**
+     * Finds a registered filesystem by its mount name, NULL if there is none
+     */
+    static FATFileSystem *find(const char *name);
+
+    /**
+     * Opens a file on the filesystem
+     */
+    virtual FileHandle *open(const char* name, int flags);
+    virtual int open(FileHandle **file, const char *name, int flags);
+    
+    /**
+     * Removes a file path
+     */
+    virtual int remove(const char *filename);
+    
+    /**
+     * Renames a file
+     */
+    virtual int rename(const char *oldname, const char *newname);
+    
+    /**
+     * Formats a logical drive, FDISK partitioning rule, cluster size picked
+     * from the volume size and data area aligned to the erase block
+     */
+    virtual int format();
+    virtual int format(const FATFormatOptions &options);
+    
+    /**
+     * Opens a directory on the filesystem
+     */
+    virtual DirHandle *opendir(const char *name);
+    virtual int open(DirHandle **dir, const char *name);
+    
+    /**
+     * Creates a directory path
+     */
+    virtual int mkdir(const char *name, mode_t mode);
+    
+    /**
+     * Mounts the filesystem
+     */
+    virtual int mount();
+    
+    /**
+     * Unmounts the filesystem
+     */
+    virtual int unmount();
+
+    virtual int disk_initialize() { return 0; }
+    virtual int disk_status() { return 0; }
+    virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
+    virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) = 0;
+    virtual int disk_sync() { return 0; }
+    virtual int disk_trim(uint32_t /*sector*/, uint32_t /*count*/) { return 0; }   // Sectors no longer in use, may be erased
+    virtual uint32_t disk_sectors() = 0;
+    virtual uint32_t disk_block_size() { return 1; }   // Erase block size in sectors, 1 when not known
+
+};
+
+#endif
@@ -0,0 +1,87 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_FATHANDLEPOOL_H
+#define MBED_FATHANDLEPOOL_H
+
+#include <new>
+#include "mbed.h"
+#include "rtos.h"
+
+/** Usage counters of a FATHandlePool */
+struct FATHandleStats {
+    uint32_t open;      // Handles currently open
+    uint32_t peak;      // Most handles open at the same time
+    uint32_t failed;    // Opens refused because every slot was in use
+};
+
+/** Fixed capacity storage for file and directory handles
+ *
+ *  Handles are constructed in place in an rtos::MemoryPool, so opening and
+ *  closing files never touches the heap.
+ */
+template<typename T, uint32_t N>
+class FATHandlePool {
+public:
+    FATHandlePool() {
+        _stats.open = _stats.peak = _stats.failed = 0;
+    }
+
+    /** Take a free slot for a handle
+     *
+     *  @returns storage to placement-construct a T in, or NULL if the pool is empty
+     */
+    void *alloc() {
+        T *slot = _pool.alloc();
+        __disable_irq();
+        if (slot) {
+            if (++_stats.open > _stats.peak) {
+                _stats.peak = _stats.open;
+            }
+        } else {
+            _stats.failed++;
+        }
+        __enable_irq();
+        return slot;
+    }
+
+    /** Destroy a handle and give its slot back to the pool */
+    void release(T *handle) {
+        handle->~T();
+        _pool.free(handle);
+        __disable_irq();
+        _stats.open--;
+        __enable_irq();
+    }
+
+    FATHandleStats stats() {
+        __disable_irq();
+        FATHandleStats s = _stats;
+        __enable_irq();
+        return s;
+    }
+
+private:
+    rtos::MemoryPool<T, N> _pool;
+    FATHandleStats _stats;
+};
+
+#endif
@@ -11,65 +11,117 @@
 namespace mbed
 {
 
+    /** RAM disk for a second, fast volume next to an SD card
+     *
+     * Sectors are malloced as they are first written with non-zero data, so
+     * an empty or sparse volume only costs the sector pointer table. The
+     * volume has to be formatted before it is mounted:
+     *
+     * @code
+     * MemFileSystem ram("ram", 256);  // up to 128 kB
+     * ram.format();
+     * FILE *fp = fopen("/ram/hot.bin", "w");
+     * @endcode
+     */
     class MemFileSystem : public FATFileSystem
     {
     public:
-    
-        // 2000 sectors, each 512 bytes (malloced as required)
-        char *sectors[2000];
-    
-        MemFileSystem(const char* name) : FATFileSystem(name) {
-            memset(sectors, 0, sizeof(sectors));
+
+        // Each sector is 512 bytes (malloced as required), f_mkfs needs at least 128
+        MemFileSystem(const char* name, uint32_t sectors = 128) : FATFileSystem(name) {
+            _count = sectors;
+            _sectors = new char*[sectors];
+            memset(_sectors, 0, sectors * sizeof(char*));
         }
-    
+
         virtual ~MemFileSystem() {
-            for(int i = 0; i < 2000; i++) {
-                if(sectors[i]) {
-                    free(sectors[i]);
+            for(uint32_t i = 0; i < _count; i++) {
+                if(_sectors[i]) {
+                    free(_sectors[i]);
                 }
             }
+            delete[] _sectors;
         }
-    
-        // read a sector in to the buffer, return 0 if ok
-        virtual int disk_read(char *buffer, int sector) {
-            if(sectors[sector] == 0) {
-                // nothing allocated means sector is empty
-                memset(buffer, 0, 512);
-            } else {
-                memcpy(buffer, sectors[sector], 512);
+
+        // no partition table, it would take 63 sectors of a small RAM disk
+        using FATFileSystem::format;
+        virtual int format() {
+            FATFormatOptions options;
+            options.partition = false;
+            return FATFileSystem::format(options);
+        }
+
+        // read sectors in to the buffer, return 0 if ok
+        virtual int disk_read(uint8_t *buffer, uint32_t sector, uint32_t count) {
+            if(sector + count > _count) {
+                return 1;
+            }
+            for(uint32_t i = 0; i < count; i++, buffer += 512) {
+                if(_sectors[sector + i] == 0) {
+                    // nothing allocated means sector is empty
+                    memset(buffer, 0, 512);
+                } else {
+                    memcpy(buffer, _sectors[sector + i], 512);
+                }
             }
             return 0;
         }
-    
-        // write a sector from the buffer, return 0 if ok
-        virtual int disk_write(const char *buffer, int sector) {
-            // if buffer is zero deallocate sector
-            char zero[512];
-            memset(zero, 0, 512);
-            if(memcmp(zero, buffer, 512)==0) {
-                if(sectors[sector] != 0) {
-                    free(sectors[sector]);
-                    sectors[sector] = 0;
+
+        // write sectors from the buffer, return 0 if ok
+        virtual int disk_write(const uint8_t *buffer, uint32_t sector, uint32_t count) {
+            if(sector + count > _count) {
+                return 1;
+            }
+            for(uint32_t i = 0; i < count; i++, buffer += 512) {
+                char **sec = &_sectors[sector + i];
+                // if buffer is zero deallocate sector
+                int n = 0;
+                while(n < 512 && buffer[n] == 0) {
+                    n++;
+                }
+                if(n == 512) {
+                    if(*sec != 0) {
+                        free(*sec);
+                        *sec = 0;
+                    }
+                    continue;
                 }
-                return 0;
+                // else allocate a sector if needed, and write
+                if(*sec == 0) {
+                    *sec = (char*)malloc(512);
+                    if(*sec == 0) {
+                        return 1; // out of memory
+                    }
+                }
+                memcpy(*sec, buffer, 512);
+            }
+            return 0;
+        }
+
+        // free the sectors, they read back as zeros like never written ones
+        virtual int disk_trim(uint32_t sector, uint32_t count) {
+            if(sector + count > _count) {
+                return 1;
             }
-            // else allocate a sector if needed, and write
-            if(sectors[sector] == 0) {
-                char *sec = (char*)malloc(512);
-                if(sec==0) {
-                    return 1; // out of memory
+            for(uint32_t i = sector; i < sector + count; i++) {
+                if(_sectors[i]) {
+                    free(_sectors[i]);
+                    _sectors[i] = 0;
                 }
-                sectors[sector] = sec;
             }
-            memcpy(sectors[sector], buffer, 512);
             return 0;
         }
-    
+
         // return the number of sectors
-        virtual int disk_sectors() {
-            return sizeof(sectors)/sizeof(sectors[0]);
+        virtual uint32_t disk_sectors() {
+            return _count;
         }
-    
+
+    protected:
+
+        char **_sectors;
+        uint32_t _count;
+
     };
 
 }
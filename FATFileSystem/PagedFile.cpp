@@ -0,0 +1,236 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mbed_debug.h"
+
+#include "PagedFile.h"
+
+PagedFile::PagedFile(uint32_t pages) : _file(NULL) {
+    _nframes = pages ? pages : 1;
+    _frames = new Frame[_nframes];
+    _data = new uint8_t[_nframes * PAGEDFILE_PAGE_SIZE];
+    _size = _npages = 0;
+    _writable = false;
+    _hand = 0;
+}
+
+PagedFile::~PagedFile() {
+    close();
+    delete[] _frames;
+    delete[] _data;
+}
+
+int PagedFile::open(FATFileSystem &fs, const char *name, bool writable) {
+    close();
+    _file = static_cast<FATFileHandle*>(fs.open(name, writable ? O_RDWR : O_RDONLY));
+    if (_file == NULL) {
+        return -1;
+    }
+    // a fragmented file beyond the link map still works, just with slower seeks
+    if (_file->fast_seek(_linkmap, PAGEDFILE_LINKMAP)) {
+        debug_if(FFS_DBG, "PagedFile %s: too fragmented for fast seek\n", name);
+    }
+
+    _size = _file->flen();
+    _npages = (_size + PAGEDFILE_PAGE_SIZE - 1) / PAGEDFILE_PAGE_SIZE;
+    _writable = writable;
+    for (uint32_t i = 0; i < _nframes; i++) {
+        _frames[i].page = NO_PAGE;
+        _frames[i].pins = 0;
+        _frames[i].ref = false;
+        _frames[i].dirty = false;
+    }
+    _hand = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    return 0;
+}
+
+int PagedFile::close() {
+    if (_file == NULL) {
+        return 0;
+    }
+    int res = flush();
+    if (_file->close()) {
+        res = -1;
+    }
+    _file = NULL;
+    return res;
+}
+
+int PagedFile::read(uint32_t offset, void *buffer, uint32_t length) {
+    if (offset >= _size) {
+        return 0;
+    }
+    if (length > _size - offset) {
+        length = _size - offset;
+    }
+    uint8_t *dst = (uint8_t*)buffer;
+    uint32_t done = 0;
+    while (done < length) {
+        uint32_t page = (offset + done) / PAGEDFILE_PAGE_SIZE;
+        uint32_t ofs = (offset + done) % PAGEDFILE_PAGE_SIZE;
+        uint32_t n = PAGEDFILE_PAGE_SIZE - ofs;
+        if (n > length - done) {
+            n = length - done;
+        }
+        uint8_t *p = pin(page);
+        if (p == NULL) {
+            return done ? (int)done : -1;
+        }
+        memcpy(dst + done, p + ofs, n);
+        unpin(page);
+        done += n;
+    }
+    return done;
+}
+
+int PagedFile::write(uint32_t offset, const void *buffer, uint32_t length) {
+    if (!_writable || offset + length > _size || offset + length < offset) {
+        return -1;
+    }
+    const uint8_t *src = (const uint8_t*)buffer;
+    uint32_t done = 0;
+    while (done < length) {
+        uint32_t page = (offset + done) / PAGEDFILE_PAGE_SIZE;
+        uint32_t ofs = (offset + done) % PAGEDFILE_PAGE_SIZE;
+        uint32_t n = PAGEDFILE_PAGE_SIZE - ofs;
+        if (n > length - done) {
+            n = length - done;
+        }
+        uint8_t *p = pin(page);
+        if (p == NULL) {
+            return done ? (int)done : -1;
+        }
+        memcpy(p + ofs, src + done, n);
+        unpin(page, true);
+        done += n;
+    }
+    return done;
+}
+
+uint8_t *PagedFile::pin(uint32_t page) {
+    if (_file == NULL || page >= _npages) {
+        return NULL;
+    }
+    int f = _find(page);
+    if (f >= 0) {
+        _stats.hits++;
+    } else {
+        f = _victim();
+        if (f < 0 || _load(f, page)) {
+            return NULL;
+        }
+        _stats.misses++;
+    }
+    _frames[f].pins++;
+    _frames[f].ref = true;
+    return _data + f * PAGEDFILE_PAGE_SIZE;
+}
+
+void PagedFile::unpin(uint32_t page, bool dirty) {
+    int f = _find(page);
+    if (f < 0 || _frames[f].pins == 0) {
+        return;
+    }
+    _frames[f].pins--;
+    if (dirty && _writable) {
+        _frames[f].dirty = true;
+    }
+}
+
+int PagedFile::flush() {
+    int res = 0;
+    for (uint32_t i = 0; i < _nframes; i++) {
+        if (_writeback(i)) {
+            res = -1;
+        }
+    }
+    if (_file && _writable && _file->fsync()) {
+        res = -1;
+    }
+    return res;
+}
+
+// Frame holding a page, -1 if it is not in the pool
+int PagedFile::_find(uint32_t page) {
+    for (uint32_t i = 0; i < _nframes; i++) {
+        if (_frames[i].page == page) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Clock sweep: skip pinned frames, give referenced ones a second chance
+int PagedFile::_victim() {
+    for (uint32_t n = 0; n < 2 * _nframes; n++) {
+        uint32_t i = _hand;
+        _hand = (_hand + 1) % _nframes;
+        Frame &fr = _frames[i];
+        if (fr.pins) {
+            continue;
+        }
+        if (fr.ref) {
+            fr.ref = false;
+            continue;
+        }
+        if (_writeback(i)) {
+            return -1;
+        }
+        fr.page = NO_PAGE;
+        return i;
+    }
+    debug_if(FFS_DBG, "PagedFile: all %d frames pinned\n", _nframes);
+    return -1;
+}
+
+int PagedFile::_load(int frame, uint32_t page) {
+    uint8_t *p = _data + frame * PAGEDFILE_PAGE_SIZE;
+    _frames[frame].page = NO_PAGE;
+    if (_file->lseek(page * PAGEDFILE_PAGE_SIZE, SEEK_SET) < 0) {
+        return -1;
+    }
+    ssize_t n = _file->read(p, PAGEDFILE_PAGE_SIZE);
+    if (n < 0) {
+        return -1;
+    }
+    memset(p + n, 0, PAGEDFILE_PAGE_SIZE - n);
+    _frames[frame].page = page;
+    _frames[frame].pins = 0;
+    _frames[frame].ref = false;
+    _frames[frame].dirty = false;
+    return 0;
+}
+
+int PagedFile::_writeback(int frame) {
+    Frame &fr = _frames[frame];
+    if (!fr.dirty) {
+        return 0;
+    }
+    uint32_t ofs = fr.page * PAGEDFILE_PAGE_SIZE;
+    uint32_t n = _size - ofs < PAGEDFILE_PAGE_SIZE ? _size - ofs : PAGEDFILE_PAGE_SIZE;
+    if (_file->lseek(ofs, SEEK_SET) < 0 || _file->write(_data + frame * PAGEDFILE_PAGE_SIZE, n) != (ssize_t)n) {
+        return -1;
+    }
+    fr.dirty = false;
+    _stats.writebacks++;
+    return 0;
+}
@@ -0,0 +1,159 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_PAGEDFILE_H
+#define MBED_PAGEDFILE_H
+
+#include "FATFileSystem.h"
+#include "FATFileHandle.h"
+
+#define PAGEDFILE_PAGE_SIZE 512
+#define PAGEDFILE_LINKMAP   16      // Cluster link map entries, enough for 7 fragments
+
+/** Cache counters of a PagedFile */
+struct PagedFileStats {
+    uint32_t hits;          // Pages found in the pool
+    uint32_t misses;        // Pages read because they were not
+    uint32_t writebacks;    // Dirty pages written back
+};
+
+/** Random access to a large file through a small pool of cached pages
+ *
+ *  The file is split into 512-byte pages. A page is read into one of the
+ *  frames of the pool the first time it is used and stays there until the
+ *  clock hand picks it for eviction: every frame has a reference bit which
+ *  is set on use and cleared as the hand passes, and the first unpinned frame
+ *  found with the bit clear is reused. Pages are read only when
+ *  they are used: the card is read one block per command and pin() waits
+ *  for the read, so reading ahead would only read the same blocks sooner.
+ *  The file is opened in fast seek mode, so jumping to a page never reads
+ *  the FAT.
+ *
+ *  pin() hands out a page to use in place. The frame stays put until the
+ *  matching unpin(), which also tells whether the page was changed. Writes
+ *  go back to the file on eviction or flush(), and cannot make it longer.
+ *  A PagedFile is not locked against use from several threads.
+ *
+ *  @code
+ *  PagedFile bank(4);                  // 2kB of pages
+ *  bank.open(sd, "questions.bin");
+ *  bank.read(index * sizeof(q), &q, sizeof(q));
+ *
+ *  const uint8_t *page = bank.pin(7);
+ *  ...
+ *  bank.unpin(7);
+ *  @endcode
+ */
+class PagedFile {
+public:
+
+    /** Create the page pool
+     *
+     *  @param pages Number of frames, at least 1
+     */
+    PagedFile(uint32_t pages = 4);
+    ~PagedFile();
+
+    /** Open a file on a filesystem
+     *
+     *  @param fs Filesystem the file is on
+     *  @param name File name
+     *  @param writable Allow pages to be changed and written back
+     *  @returns 0 on success, -1 on failure
+     */
+    int open(FATFileSystem &fs, const char *name, bool writable = false);
+
+    /** Write back dirty pages and close the file
+     *
+     *  @returns 0 on success, -1 if a page could not be written
+     */
+    int close();
+
+    /** Copy bytes out of the file
+     *
+     *  @returns number of bytes read, less at the end of the file, -1 on failure
+     */
+    int read(uint32_t offset, void *buffer, uint32_t length);
+
+    /** Copy bytes into the file, within its current size
+     *
+     *  @returns number of bytes written, -1 on failure
+     */
+    int write(uint32_t offset, const void *buffer, uint32_t length);
+
+    /** Get a page to use in place, held in the pool until unpin()
+     *
+     *  Bytes past the end of the file read as 0 in the last page.
+     *
+     *  @param page Page number, offset / 512
+     *  @returns the 512 bytes of the page, NULL if it is past the end of the
+     *           file, cannot be read or every frame is pinned
+     */
+    uint8_t *pin(uint32_t page);
+
+    /** Release a page taken with pin()
+     *
+     *  @param page Page number given to pin()
+     *  @param dirty The page was changed and has to be written back
+     */
+    void unpin(uint32_t page, bool dirty = false);
+
+    /** Write back all dirty pages
+     *
+     *  @returns 0 on success, -1 on failure
+     */
+    int flush();
+
+    /** Size of the file in bytes */
+    uint32_t size() { return _size; }
+
+    /** Cache counters since open() */
+    const PagedFileStats &stats() { return _stats; }
+
+protected:
+
+    struct Frame {
+        uint32_t page;      // Page held, NO_PAGE if none
+        uint16_t pins;      // Outstanding pin() calls
+        bool ref;           // Used since the clock hand last passed
+        bool dirty;
+    };
+    static const uint32_t NO_PAGE = 0xFFFFFFFF;
+
+    int _find(uint32_t page);
+    int _victim();
+    int _load(int frame, uint32_t page);
+    int _writeback(int frame);
+
+    FATFileHandle *_file;
+    uint32_t _size;
+    uint32_t _npages;       // Pages in the file
+    bool _writable;
+
+    uint32_t _nframes;
+    uint32_t _hand;         // Clock hand, next frame to look at
+    Frame *_frames;
+    uint8_t *_data;         // _nframes pages
+    DWORD _linkmap[PAGEDFILE_LINKMAP];
+    PagedFileStats _stats;
+};
+
+#endif
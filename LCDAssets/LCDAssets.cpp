@@ -0,0 +1,214 @@
+#include "LCDAssets.h"
+#include "uLCD_4DGL.h"
+#include "SDCRC.h"
+#include "mbed_debug.h"
+
+#define LCDASSETS_DBG   0
+#define LCDASSETS_ENTRY 32      // bytes of an entry in the manifest sector
+
+// The manifest is big-endian like everything else on the screen's card:
+// "LCDA", count, CRC16 of the entries, next free sector, 4 spare bytes, then
+// the entries as name, sector, width, height, crc, sectors, length.
+typedef char lcdassets_manifest_size[16 + LCDASSETS_MAX * LCDASSETS_ENTRY <= 512 ? 1 : -1];
+
+static void put16(char *p, uint32_t v) {
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+static void put32(char *p, uint32_t v) {
+    put16(p, v >> 16);
+    put16(p + 2, v);
+}
+
+static uint32_t get16(const char *p) {
+    return ((uint8_t)p[0] << 8) | (uint8_t)p[1];
+}
+
+static uint32_t get32(const char *p) {
+    return (get16(p) << 16) | get16(p + 2);
+}
+
+LCDAssets::LCDAssets(uLCD_4DGL &lcd, uint32_t base) : _lcd(lcd), _base(base) {
+    _next = base + 1;
+    _uploaded = 0;
+    _mounted = false;
+    _count = 0;
+}
+
+int LCDAssets::mount() {
+    _mounted = false;
+    _uploaded = 0;
+    if (_lcd.media_init() == 0) {
+        debug_if(LCDASSETS_DBG, "LCDAssets: no card in the screen\n");
+        return -1;
+    }
+    _mounted = true;
+    if (_read_manifest()) {
+        debug_if(LCDASSETS_DBG, "LCDAssets: no manifest at sector %d, starting empty\n", _base);
+        _count = 0;
+        _next = _base + 1;
+    }
+    return _count;
+}
+
+const LCDAsset *LCDAssets::find(const char *name) {
+    return _find(name);
+}
+
+LCDAsset *LCDAssets::_find(const char *name) {
+    for (int i = 0; i < _count; i++) {
+        if (strncmp(_assets[i].name, name, LCDASSETS_NAME_LEN) == 0) {
+            return &_assets[i];
+        }
+    }
+    return NULL;
+}
+
+int LCDAssets::add(const char *name, const char *path, int width, int height) {
+    if (!_mounted || strlen(name) > LCDASSETS_NAME_LEN || width < 1 || height < 1) {
+        return -1;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    // checksum the file, an unchanged image is not sent again
+    char *buf = new char[512];
+    uint32_t length = 2 * width * height;
+    uint32_t n = 0;
+    uint16_t crc = 0;
+    size_t got;
+    while ((got = fread(buf, 1, 512, fp)) > 0) {
+        crc = sd_crc16((const uint8_t*)buf, got, crc);
+        n += got;
+    }
+    LCDAsset *a = _find(name);
+    int res = -1;
+    if (n != length) {
+        debug_if(LCDASSETS_DBG, "LCDAssets: %s is %d bytes, not %dx%d pixels\n", path, n, width, height);
+    } else if (a && a->width == width && a->height == height && a->length == length && a->crc == crc) {
+        res = 0;
+    } else if (a || _count < LCDASSETS_MAX) {
+        if (a == NULL) {
+            a = &_assets[_count++];
+            memset(a, 0, sizeof(*a));
+            strncpy(a->name, name, LCDASSETS_NAME_LEN);
+        }
+        // written over the old image if it fits, else after the last one
+        uint32_t sectors = (6 + length + 511) / 512;
+        if (a->sectors < sectors) {
+            a->sector = _next;
+            a->sectors = sectors;
+            _next += sectors;
+        }
+        a->length = 0;          // stays 0 if the upload fails, so it is tried again
+
+        // a 4D raw image: width, height, 16-bit colour mode, then the pixels
+        rewind(fp);
+        put16(buf, width);
+        put16(buf + 2, height);
+        buf[4] = 0x10;
+        buf[5] = 0x00;
+        int fill = 6;
+        res = 1;
+        for (uint32_t s = 0; res == 1 && s < sectors; s++) {
+            got = fread(buf + fill, 1, 512 - fill, fp);
+            memset(buf + fill + got, 0, 512 - fill - got);
+            if (_write(a->sector + s, buf)) {
+                res = -1;
+            }
+            fill = 0;
+        }
+        if (res == 1) {
+            a->width = width;
+            a->height = height;
+            a->crc = crc;
+            a->length = length;
+        }
+        if (_write_manifest()) {
+            res = -1;
+        }
+        debug_if(LCDASSETS_DBG, "LCDAssets: %s to sector %d: %d\n", name, a->sector, res);
+    }
+    delete[] buf;
+    fclose(fp);
+    return res;
+}
+
+int LCDAssets::show(const char *name, int x, int y) {
+    const LCDAsset *a = find(name);
+    if (!_mounted || a == NULL || a->length == 0) {
+        return -1;
+    }
+    _lcd.set_sector_address(a->sector >> 16, a->sector & 0xFFFF);
+    _lcd.display_image(x, y);
+    return 0;
+}
+
+int LCDAssets::_write(uint32_t sector, const char *data) {
+    _lcd.set_sector_address(sector >> 16, sector & 0xFFFF);
+    _uploaded += 7 + 514;
+    return _lcd.write_sector(data) ? 0 : -1;
+}
+
+// read word by word, the screen has no command that returns a whole sector
+int LCDAssets::_read_manifest() {
+    char buf[16 + LCDASSETS_MAX * LCDASSETS_ENTRY];
+    uint32_t addr = _base * 512;
+    _lcd.set_byte_address(addr >> 16, addr & 0xFFFF);
+    for (int i = 0; i < 16; i += 2) {
+        put16(buf + i, _lcd.read_word());
+    }
+    int count = get16(buf + 4);
+    if (memcmp(buf, "LCDA", 4) || count > LCDASSETS_MAX) {
+        return -1;
+    }
+    char *entries = buf + 16;
+    for (int i = 0; i < count * LCDASSETS_ENTRY; i += 2) {
+        put16(entries + i, _lcd.read_word());
+    }
+    if (get16(buf + 6) != sd_crc16((const uint8_t*)entries, count * LCDASSETS_ENTRY)) {
+        return -1;
+    }
+
+    _count = count;
+    _next = get32(buf + 8);
+    for (int i = 0; i < count; i++) {
+        const char *e = entries + i * LCDASSETS_ENTRY;
+        LCDAsset &a = _assets[i];
+        memcpy(a.name, e, LCDASSETS_NAME_LEN);
+        a.sector = get32(e + 16);
+        a.width = get16(e + 20);
+        a.height = get16(e + 22);
+        a.crc = get16(e + 24);
+        a.sectors = get16(e + 26);
+        a.length = get32(e + 28);
+    }
+    return 0;
+}
+
+int LCDAssets::_write_manifest() {
+    char *buf = new char[512];
+    memset(buf, 0, 512);
+    char *entries = buf + 16;
+    for (int i = 0; i < _count; i++) {
+        char *e = entries + i * LCDASSETS_ENTRY;
+        const LCDAsset &a = _assets[i];
+        memcpy(e, a.name, LCDASSETS_NAME_LEN);
+        put32(e + 16, a.sector);
+        put16(e + 20, a.width);
+        put16(e + 22, a.height);
+        put16(e + 24, a.crc);
+        put16(e + 26, a.sectors);
+        put32(e + 28, a.length);
+    }
+    memcpy(buf, "LCDA", 4);
+    put16(buf + 4, _count);
+    put16(buf + 6, sd_crc16((const uint8_t*)entries, _count * LCDASSETS_ENTRY));
+    put32(buf + 8, _next);
+    int err = _write(_base, buf);
+    delete[] buf;
+    return err;
+}
@@ -0,0 +1,99 @@
+#ifndef LCDASSETS_H
+#define LCDASSETS_H
+
+#include "mbed.h"
+#include <stdint.h>
+
+class uLCD_4DGL;            // its header has no include guard, the user includes it
+
+#define LCDASSETS_NAME_LEN  16
+#define LCDASSETS_MAX       15      // entries that fit in the manifest sector
+
+/** An image kept on the screen's own card, one entry of the manifest */
+struct LCDAsset {
+    char name[LCDASSETS_NAME_LEN];      // zero padded, not always terminated
+    uint32_t sector;                    // first sector of the image on the card
+    uint16_t width;
+    uint16_t height;
+    uint16_t crc;                       // CRC16 of the RGB565 pixels as uploaded
+    uint16_t sectors;                   // sectors kept for the image
+    uint32_t length;                    // bytes of pixels
+};
+
+/** Images stored on the uLCD's microSD card and drawn by the screen itself
+ *
+ * Drawing from the screen's card costs two short commands (the sector
+ * address and display_image) however big the image is, where sending the
+ * pixels takes seconds at 9600 baud. The card is used raw, from a base
+ * sector on: the base sector holds a manifest of names, places, sizes and
+ * checksums, the images follow it as 4D raw images (a 6-byte header, then
+ * the pixels), each starting on a sector.
+ *
+ * add() checksums the file first and only uploads it when the manifest has
+ * nothing under that name with the same size and checksum, so calling it
+ * for every asset at boot costs an SD read per asset once they are there.
+ * A changed image is written over the old one when it fits, otherwise at
+ * the end; the old space is not reused.
+ *
+ * The images are RGB565 files from tools/rgb565.py. Uploading writes whole
+ * sectors and waits for each, do it before the game starts.
+ *
+ * @code
+ * LCDAssets assets(LCD);
+ * assets.mount();
+ * assets.add("board", "/sd/board.565", 128, 128);
+ * ...
+ * assets.show("board", 0, 0);
+ * @endcode
+ */
+class LCDAssets {
+public:
+
+    /** @param base First sector of the card to use, the manifest goes there */
+    LCDAssets(uLCD_4DGL &lcd, uint32_t base = 0);
+
+    /** Start the screen's card and read the manifest
+     *
+     * A card without a valid manifest counts as empty, the first add()
+     * writes a new one.
+     * @returns the number of images on the card, -1 without a card
+     */
+    int mount();
+
+    /** Upload an image unless the card has it already
+     *
+     * @param name Name to show it by, up to LCDASSETS_NAME_LEN characters
+     * @param path RGB565 file, width * height pixels, high byte first
+     * @returns 1 if uploaded, 0 if it was there already, -1 on failure
+     */
+    int add(const char *name, const char *path, int width, int height);
+
+    /** Draw an image with its top left corner at x, y
+     *
+     * @returns 0, or -1 if there is no image of that name
+     */
+    int show(const char *name, int x, int y);
+
+    /** The manifest entry of an image, NULL if there is none */
+    const LCDAsset *find(const char *name);
+
+    /** Bytes sent to the screen by add() since mount(), for uploads and manifests */
+    uint32_t uploaded() { return _uploaded; }
+
+protected:
+
+    LCDAsset *_find(const char *name);
+    int _write(uint32_t sector, const char *data);
+    int _read_manifest();
+    int _write_manifest();
+
+    uLCD_4DGL &_lcd;
+    uint32_t _base;
+    uint32_t _next;             // first sector after the last image
+    uint32_t _uploaded;
+    bool _mounted;
+    int _count;
+    LCDAsset _assets[LCDASSETS_MAX];
+};
+
+#endif
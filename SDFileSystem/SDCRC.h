@@ -0,0 +1,44 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_SDCRC_H
+#define MBED_SDCRC_H
+
+#include <stdint.h>
+
+/** CRC7 of an SD command frame (polynomial x^7 + x^3 + 1)
+ *
+ * @returns the CRC in bits 7:1 with the end bit set, ready to send as the
+ *          last byte of the command
+ */
+uint8_t sd_crc7(const uint8_t *data, uint32_t length);
+
+/** CRC16-CCITT of an SD data block (polynomial x^16 + x^12 + x^5 + 1)
+ *
+ * Processes four bytes per step (slicing-by-4), a 512-byte block costs
+ * 128 steps of four table lookups.
+ *
+ * @param crc CRC of the data before this part, to checksum data that
+ *            comes in pieces
+ */
+uint16_t sd_crc16(const uint8_t *data, uint32_t length, uint16_t crc = 0);
+
+#endif
@@ -63,7 +63,8 @@
  * You can read and write single blocks (CMD17, CMD25) or multiple blocks
  * (CMD18, CMD25). For simplicity, I'll just use single block accesses. When
  * the card gets a read command, it responds with a response token, and then
- * a data token or an error.
+ * a data token or an error. Writes of more than one block are the exception,
+ * see below.
  *
  * SPI Command Format
  * ------------------
@@ -111,16 +112,69 @@
  * +------+---------+---------+- -  - -+---------+-----------+----------+
  * | 0xFE | data[0] | data[1] |        | data[n] | crc[15:8] | crc[7:0] |
  * +------+---------+---------+- -  - -+---------+-----------+----------+
+ *
+ * CRC Mode
+ * --------
+ *
+ * CRCs are ignored by the card in SPI mode until CMD59 turns them on. The
+ * command CRC is always computed, so CMD0 and CMD8 go out with the right one.
+ * With CRC mode on, a command with a bad CRC gets R1_COM_CRC_ERROR, a written
+ * block with a bad CRC gets the 101 data response, and the host checks the
+ * CRC of every block it reads. Each case is retried.
+ *
+ * Multiple Block Write and Erase
+ * ------------------------------
+ *
+ * When FatFs writes several sectors at once they go out as one CMD25, each
+ * block with a 0xFC start token and the whole write ended by a 0xFD stop
+ * token. ACMD23 before it tells the card how many blocks are coming so it
+ * can erase them up front. If a block is rejected, the write is stopped and
+ * the rest is sent as single blocks, with their usual retries.
+ *
+ * Blocks that are no longer used are erased with CMD32 (first block), CMD33
+ * (last block) and CMD38, which answers R1b and holds the card busy until
+ * the erase is done. Erased blocks are cheap to write again later.
+ * Version 1 cards without ERASE_BLK_EN in the CSD erase whole erase sectors
+ * only, so erase() keeps to the sectors that lie inside the range.
  */
 #include "SDFileSystem.h"
+#include "SDCRC.h"
 #include "mbed_debug.h"
 
 #define SD_COMMAND_TIMEOUT 5000
 
+#define SD_CRC_RETRIES     3
+
+// The card has 1s to finish its power up after the first ACMD41, give it 2s
+#define SD_INIT_TIMEOUT_MS  2000
+// ACMD41 polling interval, doubled after every poll up to the maximum
+#define SD_INIT_POLL_MIN_US 250
+#define SD_INIT_POLL_MAX_US 20000
+
+// Waiting for the card: poll flat out for SD_BUSY_SPIN_US, then let other
+// threads run, sleeping 1ms, 2ms, 4ms... up to SD_BUSY_SLEEP_MAX_MS between
+// polls. Reads get 100ms and writes 250ms (500ms for SDHC) in the spec.
+#define SD_BUSY_SPIN_US      500
+#define SD_BUSY_SLEEP_MAX_MS 8
+#define SD_READ_TIMEOUT_MS   200
+#define SD_WRITE_TIMEOUT_MS  600
+
+// Erases go out in chunks of up to 32MB, each allowed this long
+#define SD_ERASE_CHUNK       65536
+#define SD_ERASE_TIMEOUT_MS  10000
+
 #define SD_DBG             0
 
 SDFileSystem::SDFileSystem(PinName mosi, PinName miso, PinName sclk, PinName cs, const char* name) :
     FATFileSystem(name), _spi(mosi, miso, sclk), _cs(cs), _is_initialized(0) {
+    _sectors = 0;
+    _erase_sectors = 1;
+    _erase_group = 1;
+    _erase_blk = false;
+    _crc_on = false;
+    _crc = false;
+    _crc_errors = 0;
+    reset_busy_stats();
     _cs = 1;
 
     // Set default to 100kHz for initialisation and 1MHz for data transfer
@@ -172,14 +226,37 @@ int SDFileSystem::initialise_card() {
     }
 }
 
-int SDFileSystem::initialise_card_v1() {
-    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
+// Send ACMD41 until the card leaves the idle state. Most cards are ready
+// within a few hundred ms, so poll often at first and back off from there.
+int SDFileSystem::_acmd41(int arg) {
+    Timer timer;
+    timer.start();
+    int delay = SD_INIT_POLL_MIN_US;
+    while (timer.read_ms() < SD_INIT_TIMEOUT_MS) {
         _cmd(55, 0);
-        if (_cmd(41, 0) == 0) {
-            cdv = 512;
-            debug_if(SD_DBG, "\n\rInit: SEDCARD_V1\n\r");
-            return SDCARD_V1;
+        if (_cmd(41, arg) == 0) {
+            debug_if(SD_DBG, "ACMD41 ready after %d ms\n", timer.read_ms());
+            return 0;
+        }
+        // sleep rather than spin once the delay reaches the RTOS tick, so the
+        // other boot threads get the CPU while the card powers up
+        if (delay < 1000) {
+            wait_us(delay);
+        } else {
+            Thread::wait(delay / 1000);
         }
+        if (delay < SD_INIT_POLL_MAX_US) {
+            delay *= 2;
+        }
+    }
+    return -1;
+}
+
+int SDFileSystem::initialise_card_v1() {
+    if (_acmd41(0) == 0) {
+        cdv = 512;
+        debug_if(SD_DBG, "\n\rInit: SEDCARD_V1\n\r");
+        return SDCARD_V1;
     }
 
     debug("Timeout waiting for v1.x card\n");
@@ -187,16 +264,11 @@ int SDFileSystem::initialise_card_v1() {
 }
 
 int SDFileSystem::initialise_card_v2() {
-    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
-        wait_ms(50);
+    if (_acmd41(0x40000000) == 0) {
         _cmd58();
-        _cmd(55, 0);
-        if (_cmd(41, 0x40000000) == 0) {
-            _cmd58();
-            debug_if(SD_DBG, "\n\rInit: SDCARD_V2\n\r");
-            cdv = 1;
-            return SDCARD_V2;
-        }
+        debug_if(SD_DBG, "\n\rInit: SDCARD_V2\n\r");
+        cdv = 1;
+        return SDCARD_V2;
     }
 
     debug("Timeout waiting for v2.x card\n");
@@ -204,12 +276,22 @@ int SDFileSystem::initialise_card_v2() {
 }
 
 int SDFileSystem::disk_initialize() {
+    _crc = false;
     _is_initialized = initialise_card();
     if (_is_initialized == 0) {
         debug("Fail to initialize card\n");
         return 1;
     }
     debug_if(SD_DBG, "init card = %d\n", _is_initialized);
+
+    // Turn on CRC checking (CMD59) before the first data block
+    if (_crc_on) {
+        if (_cmd(59, 1) == 0) {
+            _crc = true;
+        } else {
+            debug("Card refused CRC mode\n");
+        }
+    }
     _sectors = _sd_sectors();
 
     // Set block length to 512 (CMD16)
@@ -220,6 +302,12 @@ int SDFileSystem::disk_initialize() {
 
     // Set SCK for data transfer
     _spi.frequency(_transfer_sck);
+
+    // Prefer the allocation unit from the SD status over the CSD erase sector
+    uint32_t au = _sd_au_size();
+    if (au) {
+        _erase_sectors = au;
+    }
     return 0;
 }
 
@@ -227,15 +315,23 @@ int SDFileSystem::disk_write(const uint8_t* buffer, uint32_t block_number, uint3
     if (!_is_initialized) {
         return -1;
     }
+
+    // stream several blocks at once, anything not accepted goes one by one
+    if (count > 1) {
+        uint32_t done = _write_multiple(buffer, block_number, count);
+        buffer += done * 512;
+        block_number += done;
+        count -= done;
+    }
     
     for (uint32_t b = block_number; b < block_number + count; b++) {
-        // set write address for single block (CMD24)
-        if (_cmd(24, b * cdv) != 0) {
-            return 1;
+        // set write address for single block (CMD24) and send the data
+        // block, again if the card rejects it (CRC error)
+        for (int retry = 0; _cmd(24, b * cdv) != 0 || _write(buffer, 512) != 0; retry++) {
+            if (retry == SD_CRC_RETRIES) {
+                return 1;
+            }
         }
-        
-        // send the data block
-        _write(buffer, 512);
         buffer += 512;
     }
     
@@ -248,13 +344,13 @@ int SDFileSystem::disk_read(uint8_t* buffer, uint32_t block_number, uint32_t cou
     }
     
     for (uint32_t b = block_number; b < block_number + count; b++) {
-        // set read address for single block (CMD17)
-        if (_cmd(17, b * cdv) != 0) {
-            return 1;
+        // set read address for single block (CMD17) and receive the data,
+        // again if its CRC does not match
+        for (int retry = 0; _cmd(17, b * cdv) != 0 || _read(buffer, 512) != 0; retry++) {
+            if (retry == SD_CRC_RETRIES) {
+                return 1;
+            }
         }
-        
-        // receive the data
-        _read(buffer, 512);
         buffer += 512;
     }
 
@@ -270,52 +366,110 @@ int SDFileSystem::disk_status() {
     }
 }
 
+int SDFileSystem::disk_trim(uint32_t sector, uint32_t count) {
+    return erase(sector, count);
+}
+
+int SDFileSystem::erase(uint32_t block_number, uint32_t count) {
+    if (!_is_initialized) {
+        return -1;
+    }
+    if (block_number + count > _sectors || block_number + count < block_number) {
+        return 1;
+    }
+
+    // Without ERASE_BLK_EN the card erases whole erase sectors around the
+    // range, keep to the ones that lie entirely inside it
+    uint32_t chunk = SD_ERASE_CHUNK;
+    if (!_erase_blk && _erase_group > 1) {
+        uint32_t first = (block_number + _erase_group - 1) / _erase_group * _erase_group;
+        uint32_t end = (block_number + count) / _erase_group * _erase_group;
+        if (end <= first) {
+            return 0;
+        }
+        block_number = first;
+        count = end - first;
+        chunk -= chunk % _erase_group;
+    }
+
+    while (count) {
+        uint32_t n = count < chunk ? count : chunk;
+
+        // set the first (CMD32) and last (CMD33) block, then erase (CMD38)
+        if (_cmd(32, block_number * cdv) != 0 || _cmd(33, (block_number + n - 1) * cdv) != 0) {
+            return 1;
+        }
+        int response = _cmdx(38, 0);
+        if (response < 0) {
+            return 1;
+        }
+        // R1b, the card holds the line low until the erase is done
+        if (response == 0) {
+            response = _wait_while(0x00, SD_ERASE_TIMEOUT_MS) < 0 ? 1 : 0;
+        }
+        _cs = 1;
+        _spi.write(0xFF);
+        if (response != 0) {
+            debug("Erase of %d blocks at %d failed\n", n, block_number);
+            return 1;
+        }
+
+        block_number += n;
+        count -= n;
+    }
+    return 0;
+}
+
 int SDFileSystem::disk_sync() { return 0; }
 uint32_t SDFileSystem::disk_sectors() { return _sectors; }
+uint32_t SDFileSystem::disk_block_size() { return _erase_sectors; }
 
 
 // PRIVATE FUNCTIONS
-int SDFileSystem::_cmd(int cmd, int arg) {
-    _cs = 0;
+void SDFileSystem::_cmdframe(int cmd, int arg) {
+    uint8_t frame[5];
+    frame[0] = 0x40 | cmd;
+    frame[1] = arg >> 24;
+    frame[2] = arg >> 16;
+    frame[3] = arg >> 8;
+    frame[4] = arg >> 0;
 
     // send a command
-    _spi.write(0x40 | cmd);
-    _spi.write(arg >> 24);
-    _spi.write(arg >> 16);
-    _spi.write(arg >> 8);
-    _spi.write(arg >> 0);
-    _spi.write(0x95);
+    for (int i = 0; i < 5; i++) {
+        _spi.write(frame[i]);
+    }
+    _spi.write(sd_crc7(frame, 5));
+}
 
-    // wait for the repsonse (response[7] == 0)
-    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
-        int response = _spi.write(0xFF);
-        if (!(response & 0x80)) {
-            _cs = 1;
-            _spi.write(0xFF);
-            return response;
-        }
+int SDFileSystem::_cmd(int cmd, int arg) {
+    int response = _cmdx(cmd, arg);
+    if (response >= 0) {
+        _cs = 1;
+        _spi.write(0xFF);
     }
-    _cs = 1;
-    _spi.write(0xFF);
-    return -1; // timeout
+    return response;
 }
 int SDFileSystem::_cmdx(int cmd, int arg) {
-    _cs = 0;
-
-    // send a command
-    _spi.write(0x40 | cmd);
-    _spi.write(arg >> 24);
-    _spi.write(arg >> 16);
-    _spi.write(arg >> 8);
-    _spi.write(arg >> 0);
-    _spi.write(0x95);
-
-    // wait for the repsonse (response[7] == 0)
-    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
-        int response = _spi.write(0xFF);
-        if (!(response & 0x80)) {
+    for (int retry = 0; retry <= SD_CRC_RETRIES; retry++) {
+        _cs = 0;
+        _cmdframe(cmd, arg);
+
+        // wait for the repsonse (response[7] == 0)
+        int response = 0xFF;
+        for (int i = 0; i < SD_COMMAND_TIMEOUT && (response & 0x80); i++) {
+            response = _spi.write(0xFF);
+        }
+        if (response & 0x80) {
+            break; // timeout
+        }
+        if (!(response & R1_COM_CRC_ERROR)) {
             return response;
         }
+
+        // the command was corrupted on its way to the card, send it again
+        _crc_errors++;
+        _cs = 1;
+        _spi.write(0xFF);
     }
     _cs = 1;
     _spi.write(0xFF);
@@ -325,15 +479,9 @@ int SDFileSystem::_cmdx(int cmd, int arg) {
 
 int SDFileSystem::_cmd58() {
     _cs = 0;
-    int arg = 0;
 
     // send a command
-    _spi.write(0x40 | 58);
-    _spi.write(arg >> 24);
-    _spi.write(arg >> 16);
-    _spi.write(arg >> 8);
-    _spi.write(arg >> 0);
-    _spi.write(0x95);
+    _cmdframe(58, 0);
 
     // wait for the repsonse (response[7] == 0)
     for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
@@ -356,21 +504,16 @@ int SDFileSystem::_cmd58() {
 int SDFileSystem::_cmd8() {
     _cs = 0;
 
-    // send a command
-    _spi.write(0x40 | 8); // CMD8
-    _spi.write(0x00);     // reserved
-    _spi.write(0x00);     // reserved
-    _spi.write(0x01);     // 3.3v
-    _spi.write(0xAA);     // check pattern
-    _spi.write(0x87);     // crc
+    // send a command: CMD8, 3.3v, check pattern 0xAA
+    _cmdframe(8, 0x1AA);
 
     // wait for the repsonse (response[7] == 0)
-    for (int i = 0; i < SD_COMMAND_TIMEOUT * 1000; i++) {
+    for (int i = 0; i < SD_COMMAND_TIMEOUT; i++) {
         char response[5];
         response[0] = _spi.write(0xFF);
         if (!(response[0] & 0x80)) {
             for (int j = 1; j < 5; j++) {
-                response[i] = _spi.write(0xFF);
+                response[j] = _spi.write(0xFF);
             }
             _cs = 1;
             _spi.write(0xFF);
@@ -385,26 +528,36 @@ int SDFileSystem::_cmd8() {
 int SDFileSystem::_read(uint8_t *buffer, uint32_t length) {
     _cs = 0;
 
-    // read until start byte (0xFF)
-    while (_spi.write(0xFF) != 0xFE);
+    // read until start byte (0xFE), anything else is a data error token
+    int token = _wait_while(0xFF, SD_READ_TIMEOUT_MS);
+    if (token != 0xFE) {
+        _cs = 1;
+        _spi.write(0xFF);
+        return 1;
+    }
 
     // read data
     for (uint32_t i = 0; i < length; i++) {
         buffer[i] = _spi.write(0xFF);
     }
-    _spi.write(0xFF); // checksum
-    _spi.write(0xFF);
+    uint16_t crc = _spi.write(0xFF) << 8; // checksum
+    crc |= _spi.write(0xFF);
 
     _cs = 1;
     _spi.write(0xFF);
+
+    if (_crc && crc != sd_crc16(buffer, length)) {
+        _crc_errors++;
+        return 1;
+    }
     return 0;
 }
 
-int SDFileSystem::_write(const uint8_t*buffer, uint32_t length) {
+int SDFileSystem::_write(const uint8_t*buffer, uint32_t length, int token) {
     _cs = 0;
 
-    // indicate start of block
-    _spi.write(0xFE);
+    // indicate start of block, 0xFE or 0xFC inside a multiple block write
+    _spi.write(token);
 
     // write the data
     for (uint32_t i = 0; i < length; i++) {
@@ -412,22 +565,86 @@ int SDFileSystem::_write(const uint8_t*buffer, uint32_t length) {
     }
 
     // write the checksum
+    uint16_t crc = _crc ? sd_crc16(buffer, length) : 0xFFFF;
+    _spi.write(crc >> 8);
+    _spi.write(crc);
+
+    // check the response token, 0x0B means the card saw a CRC error
+    int response = _spi.write(0xFF) & 0x1F;
+    if (response == 0x0B) {
+        _crc_errors++;
+    }
+
+    // wait for write to finish, the card may be busy after a rejected block too
+    if (_wait_while(0x00, SD_WRITE_TIMEOUT_MS) < 0) {
+        response = 0;
+    }
+
+    _cs = 1;
     _spi.write(0xFF);
-    _spi.write(0xFF);
+    return response == 0x05 ? 0 : 1;
+}
 
-    // check the response token
-    if ((_spi.write(0xFF) & 0x1F) != 0x05) {
-        _cs = 1;
-        _spi.write(0xFF);
-        return 1;
+// Write count blocks with one CMD25, letting the card pre-erase them first
+// (ACMD23). Returns the number of blocks the card accepted.
+uint32_t SDFileSystem::_write_multiple(const uint8_t *buffer, uint32_t block_number, uint32_t count) {
+    // the pre-erase count is only a hint, the write works without it
+    _cmd(55, 0);
+    _cmd(23, count);
+    if (_cmd(25, block_number * cdv) != 0) {
+        return 0;
     }
 
-    // wait for write to finish
-    while (_spi.write(0xFF) == 0);
+    uint32_t done = 0;
+    while (done < count && _write(buffer + done * 512, 512, 0xFC) == 0) {
+        done++;
+    }
 
+    // stop token, the card goes busy one byte later while it finishes
+    _cs = 0;
+    _spi.write(0xFD);
+    _spi.write(0xFF);
+    _wait_while(0x00, SD_WRITE_TIMEOUT_MS);
     _cs = 1;
     _spi.write(0xFF);
-    return 0;
+    return done;
+}
+
+// Clock the bus until the card sends something other than idle and return
+// it, or -1 after timeout_ms. Short waits spin, long ones sleep the thread.
+int SDFileSystem::_wait_while(int idle, int timeout_ms) {
+    int response = _spi.write(0xFF);
+    if (response != idle) {
+        return response;
+    }
+
+    Timer timer;
+    timer.start();
+    int sleep_ms = 1;
+    while ((response = _spi.write(0xFF)) == idle) {
+        int elapsed = timer.read_us();
+        if (elapsed >= timeout_ms * 1000) {
+            response = -1;
+            _busy.timeouts++;
+            break;
+        }
+        if (elapsed >= SD_BUSY_SPIN_US) {
+            Thread::wait(sleep_ms);
+            _busy.sleeps++;
+            if (sleep_ms < SD_BUSY_SLEEP_MAX_MS) {
+                sleep_ms *= 2;
+            }
+        }
+    }
+
+    uint32_t us = timer.read_us();
+    _busy.waits++;
+    _busy.total_us += us;
+    if (us > _busy.max_us) {
+        _busy.max_us = us;
+    }
+    debug_if(SD_DBG && response < 0, "Timeout waiting for card (%d us)\n", us);
+    return response;
 }
 
 static uint32_t ext_bits(unsigned char *data, int msb, int lsb) {
@@ -443,6 +660,35 @@ static uint32_t ext_bits(unsigned char *data, int msb, int lsb) {
     return bits;
 }
 
+// Allocation unit in sectors from the SD status (ACMD13), 0 if not available
+uint32_t SDFileSystem::_sd_au_size() {
+    // SD 3.0 codes 0xA-0xF, in MB
+    static const uint8_t au_mb[] = {8, 12, 16, 24, 32, 64};
+
+    _cmd(55, 0);
+    // ACMD13, Response R2 (R1 byte + status byte) followed by a 64-byte block
+    if (_cmdx(13, 0) != 0) {
+        debug_if(SD_DBG, "SD status not available\n");
+        return 0;
+    }
+
+    _spi.write(0xFF); // R2 status byte
+
+    uint8_t status[64];
+    if (_read(status, 64) != 0) {
+        return 0;
+    }
+
+    // au_size : status[431:428]
+    uint32_t au_size = status[10] >> 4;
+    if (au_size == 0) {
+        return 0;
+    } else if (au_size <= 9) {
+        return 32 << (au_size - 1);     // 16 kB .. 4 MB
+    }
+    return au_mb[au_size - 10] * 2048;
+}
+
 uint32_t SDFileSystem::_sd_sectors() {
     uint32_t c_size, c_size_mult, read_bl_len;
     uint32_t block_len, mult, blocknr, capacity;
@@ -465,9 +711,17 @@ uint32_t SDFileSystem::_sd_sectors() {
     // c_size        : csd[73:62]
     // c_size_mult   : csd[49:47]
     // read_bl_len   : csd[83:80] - the *maximum* read block length
+    // erase_blk_en  : csd[46]    - single blocks can be erased, always 1 in CSD v2
+    // sector_size   : csd[45:39] - erase sector, in write blocks, minus one
+    // write_bl_len  : csd[25:22]
 
     int csd_structure = ext_bits(csd, 127, 126);
 
+    uint32_t erase_bytes = (ext_bits(csd, 45, 39) + 1) << ext_bits(csd, 25, 22);
+    _erase_sectors = erase_bytes >= 512 ? erase_bytes / 512 : 1;
+    _erase_group = _erase_sectors;
+    _erase_blk = csd_structure != 0 || ext_bits(csd, 46, 46);
+
     switch (csd_structure) {
         case 0:
             cdv = 512;
@@ -23,6 +23,7 @@
 #define MBED_SDFILESYSTEM_H
 
 #include "mbed.h"
+#include "rtos.h"
 #include "FATFileSystem.h"
 #include <stdint.h>
 
@@ -57,22 +58,78 @@ public:
     virtual int disk_read(uint8_t* buffer, uint32_t block_number, uint32_t count);
     virtual int disk_write(const uint8_t* buffer, uint32_t block_number, uint32_t count);
     virtual int disk_sync();
+    virtual int disk_trim(uint32_t sector, uint32_t count);
     virtual uint32_t disk_sectors();
+    virtual uint32_t disk_block_size();
+
+    /** Erase blocks, so that writing them again later is faster
+     *
+     * The blocks read back as all 0s or all 1s afterwards, depending on the
+     * card. FatFs trims the clusters of deleted and truncated files through
+     * disk_trim(), which calls this.
+     *
+     * A version 1 card without ERASE_BLK_EN in its CSD can only erase whole
+     * erase sectors. The range is then rounded inward to them, and nothing
+     * is erased if it does not cover one.
+     *
+     * @param block_number First block to erase
+     * @param count Number of blocks
+     * @returns 0 on success
+     */
+    int erase(uint32_t block_number, uint32_t count);
+
+    /** Check commands and data blocks with CRCs (CMD59)
+     *
+     * Takes effect at the next disk_initialize(). A command or block that
+     * fails its CRC check is sent again, up to SD_CRC_RETRIES times.
+     *
+     * @param enable true to turn CRC checking on
+     */
+    void set_crc(bool enable) { _crc_on = enable; }
+
+    /** Number of CRC errors seen (and retried) so far */
+    uint32_t crc_errors() { return _crc_errors; }
+
+    /** Time spent waiting for the card, for read tokens, write programming and erases */
+    struct BusyStats {
+        uint32_t waits;     // waits where the card was not ready at the first poll
+        uint32_t sleeps;    // times the thread slept after the spin budget ran out
+        uint32_t timeouts;  // waits that gave up
+        uint32_t total_us;  // time spent in all waits
+        uint32_t max_us;    // longest single wait
+    };
+
+    /** Busy-wait statistics since the last reset_busy_stats() */
+    const BusyStats& busy_stats() { return _busy; }
+    void reset_busy_stats() { memset(&_busy, 0, sizeof(_busy)); }
 
 protected:
 
+    void _cmdframe(int cmd, int arg);
     int _cmd(int cmd, int arg);
     int _cmdx(int cmd, int arg);
     int _cmd8();
     int _cmd58();
+    int _acmd41(int arg);
+    int _wait_while(int idle, int timeout_ms);
     int initialise_card();
     int initialise_card_v1();
     int initialise_card_v2();
 
     int _read(uint8_t * buffer, uint32_t length);
-    int _write(const uint8_t *buffer, uint32_t length);
+    int _write(const uint8_t *buffer, uint32_t length, int token = 0xFE);
+    uint32_t _write_multiple(const uint8_t *buffer, uint32_t block_number, uint32_t count);
     uint32_t _sd_sectors();
+    uint32_t _sd_au_size();
     uint32_t _sectors;
+    uint32_t _erase_sectors;
+    uint32_t _erase_group;  // CSD erase sector, in blocks
+    bool _erase_blk;        // CSD ERASE_BLK_EN, or a version 2 card
+
+    bool _crc_on;           // CRC checking requested by set_crc()
+    bool _crc;              // CRC checking accepted by the card
+    uint32_t _crc_errors;
+    BusyStats _busy;
 
     void set_init_sck(uint32_t sck) { _init_sck = sck; }
     // Note: The highest SPI clock rate is 20 MHz for MMC and 25 MHz for SD
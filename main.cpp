@@ -1,8 +1,10 @@
 #include "mbed.h"
+#include "mbed_debug.h"
 #include "rtos.h"
 #include "uLCD_4DGL.h"
 #include "SDFileSystem.h"
 #include "wave_player.h"
+#include "EventLog.h"
 #include <string>
 
 // Authors: Allen Ayala, Ruben Quiros, Tyrell Ramos-Lopez, and Rishab Tandon
@@ -80,6 +82,15 @@ volatile unsigned int teamScoreB = 0;
 // round #
 volatile unsigned int roundNum = 0;
 
+// round results, kept on the SD card - see logRound
+#define EVENT_ROUND 1
+#define ROUND_LOG_BATCH 4           // rounds per write of the log sector
+EventLog roundLog;
+Timer roundTimer;                   // restarted when a round starts
+volatile int buzzTime = 0;          // ms from the start of the round to the buzzer
+volatile char buzzTeam = ' ';       // team that buzzed first
+volatile unsigned int roundPoints = 0;
+
 // PushButtons (Buzzers)
 DigitalIn buzzerA(p19);
 DigitalIn buzzerB(p22);
@@ -88,12 +99,15 @@ DigitalIn buzzerB(p22);
 DigitalOut ledA(p20); //20
 DigitalOut ledB(p21); //21
 
-// uLCD
-uLCD_4DGL LCD(p28, p27, p30); // see pinout section
+// uLCD - reset later from a boot thread, see main
+uLCD_4DGL LCD(p28, p27, p30, false); // see pinout section
 
 // mutex for getc, putc, printf, and accessing strings
 Mutex mut;
 
+// released whenever the round number or a score changes, wakes threadLCD
+Semaphore scoreboardChanged(0);
+
 // SD Card reader
 SDFileSystem sd(p5, p6, p7, p8, "sd"); // see pinout section
 
@@ -103,6 +117,46 @@ AnalogOut DACout(p18);
 //wave player plays a *.wav file to D/A and a PWM
 wave_player waver(&DACout);
 
+// intro music, opened by the SD boot thread while the LCD resets
+FILE *introFile = NULL;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+// Boot timeline - records when each startup phase finished
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define BOOT_MAX_MARKS 8
+
+// boot timeline, LCD baud, round log and stack use go to the USB serial (stdio),
+// never to dev, which is the players' Bluetooth console
+#define BOOT_DBG 0
+
+Timer bootTimer;
+const char *bootNames[BOOT_MAX_MARKS];
+int bootTimes[BOOT_MAX_MARKS];  // us since boot
+int bootMarks = 0;
+
+// called from several boot threads, so keep it short and atomic
+void bootMark(const char *name){
+    int now = bootTimer.read_us();
+    __disable_irq();
+    if(bootMarks < BOOT_MAX_MARKS){
+        bootNames[bootMarks] = name;
+        bootTimes[bootMarks] = now;
+        ++bootMarks;
+    }
+    __enable_irq();
+}
+
+// print each phase with the time it finished and the time since the mark before it
+void bootReport(){
+    int last = 0;
+    debug_if(BOOT_DBG, "Boot timeline:\n");
+    for(int i = 0; i < bootMarks; ++i){
+        debug_if(BOOT_DBG, "%-12s %6d ms (+%d ms)\n", bootNames[i], bootTimes[i] / 1000, (bootTimes[i] - last) / 1000);
+        last = bootTimes[i];
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // Helper Functions
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -123,10 +177,44 @@ void showdownSound(){
     fclose(wave_file);
 }
 
-// intro music sound effect
+// store the result of the round that just ended; the log sector is written
+// every ROUND_LOG_BATCH rounds and at the end of the game (see main), not
+// every round, so a sector of 16 records is rewritten about 4 times, not 16
+void logRound(){
+    struct {
+        uint16_t round;
+        uint16_t points;
+        int32_t buzzMs;
+        char buzzer;
+        char winner;
+    } r;
+    memset(&r, 0, sizeof r);        // no stack garbage in the tail padding on the card
+    r.round = roundNum;
+    r.points = roundPoints;
+    r.buzzMs = buzzTime;
+    r.buzzer = buzzTeam;
+    mut.lock();
+    r.winner = toupper(winningTeam[0]);
+    mut.unlock();
+    roundLog.append(EVENT_ROUND, &r, sizeof(r), bootTimer.read_ms());
+    // a reset or a pulled plug loses the rounds since the last write, at most
+    // ROUND_LOG_BATCH - 1 of them: a game cut short is replayed anyway, the
+    // log is only history
+    if(roundNum % ROUND_LOG_BATCH == 0){
+        roundLog.flush();
+    }
+}
+
+// intro music sound effect - uses the file the SD boot thread opened if there is one
 void introMusic(){
-    FILE *wave_file;
-    wave_file=fopen("/sd/family-feud-intro.wav", "r");
+    FILE *wave_file = introFile;
+    introFile = NULL;
+    if(wave_file == NULL){
+        wave_file=fopen("/sd/family-feud-intro.wav", "r");
+    }
+    if(wave_file == NULL){
+        return;
+    }
     waver.play(wave_file);
     fclose(wave_file);
 }
@@ -135,12 +223,26 @@ void introMusic(){
 // Threads
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
+// boot thread - resets and clears the uLCD (the reset alone takes 3s)
+void threadBootLCD(void const *args){
+    LCD.init();
+    bootMark("lcd reset");
+}
+
+// boot thread - brings up the SD card and opens the intro music
+void threadBootSD(void const *args){
+    introFile = fopen("/sd/family-feud-intro.wav", "r");
+    bootMark("sd + intro");
+}
+
 // buzzer A thread
 void threadBuzzerA(void const *args){
     while(true){
         Thread::wait(100);
         if((buzzerA == 0) && !buzzerHit){
             buzzerHit = true;
+            buzzTime = roundTimer.read_ms();
+            buzzTeam = 'A';
             ledA = 1;
             buzzerSound();
         }
@@ -153,6 +255,8 @@ void threadBuzzerB(void const *args){
         Thread::wait(100);
         if((buzzerB == 0) && !buzzerHit){
             buzzerHit = true;
+            buzzTime = roundTimer.read_ms();
+            buzzTeam = 'B';
             ledB = 1;
             buzzerSound();
         } 
@@ -160,17 +264,24 @@ void threadBuzzerB(void const *args){
 }
 
 // LCD thread - displays round number and team scores
+// the text goes into the LCD's text grid, so a redraw only sends what changed,
+// and the LCD driver queues it for its TX interrupt, so mut is only held while
+// the commands are queued, not while they go out at the LCD baud rate
 void threadLCD(void const *args){
+    char line[20];
     while(true){
         mut.lock();
-        LCD.locate(0,0);
-        LCD.printf("Welcome to Family Feud!");
-        LCD.printf("\n\nRound %d", roundNum);
-        LCD.printf("\n\nScores");
-        LCD.printf("\nTeam A: %d  ", teamScoreA);
-        LCD.printf("\nTeam B: %d  ", teamScoreB);
+        LCD.text_print(0, 0, "Welcome to Family Feud!", WHITE);
+        snprintf(line, sizeof line, "Round %d  ", roundNum);
+        LCD.text_print(0, 3, line, WHITE);
+        LCD.text_print(0, 5, "Scores", WHITE);
+        snprintf(line, sizeof line, "Team A: %d  ", teamScoreA);
+        LCD.text_print(0, 6, line, WHITE);
+        snprintf(line, sizeof line, "Team B: %d  ", teamScoreB);
+        LCD.text_print(0, 7, line, WHITE);
+        LCD.text_flush();
         mut.unlock();
-        Thread::wait(500);
+        scoreboardChanged.wait();
     }
 }
 
@@ -217,6 +328,7 @@ void threadBTReceive(void const *args){
                 }
                 else{
                     // correct input
+                    roundPoints = score;
                     pointsAwarded = true;
 
                     // check which team won
@@ -226,6 +338,7 @@ void threadBTReceive(void const *args){
                     else{
                         teamScoreB += score;
                     }
+                    scoreboardChanged.release();
                 }
             }
             else{
@@ -267,23 +380,38 @@ void threadBTSend(void const *args){
 // main - most of the logic here is controlled by the judge
 //////////////////////////////////////////////////////////////////////////////////////////////////
 int main(){
+    bootTimer.start();
     
     // initialize baud rates
     dev.baud(9600);
     // pc.baud(9600); // for testing purposes
-    LCD.baudrate(9600);
         
     // set pull up mode on pushbuttons
     buzzerA.mode(PullUp);
     buzzerB.mode(PullUp);
-    wait(0.1);
-        
-    // playIntroMusic
-    introMusic();
-    
-    // clear and setup uLCD
-    LCD.cls();
-    wait(2);
+
+    // reset the uLCD and start the SD card at the same time
+    {
+        Thread bootLCD(threadBootLCD);
+        Thread bootSD(threadBootSD);
+
+        // playIntroMusic as soon as the card is up, the LCD keeps resetting
+        bootSD.join();
+        introMusic();
+        bootMark("intro music");
+
+        bootLCD.join();
+    }
+    // as fast as the LCD link allows, it falls back if a rate fails
+    int lcdBaud = LCD.negotiate_baud(3000000);
+    bootMark("ready");
+    bootReport();
+    debug_if(BOOT_DBG, "LCD link: %d baud\n", lcdBaud);
+
+    // round history, 64 sectors hold the last 1000 or so rounds
+    if(roundLog.open(sd, "rounds.log", 64) == 0){
+        debug_if(BOOT_DBG, "Round log: records %d to %d\n", roundLog.first_seq(), roundLog.last_seq());
+    }
 
     // start LCD thread
     Thread t1(threadLCD);
@@ -314,6 +442,8 @@ int main(){
         // wait for judge to start round        
         do{
         } while (btInput.compare("start") != 0);
+        roundTimer.reset();
+        roundTimer.start();
         startRound = true;
 
         mut.lock();
@@ -323,6 +453,7 @@ int main(){
 
         // increment round num
         ++roundNum;
+        scoreboardChanged.release();
 
         // play showdown music
         showdownSound();
@@ -354,8 +485,13 @@ int main(){
         // wait for judge to award points to the winning team
         do{
         } while(!pointsAwarded);
+
+        // keep a record of the round
+        logRound();
     
     }
+    // the rounds since the last batch
+    roundLog.flush();
     
     // End of Game message to judge's screen
     mut.lock();
@@ -364,16 +500,26 @@ int main(){
     mut.unlock();
     Thread::wait(3000);
     
+    // most stack each thread has used, read before they are gone
+    int stackLCD = t1.max_stack();
+    int stackBTReceive = t2.max_stack();
+    int stackBTSend = t3.max_stack();
+    int stackBuzzerA = t4.max_stack();
+    int stackBuzzerB = t5.max_stack();
+
     // terminate threads
     t1.terminate();
     t2.terminate();
     t3.terminate();
     t4.terminate();
     t5.terminate();
+    debug_if(BOOT_DBG, "Max stack: LCD %d, BT receive %d, BT send %d, buzzers %d/%d bytes\n",
+             stackLCD, stackBTReceive, stackBTSend, stackBuzzerA, stackBuzzerB);
 
     // End of Game message to LCD screen
     LCD.cls();
     LCD.locate(0,0);
     LCD.printf(msgPrompt.c_str());
     LCD.printf("\n\nThank you\nfor playing!");
+    LCD.wait_idle();
 }
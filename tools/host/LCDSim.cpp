@@ -0,0 +1,404 @@
+#include "LCDSim.h"
+
+static LCDSim *screen;
+
+static void poll_hook() {
+    screen->poll();
+}
+
+// FF-prefixed commands: parameter bytes, execution time, and whether the
+// answer carries a word after the ACK
+struct Command {
+    uint8_t code;
+    uint8_t params;
+    uint16_t exec_us;
+    bool word;
+};
+
+static const Command commands[] = {
+    {0xD7, 0, 4000, false},     // cls
+    {0xFE, 2, 150, false},      // putchar
+    {0xE4, 4, 20, false},       // move cursor
+    {0x7F, 2, 20, false},       // text color
+    {0x7E, 2, 20, false},       // text background
+    {0x7D, 2, 20, false},       // font
+    {0x7C, 2, 20, false},       // text width
+    {0x7B, 2, 20, false},       // text height
+    {0x7A, 2, 20, false},
+    {0x79, 2, 20, false},
+    {0x77, 2, 20, false},       // text mode
+    {0x76, 2, 20, false},       // bold, volume
+    {0x75, 2, 20, false},       // italic
+    {0x74, 2, 20, false},       // inverse
+    {0x73, 2, 20, false},       // underline
+    {0x6F, 1, 20, false},
+    {0x6E, 2, 20, false},       // background color
+    {0x68, 2, 20, false},       // display control
+    {0x66, 2, 20, false},       // display power
+    {0xD8, 1, 20, false},       // pen size
+    {0xD9, 2, 20, false},
+    {0xCD, 8, 600, false},      // circle
+    {0xCC, 8, 1200, false},     // filled circle
+    {0xC9, 14, 300, false},     // triangle
+    {0xD2, 10, 200, false},     // line
+    {0xCF, 10, 300, false},     // rectangle
+    {0xCE, 10, 1000, false},    // filled rectangle
+    {0xCB, 6, 20, false},       // pixel
+    {0xCA, 4, 20, true},        // read pixel
+    {0xB1, 0, 200, true},       // media init
+    {0xB8, 4, 20, false},       // sector address
+    {0xB9, 4, 20, false},       // byte address
+    {0xB7, 0, 200, true},       // read byte
+    {0xB6, 0, 200, true},       // read word
+    {0xB5, 2, 200, true},       // write byte
+    {0xB4, 2, 200, true},       // write word
+    {0xB2, 0, 200, true},       // flush media
+    {0xB3, 4, 30000, false},    // display image
+    {0xBB, 4, 200, false},      // display video
+    {0xBA, 6, 200, false},      // display frame
+};
+
+LCDSim::LCDSim() {
+    max_baud = 3000000;
+    byte_us = 100;
+    buffer_size = 16;
+    memset(&stats, 0, sizeof(stats));
+    memset(fb, 0, sizeof(fb));
+    _host_baud = _screen_baud = 9600;
+    _line_free = _answer_free = _busy_until = _tx_irq_at = _take_at = 0;
+    _busy = _taking = _tx_irq_due = _in_irq = false;
+    _sector = _byte = 0;
+    _background = 0;
+}
+
+void LCDSim::attach() {
+    screen = this;
+    host_uart = this;
+    host_poll_hook = poll_hook;
+}
+
+void LCDSim::putc(int c) {
+    // a putc outside the interrupts waits for the transmit register
+    while (!_in_irq && _line_free > host_ns + bit_ns()) {
+        poll();
+    }
+    uint64_t start = _line_free > host_ns ? _line_free : host_ns;
+    _line_free = start + bit_ns();
+    Event e = {_line_free, c & 0xFF};
+    _to_screen.push_back(e);
+    _tx_irq_due = true;
+    _tx_irq_at = _line_free - bit_ns();
+}
+
+int LCDSim::getc() {
+    poll();
+    if (_rx.empty()) {
+        return -1;
+    }
+    int c = _rx.front();
+    _rx.pop_front();
+    return c;
+}
+
+int LCDSim::readable() {
+    poll();
+    return !_rx.empty();
+}
+
+int LCDSim::writeable() {
+    poll();
+    return _line_free <= host_ns + bit_ns();
+}
+
+void LCDSim::baud(int rate) {
+    _host_baud = rate;
+}
+
+void LCDSim::answer(uint64_t t, int b) {
+    uint64_t start = _answer_free > t ? _answer_free : t;
+    _answer_free = start + screen_bit_ns();
+    Event e = {_answer_free, b & 0xFF};
+    _to_host.push_back(e);
+}
+
+uint8_t LCDSim::card_byte(uint32_t address) {
+    std::map<uint32_t, std::vector<uint8_t> >::iterator i = card.find(address / 512);
+    return i == card.end() ? 0xFF : i->second[address % 512];
+}
+
+void LCDSim::set_card_byte(uint32_t address, uint8_t b) {
+    std::vector<uint8_t> &s = card[address / 512];
+    if (s.empty()) {
+        s.assign(512, 0xFF);
+    }
+    s[address % 512] = b;
+}
+
+void LCDSim::fill(int x1, int y1, int x2, int y2, uint16_t color) {
+    for (int y = y1 < 0 ? 0 : y1; y <= y2 && y < 128; y++) {
+        for (int x = x1 < 0 ? 0 : x1; x <= x2 && x < 128; x++) {
+            fb[y][x] = color;
+        }
+    }
+}
+
+// take the command at the head of _command: run it and answer when done
+void LCDSim::run(uint64_t t, size_t length, uint64_t exec_ns, int words) {
+    _command.erase(_command.begin(), _command.begin() + length);
+    stats.commands++;
+    _busy = true;
+    _busy_until = t + exec_ns;
+    answer(_busy_until, 0x06);
+    for (int i = 0; i < words * 2; i++) {
+        answer(_busy_until, _reply[i]);
+    }
+}
+
+// start the command in _command at time t, once all of it has been taken in
+void LCDSim::start(uint64_t t) {
+    if (_busy || _command.size() < 2) {
+        return;
+    }
+    std::deque<int> &c = _command;
+#define WORD(i) (c[i] << 8 | c[(i) + 1])
+    _reply[0] = 0x00;
+    _reply[1] = 0x01;
+    if (c[0] == 0xFF) {
+        const Command *cmd = 0;
+        for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+            if (commands[i].code == c[1]) {
+                cmd = &commands[i];
+            }
+        }
+        if (cmd == 0) {
+            error("LCDSim: unknown command FF %02X\n", c[1]);
+        }
+        size_t length = 2 + cmd->params;
+        if (c.size() < length) {
+            return;
+        }
+        switch (c[1]) {
+            case 0xD7:
+                fill(0, 0, 127, 127, _background);
+                break;
+            case 0x6E:
+                _background = WORD(2);
+                break;
+            case 0xCE:
+                fill(WORD(2), WORD(4), WORD(6), WORD(8), WORD(10));
+                break;
+            case 0xCA:
+                _reply[0] = WORD(2) < 128 && WORD(4) < 128 ? fb[WORD(4)][WORD(2)] >> 8 : 0;
+                _reply[1] = WORD(2) < 128 && WORD(4) < 128 ? fb[WORD(4)][WORD(2)] & 0xFF : 0;
+                break;
+            case 0xB8:
+                _sector = WORD(2) << 16 | WORD(4);
+                break;
+            case 0xB9:
+                _byte = WORD(2) << 16 | WORD(4);
+                break;
+            case 0xB7:
+                _reply[1] = card_byte(_byte++);
+                break;
+            case 0xB6:
+                _reply[0] = card_byte(_byte++);
+                _reply[1] = card_byte(_byte++);
+                break;
+            case 0xB5:
+                set_card_byte(_byte++, c[3]);
+                break;
+            case 0xB4:
+                set_card_byte(_byte++, c[2]);
+                set_card_byte(_byte++, c[3]);
+                break;
+            case 0xB3: {
+                // a 4D raw image: width, height, colour mode, then the pixels
+                uint32_t a = _sector * 512;
+                int x0 = WORD(2), y0 = WORD(4);
+                int w = card_byte(a) << 8 | card_byte(a + 1), h = card_byte(a + 2) << 8 | card_byte(a + 3);
+                for (int y = 0; y < h; y++) {
+                    for (int x = 0; x < w; x++) {
+                        uint32_t p = a + 6 + 2 * (y * w + x);
+                        if (x0 + x < 128 && y0 + y < 128) {
+                            fb[y0 + y][x0 + x] = card_byte(p) << 8 | card_byte(p + 1);
+                        }
+                    }
+                }
+                break;
+            }
+        }
+        run(t, length, cmd->exec_us * 1000ULL, cmd->word);
+    } else if (c[0] == 0x00) {
+        switch (c[1]) {
+            case 0x0B: {                        // baud rate
+                if (c.size() < 4) {
+                    return;
+                }
+                int rate = 3000000 / (WORD(2) + 1);
+                if (rate > max_baud + max_baud / 20) {  // the divisor rounds, 115200 is 115384
+                    _command.erase(_command.begin(), _command.begin() + 4);
+                    stats.commands++;
+                    _busy = true;
+                    _busy_until = t + 30000;
+                    answer(t, 0x15);
+                    return;
+                }
+                _screen_baud = rate;
+                run(t, 4, 100000000ULL, 0);
+                return;
+            }
+            case 0x08:                          // version
+                _reply[0] = 0x00;
+                _reply[1] = 0x12;
+                run(t, 2, 30000, 1);
+                return;
+            case 0x06: {                        // text string, up to its 0
+                size_t end = 2;
+                while (end < c.size() && c[end]) {
+                    end++;
+                }
+                if (end >= c.size()) {
+                    return;
+                }
+                run(t, end + 1, 150000ULL * (end - 2) + 30000, 0);
+                return;
+            }
+            case 0x0A: {                        // BLIT, header and w*h pixels
+                if (c.size() < 10) {
+                    return;
+                }
+                int x0 = WORD(2), y0 = WORD(4), w = WORD(6), h = WORD(8);
+                if (c.size() < 10 + 2u * w * h) {
+                    return;
+                }
+                for (int i = 0; i < w * h; i++) {
+                    if (x0 + i % w < 128 && y0 + i / w < 128) {
+                        fb[y0 + i / w][x0 + i % w] = WORD(10 + 2 * i);
+                    }
+                }
+                run(t, 10 + 2 * w * h, 0, 0);
+                return;
+            }
+            case 0x17: {                        // write sector
+                if (c.size() < 514) {
+                    return;
+                }
+                std::vector<uint8_t> &s = card[_sector];
+                s.assign(c.begin() + 2, c.begin() + 514);
+                stats.sector_writes++;
+                run(t, 514, 5000000, 1);
+                return;
+            }
+        }
+        error("LCDSim: unknown command 00 %02X\n", c[1]);
+    } else {
+        error("LCDSim: command starts with %02X\n", c[0]);
+    }
+#undef WORD
+}
+
+// the screen takes the next byte out of its buffer when no command runs
+void LCDSim::next(uint64_t t) {
+    if (_busy || _taking || _buffer.empty()) {
+        return;
+    }
+    bool pixels = _command.size() >= 10 && _command[0] == 0x00 && _command[1] == 0x0A;
+    _taking = true;
+    _take_at = t + (pixels ? 2000 : byte_us * 1000ULL);
+}
+
+void LCDSim::poll() {
+    if (_in_irq) {
+        return;
+    }
+    host_ns += 1000;
+    for (;;) {
+        // the earliest event due by now
+        uint64_t t = UINT64_MAX;
+        int which = -1;
+        if (!_to_screen.empty() && _to_screen.front().t <= host_ns && _to_screen.front().t < t) {
+            t = _to_screen.front().t;
+            which = 0;
+        }
+        if (_busy && _busy_until <= host_ns && _busy_until < t) {
+            t = _busy_until;
+            which = 1;
+        }
+        if (!_to_host.empty() && _to_host.front().t <= host_ns && _to_host.front().t < t) {
+            t = _to_host.front().t;
+            which = 2;
+        }
+        if (_taking && _take_at <= host_ns && _take_at < t) {
+            t = _take_at;
+            which = 3;
+        }
+        uint64_t due = Timeout::next_due();
+        if (due <= host_ns && due < t) {
+            t = due;
+            which = 4;
+        }
+        if (_tx_irq_due && _tx_irq_at <= host_ns && _tx_irq_at < t) {
+            t = _tx_irq_at;
+            which = 5;
+        }
+
+        switch (which) {
+            case -1:
+                return;
+            case 0:                             // a byte reaches the screen
+                if (!in_step()) {
+                    stats.lost++;
+                } else {
+                    wire.push_back(_to_screen.front().b);
+                    _buffer.push_back(_to_screen.front().b);
+                    stats.bytes++;
+                    if (_buffer.size() > stats.max_buffered) {
+                        stats.max_buffered = _buffer.size();
+                    }
+                    if (_buffer.size() > buffer_size) {
+                        stats.overruns++;
+                    }
+                }
+                _to_screen.pop_front();
+                next(t);
+                break;
+            case 1:                             // a command finished
+                _busy = false;
+                next(t);
+                break;
+            case 2:                             // an answer reaches the mbed
+                if (!in_step()) {
+                    stats.lost++;
+                } else {
+                    _rx.push_back(_to_host.front().b);
+                    if (host_uart_owner) {
+                        _in_irq = true;
+                        host_uart_owner->rx_irq();
+                        _in_irq = false;
+                    }
+                }
+                _to_host.pop_front();
+                break;
+            case 3:                             // the screen took a byte in
+                _taking = false;
+                _command.push_back(_buffer.front());
+                _buffer.pop_front();
+                start(t);
+                next(t);
+                break;
+            case 4:
+                _in_irq = true;
+                Timeout::fire_due(t);
+                _in_irq = false;
+                break;
+            case 5:                             // transmit register empty
+                _tx_irq_due = false;
+                if (host_uart_owner) {
+                    _in_irq = true;
+                    host_uart_owner->tx_irq();
+                    _in_irq = false;
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/* uLCD-144-G2 (Goldelox) model on the UART, for the host benchmarks.
+ *
+ * It parses the serial commands uLCD_4DGL sends and answers them like the
+ * screen does:
+ * - a byte takes 10 bit times on the wire each way, and a byte sent at a
+ *   rate more than 5% off the other side's is lost;
+ * - the screen takes bytes out of its receive buffer one at a time, byte_us
+ *   each (2us for BLIT pixel data), but only while no command runs; a byte
+ *   arriving when buffer_size are waiting counts as an overrun;
+ * - each command runs for a fixed time from a table, then the screen answers
+ *   ACK, plus a word for the commands that return one;
+ * - the baud command is refused with NAK above max_baud, otherwise the
+ *   screen answers at the new rate 100ms later. The rate the divisor gives
+ *   may be up to 5% over max_baud.
+ *
+ * Pixels drawn by BLIT, filled rectangles, cls and images shown from the
+ * screen's own card end up in fb; text is not rendered. The card is kept
+ * sparse by sector. Every byte the screen receives is appended to wire.
+ *
+ * Each poll of the model, from a Timer read or a wait, costs 1us of
+ * simulated time, like a loop around the UART registers would.
+ */
+#ifndef LCDSIM_H
+#define LCDSIM_H
+
+#include "mbed.h"
+#include <deque>
+#include <map>
+#include <vector>
+
+class LCDSim : public HostUart {
+public:
+    LCDSim();
+
+    // plug into the UART and the poll hook, one screen at a time
+    void attach();
+
+    // configuration
+    int max_baud;
+    uint32_t byte_us;                       // time to take a byte out of the buffer
+    size_t buffer_size;
+
+    struct Stats {
+        unsigned long commands, bytes, overruns, lost, sector_writes;
+        size_t max_buffered;
+    } stats;
+
+    uint16_t fb[128][128];                  // RGB565
+    std::vector<uint8_t> wire;
+    std::map<uint32_t, std::vector<uint8_t> > card;
+
+    // HostUart, the mbed side
+    virtual void putc(int c);
+    virtual int getc();
+    virtual int readable();
+    virtual int writeable();
+    virtual void baud(int rate);
+
+    void poll();
+
+private:
+    struct Event {
+        uint64_t t;
+        int b;
+    };
+    uint64_t bit_ns() { return 10000000000ULL / _host_baud; }
+    uint64_t screen_bit_ns() { return 10000000000ULL / _screen_baud; }
+    bool in_step() { return _host_baud > _screen_baud * 0.95 && _host_baud < _screen_baud * 1.05; }
+    void answer(uint64_t t, int b);
+    void start(uint64_t t);
+    void next(uint64_t t);
+    void run(uint64_t t, size_t length, uint64_t exec_ns, int words);
+    uint8_t card_byte(uint32_t address);
+    void set_card_byte(uint32_t address, uint8_t b);
+    void fill(int x1, int y1, int x2, int y2, uint16_t color);
+
+    int _host_baud, _screen_baud;
+    uint64_t _line_free, _answer_free, _busy_until, _tx_irq_at, _take_at;
+    bool _busy, _taking, _tx_irq_due, _in_irq;
+    std::deque<Event> _to_screen, _to_host;
+    std::deque<int> _buffer, _command, _rx;
+    uint32_t _sector, _byte;
+    uint16_t _background;
+    int _reply[2];
+};
+
+#endif
@@ -0,0 +1,349 @@
+#include "SDCardSim.h"
+#include "SDCRC.h"
+#include "mbed.h"
+
+static SDCardSim *card;
+
+static int spi_hook(int out) {
+    return card->spi(out);
+}
+
+SDCardSim::SDCardSim(uint32_t sectors) : _sectors(sectors), _data(sectors), _dirty(sectors) {
+    sdhc = true;
+    erase_blk_en = true;
+    erase_group = 32;
+    au_sectors = 8192;
+    open_aus = 2;
+    au_open_us = 0;
+    ready_us = 250000;
+    write_us = 0;
+    rewrite_us = 0;
+    erase_us = 500;
+    flip_rate = 0;
+    memset(&stats, 0, sizeof(stats));
+    on_command = 0;
+    _state = IDLE;
+    _fpos = 0;
+    _waddr = 0;
+    _multi = false;
+    _app = false;
+    _idle = true;
+    _crc = false;
+    _first_acmd41 = 0;
+    _erase_start = _erase_end = _pre_erased = 0;
+    _busy_until = 0;
+    _rng = 12345;
+}
+
+SDCardSim::~SDCardSim() {
+    for (uint32_t i = 0; i < _sectors; i++) {
+        delete[] _data[i];
+    }
+    if (card == this) {
+        host_spi_hook = 0;
+    }
+}
+
+void SDCardSim::attach() {
+    card = this;
+    host_spi_hook = spi_hook;
+}
+
+uint8_t *SDCardSim::sector(uint32_t n) {
+    return n < _sectors ? _data[n] : 0;
+}
+
+// set bits msb..lsb of a 16-byte register, numbered like SDFileSystem's ext_bits()
+static void set_bits(uint8_t *reg, int msb, int lsb, uint32_t value) {
+    for (int pos = lsb; pos <= msb; pos++, value >>= 1) {
+        uint8_t mask = 1 << (pos & 7);
+        if (value & 1) {
+            reg[15 - (pos >> 3)] |= mask;
+        } else {
+            reg[15 - (pos >> 3)] &= ~mask;
+        }
+    }
+}
+
+uint8_t SDCardSim::flip(uint8_t b) {
+    if (flip_rate > 0) {
+        _rng = _rng * 1103515245 + 12345;
+        if ((_rng >> 8) / 16777216.0 < flip_rate) {
+            stats.flips++;
+            _rng = _rng * 1103515245 + 12345;
+            return b ^ (1 << ((_rng >> 16) & 7));
+        }
+    }
+    return b;
+}
+
+void SDCardSim::send_block(const uint8_t *data, int n) {
+    static const uint8_t zero[512] = {0};
+    if (data == 0) {
+        data = zero;
+    }
+    uint16_t crc = sd_crc16(data, n);
+    _out.push_back(0xFF);
+    _out.push_back(0xFE);
+    for (int i = 0; i < n; i++) {
+        _out.push_back(flip(data[i]));
+    }
+    _out.push_back(crc >> 8);
+    _out.push_back(crc & 0xFF);
+}
+
+void SDCardSim::command() {
+    int cmd = _frame[0] & 0x3F;
+    uint32_t arg = (_frame[1] << 24) | (_frame[2] << 16) | (_frame[3] << 8) | _frame[4];
+    stats.commands++;
+    if (on_command) {
+        on_command(cmd, arg);
+    }
+
+    int r1 = _idle ? 0x01 : 0x00;
+    _out.push_back(0xFF);
+    if ((_crc || cmd == 0 || cmd == 8) && sd_crc7(_frame, 5) != _frame[5]) {
+        _out.push_back(r1 | 0x08);
+        _app = false;
+        return;
+    }
+
+    bool app = _app;
+    _app = false;
+    if (app) {
+        switch (cmd) {
+            case 41:
+                if (_first_acmd41 == 0) {
+                    _first_acmd41 = host_ns;
+                }
+                if (host_ns - _first_acmd41 >= (uint64_t)ready_us * 1000) {
+                    _idle = false;
+                }
+                _out.push_back(_idle ? 0x01 : 0x00);
+                return;
+            case 23:
+                _pre_erased = arg & 0x7FFFFF;
+                _out.push_back(r1);
+                return;
+            case 13: {
+                uint8_t status[64] = {0};
+                int code = 0;
+                while (code < 9 && (32u << code) < au_sectors) {
+                    code++;
+                }
+                status[10] = au_sectors ? (code + 1) << 4 : 0;
+                _out.push_back(r1);
+                _out.push_back(0x00);
+                send_block(status, 64);
+                return;
+            }
+        }
+    }
+
+    switch (cmd) {
+        case 0:
+            _idle = true;
+            _crc = false;
+            _first_acmd41 = 0;
+            _out.push_back(0x01);
+            break;
+        case 8:
+            if (!sdhc) {
+                _out.push_back(r1 | 0x04);      // version 1 cards do not know CMD8
+                break;
+            }
+            _out.push_back(r1);
+            _out.push_back(0x00);
+            _out.push_back(0x00);
+            _out.push_back(0x01);
+            _out.push_back(0xAA);
+            break;
+        case 9: {
+            uint8_t csd[16] = {0};
+            set_bits(csd, 83, 80, 9);           // READ_BL_LEN
+            set_bits(csd, 25, 22, 9);           // WRITE_BL_LEN
+            if (sdhc) {
+                set_bits(csd, 127, 126, 1);
+                set_bits(csd, 69, 48, _sectors / 1024 - 1);
+                set_bits(csd, 46, 46, 1);
+                set_bits(csd, 45, 39, 0x7F);
+            } else {
+                set_bits(csd, 73, 62, _sectors / 512 - 1);
+                set_bits(csd, 49, 47, 7);       // 512 blocks per C_SIZE unit
+                set_bits(csd, 46, 46, erase_blk_en);
+                set_bits(csd, 45, 39, erase_group - 1);
+            }
+            _out.push_back(r1);
+            send_block(csd, 16);
+            break;
+        }
+        case 16:
+        case 55:
+            _app = cmd == 55;
+            _out.push_back(r1);
+            break;
+        case 58:
+            _out.push_back(r1);
+            _out.push_back(_idle ? 0x00 : (sdhc ? 0xC0 : 0x80));
+            _out.push_back(0xFF);
+            _out.push_back(0x80);
+            _out.push_back(0x00);
+            break;
+        case 59:
+            _crc = arg & 1;
+            _out.push_back(r1);
+            break;
+        case 17:
+            if (block(arg) >= _sectors) {
+                _out.push_back(0x20);
+                break;
+            }
+            stats.reads++;
+            _out.push_back(0x00);
+            send_block(_data[block(arg)], 512);
+            break;
+        case 24:
+        case 25:
+            if (block(arg) >= _sectors) {
+                _out.push_back(0x20);
+                break;
+            }
+            _out.push_back(0x00);
+            _state = WAIT_TOKEN;
+            _waddr = block(arg);
+            _multi = cmd == 25;
+            if (_multi) {
+                stats.multi_writes++;
+            } else {
+                _pre_erased = 0;
+            }
+            break;
+        case 32:
+            _erase_start = block(arg);
+            _out.push_back(0x00);
+            break;
+        case 33:
+            _erase_end = block(arg);
+            _out.push_back(0x00);
+            break;
+        case 38: {
+            uint32_t first = _erase_start, last = _erase_end;
+            if (!sdhc && !erase_blk_en) {
+                // the card erases whole groups, whatever the range says
+                first -= first % erase_group;
+                last += erase_group - 1 - last % erase_group;
+            }
+            for (uint32_t i = first; i <= last && i < _sectors; i++) {
+                delete[] _data[i];
+                _data[i] = 0;
+                _dirty[i] = false;
+            }
+            stats.erase_cmds++;
+            stats.erased += last - first + 1;
+            _out.push_back(0x00);
+            _out.push_back(0x00);
+            _busy_until = host_ns + (erase_us + (last - first + 1) / 64) * 1000ULL;
+            break;
+        }
+        default:
+            _out.push_back(r1 | 0x04);
+            break;
+    }
+}
+
+// true if the block's allocation unit had to be opened, the model uses a 4MB
+// unit when the card reports none
+bool SDCardSim::open_au(uint32_t block) {
+    uint32_t au = block / (au_sectors ? au_sectors : 8192);
+    for (size_t i = 0; i < _open.size(); i++) {
+        if (_open[i] == au) {
+            _open.erase(_open.begin() + i);
+            _open.push_front(au);
+            return false;
+        }
+    }
+    _open.push_front(au);
+    if (_open.size() > open_aus) {
+        _open.pop_back();
+    }
+    stats.au_opens++;
+    return true;
+}
+
+void SDCardSim::store() {
+    uint16_t crc = (_rx[512] << 8) | _rx[513];
+    if (_crc && crc != sd_crc16(&_rx[0], 512)) {
+        _out.push_back(0x0B);
+    } else {
+        if (_data[_waddr] == 0) {
+            _data[_waddr] = new uint8_t[512];
+        }
+        memcpy(_data[_waddr], &_rx[0], 512);
+        uint64_t busy = write_us;
+        if (_dirty[_waddr] && _pre_erased == 0) {
+            busy += rewrite_us;
+            stats.rewrites++;
+        }
+        if (open_au(_waddr)) {
+            busy += au_open_us;
+        }
+        if (_pre_erased) {
+            _pre_erased--;
+        }
+        _dirty[_waddr] = true;
+        stats.writes++;
+        _busy_until = host_ns + busy * 1000;
+        _out.push_back(0x05);
+        if (_multi) {
+            _waddr++;
+        }
+    }
+    _out.push_back(0x00);           // at least one busy byte
+}
+
+int SDCardSim::spi(int out) {
+    if (_out.empty() && (_state == IDLE || _state == WAIT_TOKEN) && host_ns < _busy_until) {
+        return 0x00;
+    }
+    if (!_out.empty()) {
+        int in = _out.front();
+        _out.pop_front();
+        return in;
+    }
+    switch (_state) {
+        case WAIT_TOKEN:
+            if (out == 0xFE || (_multi && out == 0xFC)) {
+                _state = DATA;
+                _rx.clear();
+            } else if (_multi && out == 0xFD) {
+                _state = IDLE;
+                _multi = false;
+                _pre_erased = 0;
+                _out.push_back(0xFF);
+                _out.push_back(0x00);
+            }
+            break;
+        case DATA:
+            _rx.push_back(_rx.size() < 512 ? flip(out) : out);
+            if (_rx.size() == 514) {
+                _state = _multi ? WAIT_TOKEN : IDLE;
+                store();
+            }
+            break;
+        case FRAME:
+            _frame[_fpos++] = out;
+            if (_fpos == 6) {
+                _state = IDLE;
+                command();
+            }
+            break;
+        case IDLE:
+            if ((out & 0xC0) == 0x40) {
+                _state = FRAME;
+                _fpos = 0;
+                _frame[_fpos++] = out;
+            }
+            break;
+    }
+    return 0xFF;
+}
@@ -0,0 +1,92 @@
+/* SD card model on the SPI bus, for the host benchmarks.
+ *
+ * It answers the commands SDFileSystem sends: init (CMD0/8/55/41/58/59),
+ * CSD and SD status, single and multiple block reads and writes, ACMD23
+ * and erase (CMD32/33/38). Sectors are kept sparse, so a 4GB card costs
+ * only what is written to it.
+ *
+ * The cost model is the part that matters for the numbers:
+ * - ACMD41 answers "idle" until ready_us after the first one;
+ * - a written block holds the card busy for write_us, plus rewrite_us when
+ *   the block was written before and has not been erased since (the card
+ *   has to erase it first), unless ACMD23 announced it as part of a CMD25;
+ * - a written block in an allocation unit that is not one of the open_aus
+ *   most recently written ones costs au_open_us more, the card closes one
+ *   (garbage collection) to open it;
+ * - CMD38 holds the card busy for erase_us plus 1us per 64 blocks;
+ * - with flip_rate > 0, bytes of data blocks flip a bit in either direction
+ *   at that rate, CRCs are checked when the host turned CMD59 on.
+ *
+ * A version 1 card (sdhc = false) has a version 1 CSD. With erase_blk_en
+ * false, CMD38 erases whole groups of erase_group blocks around the range,
+ * like such cards do.
+ */
+#ifndef SDCARDSIM_H
+#define SDCARDSIM_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+class SDCardSim {
+public:
+    SDCardSim(uint32_t sectors);
+    ~SDCardSim();
+
+    // plug into the SPI hook, one card at a time
+    void attach();
+
+    uint8_t *sector(uint32_t n);            // NULL if never written
+    bool written(uint32_t n) { return _dirty[n]; }
+
+    // configuration, set before disk_initialize()
+    bool sdhc;
+    bool erase_blk_en;
+    uint32_t erase_group;                   // blocks, version 1 cards
+    uint32_t au_sectors;                    // allocation unit in ACMD13, 0 for none
+    uint32_t open_aus;
+    uint32_t au_open_us;
+    uint32_t ready_us;
+    uint32_t write_us;
+    uint32_t rewrite_us;
+    uint32_t erase_us;
+    double flip_rate;
+
+    struct Stats {
+        unsigned long commands, reads, writes, multi_writes, rewrites, erases, erased, flips;
+        unsigned long erase_cmds;           // CMD38 count
+        unsigned long au_opens;
+    } stats;
+    void (*on_command)(int cmd, uint32_t arg);
+
+    int spi(int out);
+
+private:
+    void command();
+    void send_block(const uint8_t *data, int n);
+    void store();
+    uint8_t flip(uint8_t b);
+    bool open_au(uint32_t block);
+    uint32_t block(uint32_t arg) { return sdhc ? arg : arg / 512; }
+
+    uint32_t _sectors;
+    std::vector<uint8_t*> _data;
+    std::vector<bool> _dirty;
+    std::deque<int> _out;
+    enum { IDLE, FRAME, WAIT_TOKEN, DATA } _state;
+    uint8_t _frame[6];
+    int _fpos;
+    std::vector<uint8_t> _rx;
+    uint32_t _waddr;
+    bool _multi;
+    bool _app;
+    bool _idle;
+    bool _crc;
+    uint64_t _first_acmd41;
+    uint32_t _erase_start, _erase_end, _pre_erased;
+    uint64_t _busy_until;
+    std::deque<uint32_t> _open;             // most recently written first
+    uint32_t _rng;
+};
+
+#endif
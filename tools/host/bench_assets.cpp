@@ -0,0 +1,87 @@
+// Images kept on the uLCD's own card: uploading two 128x128 test images
+// of images.py through LCDAssets, adding them again after a remount, which
+// must write nothing, and drawing them by name against sending the pixels
+// with BLIT565. The images come from the directory given on the command
+// line and are checked against the screen's frame buffer.
+#include "uLCD_4DGL.h"
+#include "LCDAssets.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+static char path[3][256];
+
+// pixels that differ from the RGB565 file
+static int wrong(const char *file) {
+    FILE *fp = fopen(file, "rb");
+    int bad = 0;
+    for (int i = 0; i < 128 * 128; i++) {
+        int hi = fgetc(fp);
+        int lo = fgetc(fp);
+        bad += screen.fb[i / 128][i % 128] != (hi << 8 | lo);
+    }
+    fclose(fp);
+    memset(screen.fb, 0, sizeof screen.fb);
+    return bad;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        puts("usage: assets IMAGEDIR");
+        return 1;
+    }
+    static const char *names[] = {"board", "strike", "noise"};
+    for (int i = 0; i < 3; i++) {
+        snprintf(path[i], sizeof path[i], "%s/%s.565", argv[1], names[i]);
+    }
+    screen.attach();
+    {
+        LCDAssets assets(LCD, 100);
+        int count = assets.mount();
+        unsigned long writes = screen.stats.sector_writes;
+        uint64_t t0 = host_ns;
+        int board = assets.add("board", path[0], 128, 128);
+        int strike = assets.add("strike", path[1], 128, 128);
+        printf("  empty card, %d images: add() returns %d and %d, %lu sector writes, %lu bytes, %.1f s\n", count,
+               board, strike, screen.stats.sector_writes - writes, (unsigned long)assets.uploaded(),
+               (host_ns - t0) / 1e9);
+    }
+
+    LCDAssets assets(LCD, 100);
+    int count = assets.mount();
+    unsigned long writes = screen.stats.sector_writes;
+    uint64_t t0 = host_ns;
+    int board = assets.add("board", path[0], 128, 128);
+    int strike = assets.add("strike", path[1], 128, 128);
+    printf("  remounted, %d images: add() returns %d and %d, %lu sector writes, %.1f ms\n", count, board, strike,
+           screen.stats.sector_writes - writes, (host_ns - t0) / 1e6);
+
+    t0 = host_ns;
+    assets.show("board", 0, 0);
+    double queued = (host_ns - t0) / 1e6;
+    LCD.wait_idle();
+    printf("  show(board): returns after %.3f ms, drawn after %.1f ms, %d pixels wrong\n", queued,
+           (host_ns - t0) / 1e6, wrong(path[0]));
+    assets.show("strike", 0, 0);
+    LCD.wait_idle();
+    printf("  show(strike): %d pixels wrong\n", wrong(path[1]));
+
+    FILE *fp = fopen(path[0], "rb");
+    t0 = host_ns;
+    LCD.BLIT565(0, 0, 128, 128, fp);
+    LCD.wait_idle();
+    fclose(fp);
+    printf("  BLIT565 of the board instead: %.1f ms\n", (host_ns - t0) / 1e6);
+
+    // a changed image of the same size goes over the old one
+    uint32_t sector = assets.find("strike")->sector;
+    writes = screen.stats.sector_writes;
+    int changed = assets.add("strike", path[2], 128, 128);
+    assets.show("strike", 0, 0);
+    LCD.wait_idle();
+    printf("  strike changed: add() returns %d, %lu sector writes, sector %lu then %lu, %d pixels wrong\n", changed,
+           screen.stats.sector_writes - writes, (unsigned long)sector, (unsigned long)assets.find("strike")->sector,
+           wrong(path[2]));
+    printf("  %lu protocol errors\n", (unsigned long)LCD.errors());
+    return 0;
+}
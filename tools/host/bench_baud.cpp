@@ -0,0 +1,38 @@
+// Baud rate negotiation with the uLCD: how long negotiate_baud(3000000)
+// takes and where it ends up, on a screen that takes any rate and on one
+// that refuses anything above 115200, and how long a full screen of putc()
+// text takes at 9600 baud and at the rate reached.
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static void text(uLCD_4DGL &LCD, LCDSim &screen) {
+    uint64_t t0 = host_ns;
+    LCD.cls();
+    for (int row = 0; row < 16; row++) {
+        for (int col = 0; col < 18; col++) {
+            LCD.putc('A' + (row + col) % 26);
+        }
+    }
+    LCD.wait_idle();
+    printf("  %7d baud: full screen of text in %6.0f ms, %lu overruns\n", LCD.baud(), (host_ns - t0) / 1e6,
+           screen.stats.overruns);
+}
+
+static void run(int max_baud) {
+    LCDSim screen;
+    screen.max_baud = max_baud;
+    screen.attach();
+    uLCD_4DGL LCD(p28, p27, p30, false);
+    printf("screen takes up to %d baud\n", max_baud);
+    text(LCD, screen);
+    uint64_t t0 = host_ns;
+    int rate = LCD.negotiate_baud(3000000);
+    printf("  negotiated %d baud in %.0f ms\n", rate, (host_ns - t0) / 1e6);
+    text(LCD, screen);
+}
+
+int main() {
+    run(3000000);
+    run(115200);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// BLIT565 from each source: a 32x32 block from an int array through BLIT,
+// and from a uint16_t array, a reader callback and a FILE* through
+// BLIT565, at 115200 and 3M baud. Each must leave the same pixels in the
+// screen's frame buffer. A reader that runs dry after 100 bytes must
+// leave the link in step for the next command.
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+static int colors[32 * 32];
+static uint16_t pixels[32 * 32];
+static char raw[2 * 32 * 32];
+
+struct Source {
+    const char *p;
+    int left;
+};
+
+static int source(void *ctx, char *data, int length) {
+    Source *s = (Source *)ctx;
+    if (length > s->left) {
+        length = s->left;
+    }
+    memcpy(data, s->p, length);
+    s->p += length;
+    s->left -= length;
+    return length;
+}
+
+static int wrong() {
+    int bad = 0;
+    for (int i = 0; i < 32 * 32; i++) {
+        bad += screen.fb[i / 32][i % 32] != pixels[i];
+    }
+    memset(screen.fb, 0, sizeof screen.fb);
+    return bad;
+}
+
+static void report(const char *what, uint64_t t0) {
+    LCD.wait_idle();
+    printf("  %-9s %7.1f ms, %d pixels wrong\n", what, (host_ns - t0) / 1e6, wrong());
+}
+
+int main() {
+    screen.attach();
+    for (int i = 0; i < 32 * 32; i++) {
+        colors[i] = i * 2654435761u & 0xFFFFFF;
+        pixels[i] = LCD_RGB565(colors[i]);
+        raw[2 * i] = pixels[i] >> 8;
+        raw[2 * i + 1] = pixels[i];
+    }
+    FILE *fp = tmpfile();
+    fwrite(raw, 1, sizeof raw, fp);
+
+    static const int rates[] = {115200, 3000000};
+    for (int r = 0; r < 2; r++) {
+        LCD.negotiate_baud(rates[r]);
+        printf("%d baud\n", LCD.baud());
+        uint64_t t0 = host_ns;
+        LCD.BLIT(0, 0, 32, 32, colors);
+        report("BLIT", t0);
+        t0 = host_ns;
+        LCD.BLIT565(0, 0, 32, 32, pixels);
+        report("array", t0);
+        Source s = {raw, sizeof raw};
+        t0 = host_ns;
+        LCD.BLIT565(0, 0, 32, 32, source, &s);
+        report("reader", t0);
+        rewind(fp);
+        t0 = host_ns;
+        LCD.BLIT565(0, 0, 32, 32, fp);
+        report("FILE*", t0);
+
+        Source dry = {raw, 100};
+        int ret = LCD.BLIT565(0, 0, 32, 32, source, &dry);
+        LCD.wait_idle();
+        int pixel = LCD.read_pixel(1, 0);
+        printf("  short reader returns %d, read_pixel() after it %s, %lu protocol errors\n", ret,
+               pixel == pixels[1] ? "right" : "wrong", (unsigned long)LCD.errors());
+    }
+    fclose(fp);
+    return 0;
+}
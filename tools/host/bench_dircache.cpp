@@ -0,0 +1,61 @@
+// Opening files again from a directory of a thousand, with and without the
+// directory lookup cache (_FS_DCACHE, run.sh builds this twice).
+//
+// The files have long names like the game's sounds. The 8 files at the end
+// of the directory, the slowest to find by a scan, are opened through
+// FATFileSystem::open() three times over after a remount.
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+
+#define FILES   1000
+#define HOT     8
+
+static SDCardSim card(128 * 1024);      // 64MB
+static SDFileSystem sd(p5, p6, p7, p8, "sd");
+
+int main() {
+    card.ready_us = 1000;
+    card.attach();
+    if (sd.format() || sd.mount()) {
+        puts("format failed");
+        return 1;
+    }
+    sd.mkdir("sounds", 0777);
+    char name[64];
+    for (int i = 0; i < FILES; i++) {
+        sprintf(name, "sounds/family-feud-%04d.wav", i);
+        FileHandle *f = sd.open(name, O_WRONLY | O_CREAT);
+        if (f == NULL) {
+            printf("create %s failed\n", name);
+            return 1;
+        }
+        f->write(name, 8);
+        f->close();
+    }
+    sd.unmount();
+    sd.mount();
+
+    printf("_FS_DCACHE %d, %d files:\n", _FS_DCACHE, FILES);
+    for (int pass = 1; pass <= 3; pass++) {
+        unsigned long reads = card.stats.reads;
+        uint64_t t0 = host_ns;
+        for (int i = FILES - HOT; i < FILES; i++) {
+            sprintf(name, "sounds/family-feud-%04d.wav", i);
+            FileHandle *f = sd.open(name, O_RDONLY);
+            if (f == NULL) {
+                printf("open %s failed\n", name);
+                return 1;
+            }
+            f->close();
+        }
+        printf("  pass %d: %6.1f ms per open, %5.1f sector reads per open", pass,
+               (host_ns - t0) / 1e6 / HOT, (card.stats.reads - reads) / (double)HOT);
+#if _FS_DCACHE
+        DWORD hit, miss;
+        f_dcstat("0:", &hit, &miss);
+        printf(", %lu hits %lu misses so far", (unsigned long)hit, (unsigned long)miss);
+#endif
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Streaming a file on a 1GB card formatted the way format() used to do it,
+// 512-byte clusters and the partition at sector 63, and by format() now.
+//
+// The old layout is made by the current f_mkfs on a card that reports no
+// erase block, which is what it did before. The card has 4MB allocation
+// units, two of them open at a time, and opening another costs 20ms. A
+// 4MB file is written in 4kB f_write() calls and read back the same way.
+// Sector reads and writes that fall into the FAT are counted separately.
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+
+#define SECTORS     (2u * 1024 * 1024)      // 1GB
+#define FILE_SIZE   (4 * 1024 * 1024)
+#define CHUNK       4096
+
+// an SDFileSystem as f_mkfs saw it before it asked for the erase block
+class NoEraseBlockSD : public SDFileSystem {
+public:
+    NoEraseBlockSD(const char *name) : SDFileSystem(p5, p6, p7, p8, name) {}
+    virtual uint32_t disk_block_size() { return 1; }
+};
+
+static DWORD fat_first, fat_end;
+static unsigned long fat_reads, fat_writes;
+
+static int inits;
+
+static void count_init(int cmd, uint32_t) {
+    inits += cmd == 0;
+}
+
+static void count_fat(int cmd, uint32_t arg) {
+    if (arg >= fat_first && arg < fat_end) {
+        if (cmd == 17) {
+            fat_reads++;
+        } else if (cmd == 24 || cmd == 25) {
+            fat_writes++;
+        }
+    }
+}
+
+static void run(const char *what, SDFileSystem &sd, SDCardSim &card, const FATFormatOptions &options) {
+    card.ready_us = 1000;
+    card.au_open_us = 20000;
+    card.attach();
+    inits = 0;
+    card.on_command = count_init;
+    int res = sd.format(options);
+    card.on_command = 0;
+    if (res || sd.mount()) {
+        puts("format failed");
+        return;
+    }
+    FileHandle *f = sd.open("stream.bin", O_WRONLY | O_CREAT | O_TRUNC);
+    f->close();
+    sd.unmount();
+    sd.mount();
+
+    static char buf[CHUNK];
+    memset(buf, 0x5A, sizeof(buf));
+    FATFS *fs = &sd._fs;
+    fat_first = fs->fatbase;
+    fat_end = fs->fatbase + fs->fsize * fs->n_fats;
+    card.on_command = count_fat;
+
+    printf("%s: partition at %lu, FAT at %lu, data at %lu, %d-byte clusters, card reset %d times by format()\n",
+           what, (unsigned long)fs->volbase, (unsigned long)fs->fatbase, (unsigned long)fs->database, fs->csize * 512,
+           inits);
+
+    fat_reads = fat_writes = 0;
+    unsigned long opens = card.stats.au_opens;
+    uint64_t t0 = host_ns;
+    f = sd.open("stream.bin", O_WRONLY | O_TRUNC);
+    for (int n = 0; n < FILE_SIZE; n += CHUNK) {
+        f->write(buf, CHUNK);
+    }
+    f->close();
+    double mb = FILE_SIZE / 1048576.0;
+    printf("  write: %5.0f kB/s, %6.1f FAT reads and %6.1f FAT writes per MB, %5.1f AU opens per MB\n",
+           FILE_SIZE / 1024.0 / ((host_ns - t0) / 1e9), fat_reads / mb, fat_writes / mb,
+           (card.stats.au_opens - opens) / mb);
+
+    fat_reads = fat_writes = 0;
+    t0 = host_ns;
+    f = sd.open("stream.bin", O_RDONLY);
+    for (int n = 0; n < FILE_SIZE; n += CHUNK) {
+        f->read(buf, CHUNK);
+    }
+    f->close();
+    printf("  read:  %5.0f kB/s, %6.1f FAT reads per MB\n",
+           FILE_SIZE / 1024.0 / ((host_ns - t0) / 1e9), fat_reads / mb);
+    card.on_command = 0;
+}
+
+int main() {
+    {
+        SDCardSim card(SECTORS);
+        NoEraseBlockSD sd("old");
+        FATFormatOptions options;
+        options.cluster_size = 512;
+        run("before", sd, card, options);
+    }
+    {
+        SDCardSim card(SECTORS);
+        SDFileSystem sd(p5, p6, p7, p8, "sd");
+        run("format()", sd, card, FATFormatOptions());
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Cluster allocation latency on a nearly full 4GB card, with and without
+// the free cluster map (_FS_FREEMAP, run.sh builds this twice).
+//
+// The card is formatted, filled with 32MB files each followed by a one
+// cluster file, and the small files are deleted again. That leaves one free
+// cluster every 1024, 99.9% full. After a remount a new file is grown one
+// cluster at a time with f_lseek, which allocates without writing data, so
+// the time measured is the FAT reads and writes of create_chain().
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+
+#define SECTORS     (8u * 1024 * 1024)      // 4GB
+#define BIG_CLUSTERS 1023
+#define GROW        64
+
+static SDCardSim card(SECTORS);
+static SDFileSystem sd(p5, p6, p7, p8, "sd");
+
+static void fill() {
+    FIL f;
+    char name[32];
+    DWORD cluster = sd._fs.csize * 512;
+    for (int i = 0; ; i++) {
+        sprintf(name, "0:/b%d", i);
+        if (f_open(&f, name, FA_WRITE | FA_CREATE_ALWAYS)) {
+            break;
+        }
+        FRESULT res = f_lseek(&f, (DWORD)BIG_CLUSTERS * cluster);
+        bool full = res != FR_OK || f.fptr != (DWORD)BIG_CLUSTERS * cluster;
+        f_close(&f);
+        sprintf(name, "0:/h%d", i);
+        if (full || f_open(&f, name, FA_WRITE | FA_CREATE_ALWAYS)) {
+            break;
+        }
+        res = f_lseek(&f, cluster);
+        f_close(&f);
+        if (res != FR_OK || f.fsize != cluster) {
+            break;
+        }
+    }
+    for (int i = 0; ; i++) {
+        sprintf(name, "0:/h%d", i);
+        if (f_unlink(name)) {
+            break;
+        }
+    }
+}
+
+static void grow(const char *what) {
+    FIL f;
+    DWORD cluster = sd._fs.csize * 512;
+    f_open(&f, "0:/new", FA_WRITE | FA_CREATE_ALWAYS);
+    uint64_t total = 0, worst = 0;
+    unsigned long reads = card.stats.reads;
+    for (int i = 1; i <= GROW; i++) {
+        uint64_t t0 = host_ns;
+        f_lseek(&f, (DWORD)i * cluster);
+        uint64_t t = host_ns - t0;
+        total += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+    f_close(&f);
+    f_unlink("0:/new");
+    printf("  %-22s %5.1f ms per cluster (worst %6.1f ms), %4.1f sector reads per cluster\n", what,
+           total / 1e6 / GROW, worst / 1e6, (card.stats.reads - reads) / (double)GROW);
+}
+
+int main() {
+    card.ready_us = 1000;
+    card.attach();
+    if (sd.format() || sd.mount()) {
+        puts("format failed");
+        return 1;
+    }
+    fill();
+
+    DWORD free_clusters;
+    FATFS *fs;
+    sd.unmount();
+    sd.mount();
+    f_getfree("0:", &free_clusters, &fs);
+    printf("_FS_FREEMAP %d: %lu of %lu clusters free, %d-byte clusters, %d bytes of RAM for the map\n",
+           _FS_FREEMAP, (unsigned long)free_clusters, (unsigned long)(fs->n_fatent - 2), fs->csize * 512, _FS_FREEMAP);
+
+    // the map only knows the groups the allocator has scanned, the third
+    // round wraps around into them
+    sd.unmount();
+    sd.mount();
+    grow("after mount, round 1:");
+    grow("round 2:");
+    grow("round 3:");
+
+    // a full FAT scan fills the whole map, FSINFO is trusted otherwise
+    sd.unmount();
+    sd.mount();
+    fs->free_clust = 0xFFFFFFFF;
+    uint64_t t0 = host_ns;
+    f_getfree("0:", &free_clusters, &fs);
+    printf("  f_getfree() FAT scan: %.0f ms\n", (host_ns - t0) / 1e6);
+    grow("after the scan:");
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Bytes sent per scoreboard refresh: the whole board printed with
+// locate() and printf() as threadLCD used to, against the text grid that
+// sends only the cells that changed, for a sequence of game states.
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+
+static void printed(int round, int a, int b) {
+    LCD.locate(0, 0);
+    LCD.printf("Welcome to Family Feud!");
+    LCD.printf("\n\nRound %d", round);
+    LCD.printf("\n\nScores");
+    LCD.printf("\nTeam A: %d  ", a);
+    LCD.printf("\nTeam B: %d  ", b);
+}
+
+// the same lines as threadLCD
+static int grid(int round, int a, int b) {
+    char line[20];
+    LCD.text_print(0, 0, "Welcome to Family Feud!", WHITE);
+    snprintf(line, sizeof line, "Round %d  ", round);
+    LCD.text_print(0, 3, line, WHITE);
+    LCD.text_print(0, 5, "Scores", WHITE);
+    snprintf(line, sizeof line, "Team A: %d  ", a);
+    LCD.text_print(0, 6, line, WHITE);
+    snprintf(line, sizeof line, "Team B: %d  ", b);
+    LCD.text_print(0, 7, line, WHITE);
+    return LCD.text_flush();
+}
+
+int main() {
+    screen.attach();
+    static const int states[][3] = {{0, 0, 0}, {0, 0, 0}, {1, 0, 0}, {1, 45, 0}, {1, 45, 0}, {2, 45, 120}};
+    static const char *what[] = {"first draw", "no change", "round", "score A", "no change", "round, score B"};
+    for (int i = 0; i < 6; i++) {
+        unsigned long bytes = screen.stats.bytes;
+        uint64_t t0 = host_ns;
+        printed(states[i][0], states[i][1], states[i][2]);
+        LCD.wait_idle();
+        unsigned long printed_bytes = screen.stats.bytes - bytes;
+        double printed_ms = (host_ns - t0) / 1e6;
+
+        bytes = screen.stats.bytes;
+        t0 = host_ns;
+        grid(states[i][0], states[i][1], states[i][2]);
+        LCD.wait_idle();
+        printf("  %-14s printf: %3lu bytes %6.1f ms   grid: %3lu bytes %6.1f ms\n", what[i], printed_bytes, printed_ms,
+               screen.stats.bytes - bytes, (host_ns - t0) / 1e6);
+    }
+    printf("  at 9600 baud, %lu overruns\n", screen.stats.overruns);
+    return 0;
+}
@@ -0,0 +1,45 @@
+// How long a caller is held by the uLCD driver, which is how long
+// threadLCD holds main's mut: a first draw of the scoreboard through the
+// text grid and a 16x16 BLIT, at 9600 and 115200 baud. The time until the
+// screen has answered is measured with a read_pixel() after the call, so
+// this also runs against drivers from before wait_idle().
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+static int colors[16 * 16];
+
+int main() {
+    screen.attach();
+    static const int rates[] = {9600, 115200};
+    for (int r = 0; r < 2; r++) {
+        LCD.negotiate_baud(rates[r]);
+        LCD.cls();
+        LCD.text_redraw();
+        char line[20];
+        uint64_t t0 = host_ns;
+        LCD.text_print(0, 0, "Welcome to Family Feud!", WHITE);
+        snprintf(line, sizeof line, "Round %d  ", 1);
+        LCD.text_print(0, 3, line, WHITE);
+        LCD.text_print(0, 5, "Scores", WHITE);
+        snprintf(line, sizeof line, "Team A: %d  ", 0);
+        LCD.text_print(0, 6, line, WHITE);
+        snprintf(line, sizeof line, "Team B: %d  ", 0);
+        LCD.text_print(0, 7, line, WHITE);
+        LCD.text_flush();
+        double held = (host_ns - t0) / 1e6;
+        LCD.read_pixel(0, 0);
+        printf("  %6d baud: scoreboard returns after %6.2f ms, screen done after %6.1f ms\n", LCD.baud(), held,
+               (host_ns - t0) / 1e6);
+
+        t0 = host_ns;
+        LCD.BLIT(0, 0, 16, 16, colors);
+        held = (host_ns - t0) / 1e6;
+        LCD.read_pixel(0, 0);
+        printf("  %6d baud: 16x16 BLIT returns after %6.2f ms, screen done after %6.1f ms\n", LCD.baud(), held,
+               (host_ns - t0) / 1e6);
+    }
+    printf("  %lu overruns\n", screen.stats.overruns);
+    return 0;
+}
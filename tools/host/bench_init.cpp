@@ -0,0 +1,34 @@
+// Card initialisation time, and how much of it the CPU spends spinning in
+// wait_us() rather than sleeping in Thread::wait(), where the other boot
+// threads can run. The card model leaves the idle state a given time after
+// the first ACMD41.
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+
+static unsigned long acmd41s;
+static bool app;
+
+static void count_acmd41(int cmd, uint32_t) {
+    if (app && cmd == 41) {
+        acmd41s++;
+    }
+    app = cmd == 55;
+}
+
+int main() {
+    static const uint32_t ready_ms[] = {5, 50, 250, 1000};
+    for (int i = 0; i < 4; i++) {
+        SDCardSim card(64 * 1024);
+        SDFileSystem sd(p5, p6, p7, p8, "sd");
+        card.ready_us = ready_ms[i] * 1000;
+        card.on_command = count_acmd41;
+        card.attach();
+        acmd41s = 0;
+        uint64_t t0 = host_ns, spin = host_spin_ns, sleep = host_sleep_ns;
+        int res = sd.disk_initialize();
+        printf("  card ready after %4lu ms: init %s in %6.1f ms, %6.1f ms spinning, %6.1f ms sleeping, %2lu ACMD41\n",
+               (unsigned long)ready_ms[i], res ? "failed" : "done", (host_ns - t0) / 1e6,
+               (host_spin_ns - spin) / 1e6, (host_sleep_ns - sleep) / 1e6, acmd41s);
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Commands per second through the uLCD driver's command queue, at 9600
+// and 115200 baud: the scoreboard threadLCD printed before the text grid,
+// five times, and 300 short drawing commands. Time runs to the answer of
+// a read_pixel() after the last command, which waits for all of them, so
+// the same program runs against the blocking driver from before the queue.
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+
+static void scoreboard(int n) {
+    LCD.locate(0, 0);
+    LCD.printf("Welcome to Family Feud!");
+    LCD.printf("\n\nRound %d", n);
+    LCD.printf("\n\nScores");
+    LCD.printf("\nTeam A: %d  ", n * 10);
+    LCD.printf("\nTeam B: %d  ", n * 7);
+}
+
+int main() {
+    screen.attach();
+    static const int rates[] = {9600, 115200};
+    for (int r = 0; r < 2; r++) {
+        LCD.baudrate(rates[r]);
+        wait_ms(300);
+
+        unsigned long commands = screen.stats.commands;
+        uint64_t t0 = host_ns;
+        for (int n = 0; n < 5; n++) {
+            scoreboard(n);
+        }
+        LCD.read_pixel(0, 0);
+        double s = (host_ns - t0) / 1e9;
+        printf("  %6d baud, scoreboard: %4lu commands, %5.0f cmds/s, %6.1f ms per refresh\n", rates[r],
+               screen.stats.commands - commands, (screen.stats.commands - commands) / s, s * 1000 / 5);
+
+        commands = screen.stats.commands;
+        t0 = host_ns;
+        for (int n = 0; n < 100; n++) {
+            LCD.filled_rectangle(n, n, n + 5, n + 5, RED);
+            LCD.pixel(n, 2, WHITE);
+            LCD.circle(64, 64, n % 30, GREEN);
+        }
+        LCD.read_pixel(0, 0);
+        s = (host_ns - t0) / 1e9;
+        printf("  %6d baud, primitives: %4lu commands, %5.0f cmds/s\n", rates[r],
+               screen.stats.commands - commands, (screen.stats.commands - commands) / s);
+    }
+    printf("  %lu overruns, at most %lu bytes buffered\n", screen.stats.overruns,
+           (unsigned long)screen.stats.max_buffered);
+    return 0;
+}
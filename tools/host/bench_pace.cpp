@@ -0,0 +1,40 @@
+// Pacing of long uLCD commands: a 60-character text_string() and a 32x32
+// BLIT at 9600 baud to 3M, with the time each takes and whether the
+// screen's 16-byte receive buffer overran. Time runs to the answer of a
+// read_pixel() after the command, so this also runs against drivers from
+// before wait_idle().
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+static int colors[32 * 32];
+
+int main() {
+    screen.attach();
+    static const int rates[] = {9600, 115200, 256000, 1000000, 3000000};
+    char s[61];
+    for (int i = 0; i < 60; i++) {
+        s[i] = 'a' + i % 26;
+    }
+    s[60] = 0;
+    for (int i = 0; i < 32 * 32; i++) {
+        colors[i] = i * 2654435761u;
+    }
+    for (int r = 0; r < 5; r++) {
+        LCD.negotiate_baud(rates[r]);
+        unsigned long overruns = screen.stats.overruns;
+        uint64_t t0 = host_ns;
+        for (int n = 0; n < 5; n++) {
+            LCD.text_string(s, 0, 0, FONT_7X8, WHITE);
+        }
+        LCD.read_pixel(0, 0);
+        double text_ms = (host_ns - t0) / 5e6;
+        t0 = host_ns;
+        LCD.BLIT(0, 0, 32, 32, colors);
+        LCD.read_pixel(0, 0);
+        printf("  %7d baud: 60-char text_string %6.1f ms, 32x32 BLIT %6.1f ms, %lu overruns\n", LCD.baud(),
+               text_ms, (host_ns - t0) / 1e6, screen.stats.overruns - overruns);
+    }
+    return 0;
+}
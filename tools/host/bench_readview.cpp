@@ -0,0 +1,97 @@
+// Bytes copied per byte delivered when streaming a 16-bit stereo wave
+// file to a sample consumer, the way wave_player reads it (one 4-byte
+// slice per read()), with read() into a 512-byte buffer, and with
+// read_view() straight out of the file's sector cache.
+//
+// f_read() reads whole sectors straight into the caller's buffer and
+// copies the rest out of the file's sector buffer, so the bytes it copies
+// are counted from the file position and length of each call. The
+// consumer sums the samples; the three sums must match.
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+#include "FATFileHandle.h"
+
+#define FILE_SIZE   (1024 * 1024)
+
+static unsigned long copied;
+
+// bytes f_read() copies out of the sector buffer for a read at pos
+static void count(uint32_t pos, uint32_t n) {
+    uint32_t head = (512 - pos % 512) % 512;
+    if (head > n) {
+        head = n;
+    }
+    copied += head + (n - head) % 512;
+}
+
+static long long consume(const void *data, size_t n) {
+    const int16_t *s = (const int16_t *)data;
+    long long sum = 0;
+    for (size_t i = 0; i < n / 2; i++) {
+        sum += s[i];
+    }
+    return sum;
+}
+
+static void report(const char *what, long long sum, uint64_t t0, int ram) {
+    printf("  %-22s %4.2f bytes copied per byte, %3d bytes of buffer, %5.0f kB/s, sum %lld\n", what,
+           (double)copied / FILE_SIZE, ram, FILE_SIZE / 1024.0 / ((host_ns - t0) / 1e9), sum);
+}
+
+int main() {
+    SDCardSim card(64 * 1024);
+    SDFileSystem sd(p5, p6, p7, p8, "sd");
+    card.ready_us = 1000;
+    card.attach();
+    if (sd.format() || sd.mount()) {
+        puts("format failed");
+        return 1;
+    }
+    FileHandle *f = sd.open("song.wav", O_WRONLY | O_CREAT | O_TRUNC);
+    static int16_t buf[2048];
+    for (int k = 0; k < FILE_SIZE / 4096; k++) {
+        for (int i = 0; i < 2048; i++) {
+            buf[i] = (k * 2048 + i) * 40503;
+        }
+        f->write(buf, 4096);
+    }
+    f->close();
+
+    char slice[4];
+    long long sum = 0;
+    copied = 0;
+    f = sd.open("song.wav", O_RDONLY);
+    uint64_t t0 = host_ns;
+    for (uint32_t pos = 0; pos < FILE_SIZE; pos += sizeof slice) {
+        f->read(slice, sizeof slice);
+        count(pos, sizeof slice);
+        sum += consume(slice, sizeof slice);
+    }
+    f->close();
+    report("read() 4-byte slices", sum, t0, sizeof slice);
+
+    sum = 0;
+    copied = 0;
+    f = sd.open("song.wav", O_RDONLY);
+    t0 = host_ns;
+    for (uint32_t pos = 0; pos < FILE_SIZE; pos += 512) {
+        f->read(buf, 512);
+        count(pos, 512);
+        sum += consume(buf, 512);
+    }
+    f->close();
+    report("read() 512 bytes", sum, t0, 512);
+
+    sum = 0;
+    copied = 0;
+    FATFileHandle *fh = (FATFileHandle *)sd.open("song.wav", O_RDONLY);
+    t0 = host_ns;
+    const void *data;
+    ssize_t n;
+    while ((n = fh->read_view(&data, 512)) > 0) {
+        sum += consume(data, n);
+    }
+    fh->close();
+    report("read_view()", sum, t0, 0);
+    return 0;
+}
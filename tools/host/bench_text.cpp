@@ -0,0 +1,62 @@
+// text_string() at 9600 baud and 3M: the time and bytes for a 60-character
+// string, and receive buffer overruns. Strings of 1 to 13 characters and
+// a text grid refresh are hashed (FNV-1a) apart, since those must go out
+// unchanged when long strings are split into pieces.
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+
+static uint32_t hash(size_t from) {
+    uint32_t h = 2166136261u;
+    for (size_t i = from; i < screen.wire.size(); i++) {
+        h = (h ^ screen.wire[i]) * 16777619u;
+    }
+    return h;
+}
+
+int main() {
+    screen.attach();
+    char s[61];
+    for (int i = 0; i < 60; i++) {
+        s[i] = 'a' + i % 26;
+    }
+    s[60] = 0;
+
+    size_t from = screen.wire.size();
+    for (int n = 1; n <= 13; n++) {
+        char c = s[n];
+        s[n] = 0;
+        LCD.text_string(s, 0, n, FONT_7X8, WHITE);
+        s[n] = c;
+    }
+    LCD.wait_idle();
+    printf("  strings of 1 to 13 characters: %lu bytes, hash %08lx\n", (unsigned long)(screen.wire.size() - from),
+           (unsigned long)hash(from));
+    from = screen.wire.size();
+    LCD.text_print(0, 0, "Welcome to Family Feud!", WHITE);
+    LCD.text_print(0, 3, "Round 1  ", WHITE);
+    LCD.text_print(0, 5, "Scores", WHITE);
+    LCD.text_print(0, 6, "Team A: 45  ", WHITE);
+    LCD.text_print(0, 7, "Team B: 120  ", WHITE);
+    LCD.text_flush();
+    LCD.wait_idle();
+    printf("  text grid: %lu bytes, hash %08lx\n", (unsigned long)(screen.wire.size() - from),
+           (unsigned long)hash(from));
+
+    static const int rates[] = {9600, 3000000};
+    for (int r = 0; r < 2; r++) {
+        LCD.negotiate_baud(rates[r]);
+        unsigned long overruns = screen.stats.overruns;
+        unsigned long bytes = screen.stats.bytes;
+        uint64_t t0 = host_ns;
+        for (int n = 0; n < 5; n++) {
+            LCD.text_string(s, 0, 0, FONT_7X8, WHITE);
+        }
+        LCD.wait_idle();
+        printf("  %7d baud: 60-char text_string %lu bytes, %6.1f ms, %lu overruns\n", LCD.baud(),
+               (screen.stats.bytes - bytes) / 5, (host_ns - t0) / 5e6, screen.stats.overruns - overruns);
+    }
+    return 0;
+}
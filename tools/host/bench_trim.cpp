@@ -0,0 +1,116 @@
+// Trimming deleted clusters: sustained write throughput, and whether a
+// version 1 card that cannot erase single blocks loses live data.
+//
+// Throughput: on a 16MB card where rewriting a block that was not erased
+// costs 1.5ms more, a 256kB log is deleted and written again 200 times,
+// so the allocator wraps around the card about three times. The log is
+// written a sector at a time, like EventLog appends, so every block goes
+// out as a single CMD24 that no ACMD23 pre-erases. This runs with and
+// without disk_trim().
+//
+// Data loss: on a version 1 card with ERASE_BLK_EN 0 and 32-block erase
+// sectors, formatted with 2kB clusters, two files are written cluster by
+// cluster in turn and one of them is deleted. The other must read back
+// intact.
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+
+#define SECTORS     (32 * 1024)             // 16MB
+#define LOG_SIZE    (256 * 1024)
+#define ROUNDS      200
+#define CHUNK       4096
+#define APPEND      512
+
+// an SDFileSystem that never erases
+class NoTrimSD : public SDFileSystem {
+public:
+    NoTrimSD(const char *name) : SDFileSystem(p5, p6, p7, p8, name) {}
+    virtual int disk_trim(uint32_t, uint32_t) { return 0; }
+};
+
+static void sustained(const char *what, SDFileSystem &sd) {
+    SDCardSim card(SECTORS);
+    card.ready_us = 1000;
+    card.write_us = 200;
+    card.rewrite_us = 1500;
+    card.attach();
+    if (sd.format() || sd.mount()) {
+        puts("format failed");
+        return;
+    }
+    static char buf[APPEND];
+    memset(buf, 0xA5, sizeof(buf));
+    uint64_t t0 = host_ns, trim_ns = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        uint64_t t1 = host_ns;
+        sd.remove("log.bin");
+        trim_ns += host_ns - t1;
+        FileHandle *f = sd.open("log.bin", O_WRONLY | O_CREAT | O_TRUNC);
+        for (int n = 0; n < LOG_SIZE; n += APPEND) {
+            f->write(buf, APPEND);
+        }
+        f->close();
+    }
+    double s = (host_ns - t0) / 1e9;
+    printf("  %-13s %4.0f kB/s sustained, %6lu blocks rewritten without an erase, %4lu erases, %5.0f ms in remove()\n",
+           what, ROUNDS * (LOG_SIZE / 1024.0) / s, card.stats.rewrites, card.stats.erase_cmds, trim_ns / 1e6);
+    sd.unmount();
+}
+
+static void fill(char *buf, int file, int n) {
+    for (int i = 0; i < CHUNK; i++) {
+        buf[i] = file * 31 + n + i;
+    }
+}
+
+static void v1_no_erase_blk() {
+    SDCardSim card(SECTORS);
+    SDFileSystem sd(p5, p6, p7, p8, "sd");
+    card.ready_us = 1000;
+    card.sdhc = false;
+    card.erase_blk_en = false;
+    card.erase_group = 32;
+    card.attach();
+    FATFormatOptions options;
+    options.cluster_size = 2048;
+    if (sd.format(options) || sd.mount()) {
+        puts("format failed");
+        return;
+    }
+    static char buf[CHUNK], back[CHUNK];
+    for (int n = 0; n < 64 * 1024; n += 2048) {
+        for (int file = 0; file < 2; file++) {
+            FileHandle *f = sd.open(file ? "keep.bin" : "gone.bin", O_WRONLY | O_CREAT | O_APPEND);
+            fill(buf, file, n);
+            f->write(buf, 2048);
+            f->close();
+        }
+    }
+    unsigned long erased = card.stats.erased;
+    sd.remove("gone.bin");
+    int bad = 0;
+    FileHandle *f = sd.open("keep.bin", O_RDONLY);
+    for (int n = 0; n < 64 * 1024; n += 2048) {
+        fill(buf, 1, n);
+        if (f->read(back, 2048) != 2048 || memcmp(back, buf, 2048)) {
+            bad++;
+        }
+    }
+    f->close();
+    printf("  version 1 card, ERASE_BLK_EN 0: %lu blocks erased, %d of 32 clusters of the kept file wrong\n",
+           card.stats.erased - erased, bad);
+    sd.unmount();
+}
+
+int main() {
+    {
+        NoTrimSD sd("notrim");
+        sustained("without trim:", sd);
+    }
+    {
+        SDFileSystem sd(p5, p6, p7, p8, "sd");
+        sustained("with trim:", sd);
+    }
+    v1_no_erase_blk();
+    return 0;
+}
@@ -0,0 +1,77 @@
+// ff_convert() from Unicode to the OEM code page and ff_wtoupper() for all
+// 65536 inputs, built once per code page by run.sh. Every OEM code found
+// must convert back to the same character, and a character without one
+// must have no OEM code that converts to it.
+//
+// With BASE=<checkout>, run.sh also links the ccsbcs.cpp of that checkout
+// with its functions renamed, and every result must match it. This is the
+// one benchmark that measures the host's CPU time, not simulated time.
+#include "ff.h"
+#include <stdio.h>
+#include <time.h>
+
+#ifdef BASE
+extern "C" {
+WCHAR base_ff_convert(WCHAR chr, UINT dir);
+WCHAR base_ff_wtoupper(WCHAR chr);
+}
+#endif
+
+#define PASSES  50
+
+static volatile WCHAR sink;
+
+static double ns_per_call(WCHAR (*f)(WCHAR)) {
+    clock_t t0 = clock();
+    for (int p = 0; p < PASSES; p++) {
+        for (unsigned c = 0; c < 0x10000; c++) {
+            sink = f(c);
+        }
+    }
+    return (clock() - t0) * 1e9 / CLOCKS_PER_SEC / PASSES / 0x10000;
+}
+
+static WCHAR to_oem(WCHAR c) {
+    return ff_convert(c, 0);
+}
+
+static WCHAR to_upper(WCHAR c) {
+    return ff_wtoupper(c);
+}
+
+#ifdef BASE
+static WCHAR base_to_oem(WCHAR c) {
+    return base_ff_convert(c, 0);
+}
+
+static WCHAR base_to_upper(WCHAR c) {
+    return base_ff_wtoupper(c);
+}
+#endif
+
+int main() {
+    int wrong = 0;
+    bool mapped[0x10000] = {false};
+    for (unsigned oem = 0x80; oem < 0x100; oem++) {
+        mapped[ff_convert(oem, 1)] = true;
+    }
+    for (unsigned c = 0x80; c < 0x10000; c++) {
+        WCHAR oem = ff_convert(c, 0);
+        if (oem ? ff_convert(oem, 1) != c : mapped[c]) {
+            wrong++;
+        }
+    }
+    printf("  CP%d: %d conversions to OEM wrong, %.1f ns per ff_convert, %.1f ns per ff_wtoupper\n", _CODE_PAGE, wrong,
+           ns_per_call(to_oem), ns_per_call(to_upper));
+#ifdef BASE
+    int differ = 0;
+    for (unsigned c = 0; c < 0x10000; c++) {
+        differ += ff_convert(c, 0) != base_ff_convert(c, 0) || ff_convert(c, 1) != base_ff_convert(c, 1) ||
+                  ff_wtoupper(c) != base_ff_wtoupper(c);
+    }
+    printf("  CP%d: %d inputs differ from BASE, %.1f ns per ff_convert, %.1f ns per ff_wtoupper there\n", _CODE_PAGE,
+           differ, ns_per_call(base_to_oem), ns_per_call(base_to_upper));
+    wrong += differ;
+#endif
+    return wrong != 0;
+}
@@ -0,0 +1,78 @@
+// Every byte the uLCD driver sends for a run that calls each primitive,
+// the text functions, putc()/printf(), BLIT, BLIT565 and the media
+// commands with several colours. It prints the length and an FNV-1a hash
+// of what the screen received, and writes it to the file given on the
+// command line, so two versions of the driver can be compared with
+//
+//     tools/host/run.sh wire; ROOT=/tmp/old OUT=/tmp/old-bench tools/host/run.sh wire
+//     cmp /tmp/host-bench/wire.bin /tmp/old-bench/wire.bin
+#include "uLCD_4DGL.h"
+#include "LCDSim.h"
+
+static LCDSim screen;
+static uLCD_4DGL LCD(p28, p27, p30, false);
+
+int main(int argc, char **argv) {
+    screen.attach();
+    static int colors[] = {0xFF0000, 0x00FF00, 0x0000FF, 0x123456, 0xFFFFFF, 0x808080};
+    static uint16_t pixels[] = {1, 0xF800, 0x1234, 0xABCD, 0, 0xFFFF};
+    for (int k = 0; k < 6; k++) {
+        int c = colors[k];
+        LCD.circle(10 + k, 300, 5, c);
+        LCD.filled_circle(1, 2, 3, c);
+        LCD.triangle(1, 2, 3, 4, 5, 600, c);
+        LCD.line(1, 2, 3, 4, c);
+        LCD.rectangle(1, 2, 300, 4, c);
+        LCD.filled_rectangle(1, 2, 3, 4, c);
+        LCD.pixel(5, 6, c);
+        LCD.background_color(c);
+        LCD.textbackground_color(c);
+        LCD.color(c);
+        LCD.text_char('A' + k, k, 2, c);
+        LCD.text_string((char *)"Hello", 1, k, FONT_7X8, c);
+        LCD.text_print(k, k, "grid text", c);
+    }
+    LCD.text_flush();
+    LCD.BLIT(0, 0, 3, 2, colors);
+    LCD.BLIT565(1, 1, 3, 2, pixels);
+    LCD.pen_size(1);
+    LCD.display_power(1);
+    LCD.display_control(3);
+    LCD.text_mode(1);
+    LCD.text_bold(1);
+    LCD.text_italic(0);
+    LCD.text_inverse(1);
+    LCD.text_underline(0);
+    LCD.text_width(2);
+    LCD.text_height(2);
+    LCD.locate(3, 4);
+    LCD.printf("ab\ncd\r%s", "a long line of text that wraps around the screen more than once ok\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n");
+    LCD.cls();
+    LCD.set_font(FONT_8X8);
+    LCD.set_byte_address(1, 2);
+    LCD.set_sector_address(3, 0x405);
+    LCD.display_image(5, 6);
+    LCD.display_video(7, 8);
+    LCD.display_frame(1, 2, 3);
+    LCD.media_init();
+    LCD.read_word();
+    LCD.read_byte();
+    LCD.read_pixel(2, 3);
+    LCD.write_byte(0x55);
+    LCD.write_word(0x1234);
+    LCD.flush_media();
+    LCD.wait_idle();
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < screen.wire.size(); i++) {
+        hash = (hash ^ screen.wire[i]) * 16777619u;
+    }
+    printf("  %lu bytes sent, hash %08lx, %lu protocol errors\n", (unsigned long)screen.wire.size(),
+           (unsigned long)hash, (unsigned long)LCD.errors());
+    if (argc > 1) {
+        FILE *fp = fopen(argv[1], "wb");
+        fwrite(&screen.wire[0], 1, screen.wire.size(), fp);
+        fclose(fp);
+    }
+    return 0;
+}
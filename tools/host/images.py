@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Write the 128x128 test images of the rle and assets benchmarks as PPM.
+
+    tools/host/images.py OUTDIR
+
+board   a dark background with framed answer slots, like the game board
+strike  the red strike X on black
+banner  team banners: bands of colour with a lighter border and stripes
+noise   random pixels, which RLE cannot compress
+
+The images are the same on every run.
+"""
+
+import os
+import random
+import sys
+
+W = H = 128
+
+
+def board(x, y):
+    if 4 <= y < 20:                         # title bar
+        return (200, 160, 0) if 8 <= x < 120 else (20, 20, 80)
+    row, inside = (y - 24) // 13, (y - 24) % 13
+    if y >= 24 and row < 8 and 6 <= x < 122:
+        if inside in (0, 11) or x in (6, 121):
+            return (250, 250, 250)          # slot frame
+        if inside < 11:
+            return (0, 60, 160)
+    return (20, 20, 80)
+
+
+def strike(x, y):
+    for d in (x - y, x - (W - 1 - y)):
+        if -8 <= d <= 8 and 16 <= y < 112:
+            return (230, 0, 0) if -6 <= d <= 6 else (120, 0, 0)
+    return (0, 0, 0)
+
+
+def banner(x, y):
+    team = (0, 80, 200) if y < 64 else (200, 40, 0)
+    if x < 3 or x >= W - 3 or y % 64 < 3 or y % 64 >= 61:
+        return tuple(min(c + 80, 255) for c in team)
+    if (y % 64) // 8 == 4 and (x // 4) % 2:
+        return (255, 255, 255)
+    return team
+
+
+def main():
+    out = sys.argv[1]
+    os.makedirs(out, exist_ok=True)
+    rng = random.Random(47)
+    noise = [tuple(rng.randrange(256) for _ in range(3)) for _ in range(W * H)]
+    images = {
+        'board': lambda x, y: board(x, y),
+        'strike': lambda x, y: strike(x, y),
+        'banner': lambda x, y: banner(x, y),
+        'noise': lambda x, y: noise[y * W + x],
+    }
+    for name, pixel in images.items():
+        with open(os.path.join(out, name + '.ppm'), 'wb') as f:
+            f.write(b'P6\n%d %d\n255\n' % (W, H))
+            f.write(bytes(c for y in range(H) for x in range(W) for c in pixel(x, y)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,2 @@
+// everything is declared in the host mbed.h
+#include "mbed.h"
@@ -0,0 +1,66 @@
+#include "mbed.h"
+
+uint64_t host_ns = 0;
+uint64_t host_spin_ns = 0;
+uint64_t host_sleep_ns = 0;
+void (*host_poll_hook)() = 0;
+
+namespace mbed {
+
+int (*host_spi_hook)(int) = 0;
+HostUart *host_uart = 0;
+SerialBase *host_uart_owner = 0;
+
+SerialBase::SerialBase() {
+    host_uart_owner = this;
+}
+
+#define HOST_TIMEOUTS 16
+static Timeout *timeouts[HOST_TIMEOUTS];
+
+Timeout::~Timeout() {
+    for (int i = 0; i < HOST_TIMEOUTS; i++) {
+        if (timeouts[i] == this) {
+            timeouts[i] = 0;
+        }
+    }
+}
+
+void Timeout::arm(uint32_t us) {
+    _due = host_ns + (uint64_t)us * 1000;
+    _active = true;
+    for (int i = 0; i < HOST_TIMEOUTS; i++) {
+        if (timeouts[i] == this) {
+            return;
+        }
+    }
+    for (int i = 0; i < HOST_TIMEOUTS; i++) {
+        if (timeouts[i] == 0) {
+            timeouts[i] = this;
+            return;
+        }
+    }
+    error("host: more than %d Timeouts\n", HOST_TIMEOUTS);
+}
+
+uint64_t Timeout::next_due() {
+    uint64_t due = UINT64_MAX;
+    for (int i = 0; i < HOST_TIMEOUTS; i++) {
+        if (timeouts[i] && timeouts[i]->_active && timeouts[i]->_due < due) {
+            due = timeouts[i]->_due;
+        }
+    }
+    return due;
+}
+
+void Timeout::fire_due(uint64_t t) {
+    for (int i = 0; i < HOST_TIMEOUTS; i++) {
+        if (timeouts[i] && timeouts[i]->_active && timeouts[i]->_due == t) {
+            timeouts[i]->_active = false;
+            timeouts[i]->_callback();
+            return;
+        }
+    }
+}
+
+} // namespace mbed
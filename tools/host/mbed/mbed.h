@@ -0,0 +1,296 @@
+/* Host stand-in for the parts of the mbed library this tree uses.
+ *
+ * Time is simulated: host_ns only moves when the code waits, clocks an SPI
+ * byte or polls a model, so the benchmarks measure the time the board would
+ * spend on the bus and in waits, not the speed of the host. The SD card and
+ * uLCD models plug in through the hooks at the bottom.
+ */
+#ifndef HOST_MBED_H
+#define HOST_MBED_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+
+// simulated time, and the part of it spent spinning in wait_us()/sleeping
+extern uint64_t host_ns;
+extern uint64_t host_spin_ns;
+extern uint64_t host_sleep_ns;
+
+// called whenever simulated time moves or the code polls, models catch up here
+extern void (*host_poll_hook)();
+
+inline uint32_t host_us() { return (uint32_t)(host_ns / 1000); }
+
+inline void host_advance(uint64_t ns) {
+    host_ns += ns;
+    if (host_poll_hook) {
+        host_poll_hook();
+    }
+}
+
+inline void wait_us(int us) { host_spin_ns += (uint64_t)us * 1000; host_advance((uint64_t)us * 1000); }
+inline void wait_ms(int ms) { wait_us(ms * 1000); }
+inline void wait(float s) { wait_us((int)(s * 1e6f)); }
+
+inline void error(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    abort();
+}
+
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+
+typedef int PinName;
+enum {
+    p5 = 5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19, p20,
+    p21, p22, p23, p24, p25, p26, p27, p28, p29, p30,
+    USBTX = 100, USBRX, LED1, LED2, LED3, LED4, NC = -1
+};
+enum PinMode { PullUp = 0, PullDown, PullNone };
+
+namespace mbed {
+
+// The SD card model answers every byte clocked out on any SPI bus
+extern int (*host_spi_hook)(int out);
+
+// A callback to a function or a member function, for attach()
+class HostCallback {
+public:
+    HostCallback() : _fn(0), _bound(0) {}
+    ~HostCallback() { delete _bound; }
+    void attach(void (*fn)()) { delete _bound; _bound = 0; _fn = fn; }
+    template<typename T>
+    void attach(T *obj, void (T::*method)()) { delete _bound; _bound = new Bound<T>(obj, method); _fn = 0; }
+    bool attached() const { return _fn || _bound; }
+    void operator()() {
+        if (_bound) {
+            _bound->call();
+        } else if (_fn) {
+            _fn();
+        }
+    }
+private:
+    struct Any {
+        virtual ~Any() {}
+        virtual void call() = 0;
+    };
+    template<typename T>
+    struct Bound : Any {
+        Bound(T *obj, void (T::*method)()) : obj(obj), method(method) {}
+        void call() { (obj->*method)(); }
+        T *obj;
+        void (T::*method)();
+    };
+    HostCallback(const HostCallback &);
+    HostCallback &operator=(const HostCallback &);
+    void (*_fn)();
+    Any *_bound;
+};
+
+class SPI {
+public:
+    SPI(PinName, PinName, PinName) : _hz(1000000) {}
+    void frequency(int hz) { _hz = hz; }
+    void format(int, int = 0) {}
+    int write(int value) {
+        host_advance(8000000000ULL / _hz);
+        return host_spi_hook ? host_spi_hook(value) : 0xFF;
+    }
+private:
+    int _hz;
+};
+
+class DigitalOut {
+public:
+    DigitalOut(PinName, int value = 0) : _value(value) {}
+    void write(int value) { _value = value; }
+    int read() { return _value; }
+    DigitalOut &operator=(int value) { _value = value; return *this; }
+    operator int() { return _value; }
+private:
+    int _value;
+};
+
+class DigitalIn {
+public:
+    DigitalIn(PinName) {}
+    void mode(PinMode) {}
+    int read() { return 0; }
+    operator int() { return 0; }
+};
+
+class AnalogOut {
+public:
+    AnalogOut(PinName) {}
+    void write(float) {}
+    void write_u16(unsigned short) {}
+    AnalogOut &operator=(float) { return *this; }
+};
+
+class Timer {
+public:
+    Timer() : _start(0), _total(0), _running(false) {}
+    void start() { _start = host_ns; _running = true; }
+    void stop() { _total += host_ns - _start; _running = false; }
+    void reset() { _total = 0; _start = host_ns; }
+    int read_us() {
+        if (host_poll_hook) {
+            host_poll_hook();
+        }
+        return (int)((_total + (_running ? host_ns - _start : 0)) / 1000);
+    }
+    int read_ms() { return read_us() / 1000; }
+    float read() { return read_us() / 1e6f; }
+private:
+    uint64_t _start, _total;
+    bool _running;
+};
+
+// Timeouts are fired by whichever model drives simulated time
+class Timeout {
+public:
+    Timeout() : _due(0), _active(false) {}
+    ~Timeout();
+    void attach_us(void (*fn)(), uint32_t us) { _callback.attach(fn); arm(us); }
+    template<typename T>
+    void attach_us(T *obj, void (T::*method)(), uint32_t us) { _callback.attach(obj, method); arm(us); }
+    void detach() { _active = false; }
+
+    // the earliest pending timeout, and firing it
+    static uint64_t next_due();
+    static void fire_due(uint64_t t);
+private:
+    void arm(uint32_t us);
+    HostCallback _callback;
+    uint64_t _due;
+    bool _active;
+};
+
+// What sits on the other end of the UART, the uLCD model
+class HostUart {
+public:
+    virtual ~HostUart() {}
+    virtual void putc(int c) = 0;
+    virtual int getc() = 0;
+    virtual int readable() = 0;
+    virtual int writeable() = 0;
+    virtual void baud(int rate) = 0;
+};
+extern HostUart *host_uart;
+
+class SerialBase {
+public:
+    enum IrqType { RxIrq = 0, TxIrq };
+    enum Parity { None = 0, Odd, Even };
+
+    SerialBase();
+    void baud(int rate) { if (host_uart) host_uart->baud(rate); }
+    void format(int = 8, Parity = None, int = 1) {}
+    void attach(void (*fn)(), IrqType type = RxIrq) { _irq[type].attach(fn); }
+    template<typename T>
+    void attach(T *obj, void (T::*method)(), IrqType type = RxIrq) { _irq[type].attach(obj, method); }
+    int readable() { return host_uart ? host_uart->readable() : 0; }
+    int writeable() { return host_uart ? host_uart->writeable() : 1; }
+    int putc(int c) { if (host_uart) host_uart->putc(c); return c; }
+    int getc() { return host_uart ? host_uart->getc() : -1; }
+    int printf(const char *, ...) { return 0; }
+
+    // the model raises the interrupts through these
+    void rx_irq() { if (_irq[RxIrq].attached()) _irq[RxIrq](); }
+    void tx_irq() { if (_irq[TxIrq].attached()) _irq[TxIrq](); }
+private:
+    HostCallback _irq[2];
+};
+
+// The last UART constructed is the one wired to host_uart
+extern SerialBase *host_uart_owner;
+
+class Serial : public SerialBase {
+public:
+    Serial(PinName, PinName, const char * = 0) {}
+};
+
+class RawSerial : public SerialBase {
+public:
+    RawSerial(PinName, PinName) {}
+};
+
+class Stream {
+public:
+    Stream(const char * = 0) {}
+    virtual ~Stream() {}
+    int putc(int c) { return _putc(c); }
+    int getc() { return _getc(); }
+    int puts(const char *s) { while (*s) _putc(*s++); return 0; }
+    int printf(const char *format, ...) {
+        char buf[512];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        for (int i = 0; i < n && i < (int)sizeof(buf) - 1; i++) {
+            _putc(buf[i]);
+        }
+        return n;
+    }
+protected:
+    virtual int _putc(int c) = 0;
+    virtual int _getc() = 0;
+};
+
+class FileHandle {
+public:
+    virtual ~FileHandle() {}
+    virtual ssize_t write(const void *buffer, size_t length) = 0;
+    virtual int close() = 0;
+    virtual ssize_t read(void *buffer, size_t length) = 0;
+    virtual int isatty() = 0;
+    virtual off_t lseek(off_t offset, int whence) = 0;
+    virtual int fsync() = 0;
+    virtual off_t flen() = 0;
+};
+
+class DirHandle {
+public:
+    virtual ~DirHandle() {}
+    virtual int closedir() = 0;
+    virtual struct dirent *readdir() = 0;
+    virtual void rewinddir() = 0;
+    virtual off_t telldir() = 0;
+    virtual void seekdir(off_t location) = 0;
+};
+
+class FileBase {
+public:
+    FileBase(const char *name) : _name(name) {}
+    virtual ~FileBase() {}
+    const char *getName() { return _name; }
+protected:
+    const char *_name;
+};
+
+class FileSystemLike : public FileBase {
+public:
+    FileSystemLike(const char *name) : FileBase(name) {}
+    virtual FileHandle *open(const char *filename, int flags) = 0;
+    virtual int remove(const char *) { return -1; }
+    virtual int rename(const char *, const char *) { return -1; }
+    virtual DirHandle *opendir(const char *) { return 0; }
+    virtual int mkdir(const char *, mode_t) { return -1; }
+};
+
+} // namespace mbed
+
+using namespace mbed;
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef HOST_MBED_DEBUG_H
+#define HOST_MBED_DEBUG_H
+
+#include <stdio.h>
+
+#define debug(...)          fprintf(stderr, __VA_ARGS__)
+#define debug_if(c, ...)    do { if (c) fprintf(stderr, __VA_ARGS__); } while (0)
+
+#endif
@@ -0,0 +1,167 @@
+/* Host stand-in for the parts of mbed-rtos this tree uses.
+ *
+ * Mutex and Thread are real pthreads, so the reentrancy stress test runs
+ * concurrently. Thread::wait() moves simulated time like wait_us() does,
+ * but counts it as sleeping: on the board another thread would run.
+ */
+#ifndef HOST_RTOS_H
+#define HOST_RTOS_H
+
+#include "mbed.h"
+#include <pthread.h>
+
+typedef int32_t osStatus;
+enum { osOK = 0, osEventTimeout = 0x40, osErrorValue = 0x86, osErrorTimeoutResource = 0xC1 };
+enum osPriority { osPriorityLow = -2, osPriorityBelowNormal, osPriorityNormal, osPriorityAboveNormal, osPriorityHigh };
+#define osWaitForever 0xFFFFFFFF
+#define DEFAULT_STACK_SIZE 2048
+
+namespace rtos {
+
+class Mutex {
+public:
+    Mutex() {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&_m, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    ~Mutex() { pthread_mutex_destroy(&_m); }
+    osStatus lock(uint32_t millisec = osWaitForever) {
+        if (millisec == osWaitForever) {
+            return pthread_mutex_lock(&_m) ? osErrorValue : osOK;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += millisec / 1000;
+        ts.tv_nsec += (millisec % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        return pthread_mutex_timedlock(&_m, &ts) ? osErrorTimeoutResource : osOK;
+    }
+    bool trylock() { return pthread_mutex_trylock(&_m) == 0; }
+    osStatus unlock() { return pthread_mutex_unlock(&_m) ? osErrorValue : osOK; }
+private:
+    pthread_mutex_t _m;
+};
+
+class Semaphore {
+public:
+    Semaphore(int32_t count = 0) : _count(count) {
+        pthread_mutex_init(&_m, 0);
+        pthread_cond_init(&_c, 0);
+    }
+    int32_t wait(uint32_t = osWaitForever) {
+        pthread_mutex_lock(&_m);
+        while (_count == 0) {
+            pthread_cond_wait(&_c, &_m);
+        }
+        int32_t n = _count--;
+        pthread_mutex_unlock(&_m);
+        return n;
+    }
+    osStatus release() {
+        pthread_mutex_lock(&_m);
+        _count++;
+        pthread_cond_signal(&_c);
+        pthread_mutex_unlock(&_m);
+        return osOK;
+    }
+private:
+    int32_t _count;
+    pthread_mutex_t _m;
+    pthread_cond_t _c;
+};
+
+template<typename T, uint32_t queue_sz>
+class MemoryPool {
+public:
+    MemoryPool() {
+        pthread_mutex_init(&_m, 0);
+        memset(_used, 0, sizeof(_used));
+    }
+    T *alloc() {
+        pthread_mutex_lock(&_m);
+        T *p = 0;
+        for (uint32_t i = 0; i < queue_sz && !p; i++) {
+            if (!_used[i]) {
+                _used[i] = true;
+                p = (T*)&_blocks[i];
+            }
+        }
+        pthread_mutex_unlock(&_m);
+        return p;
+    }
+    T *calloc() {
+        T *p = alloc();
+        if (p) {
+            memset(p, 0, sizeof(T));
+        }
+        return p;
+    }
+    osStatus free(T *p) {
+        uint32_t i = (Block*)p - _blocks;
+        if ((Block*)p < _blocks || i >= queue_sz) {
+            return osErrorValue;
+        }
+        pthread_mutex_lock(&_m);
+        _used[i] = false;
+        pthread_mutex_unlock(&_m);
+        return osOK;
+    }
+private:
+    union Block {
+        char bytes[sizeof(T)];
+        double align_d;
+        void *align_p;
+        uint64_t align_l;
+    };
+    Block _blocks[queue_sz];
+    bool _used[queue_sz];
+    pthread_mutex_t _m;
+};
+
+class Thread {
+public:
+    Thread(void (*task)(void const *argument), void *argument = NULL,
+           osPriority = osPriorityNormal, uint32_t = DEFAULT_STACK_SIZE, unsigned char * = NULL)
+        : _task(task), _argument(argument), _running(true) {
+        pthread_create(&_thread, 0, &Thread::run, this);
+    }
+    ~Thread() { join(); }
+    osStatus join() {
+        if (_running) {
+            pthread_join(_thread, 0);
+            _running = false;
+        }
+        return osOK;
+    }
+    osStatus terminate() { return join(); }
+    uint32_t max_stack() { return 0; }
+
+    static osStatus wait(uint32_t millisec) {
+        host_sleep_ns += (uint64_t)millisec * 1000000;
+        host_advance((uint64_t)millisec * 1000000);
+        return osEventTimeout;
+    }
+    static osStatus yield() { return osOK; }
+private:
+    static void *run(void *self) {
+        Thread *t = (Thread*)self;
+        t->_task(t->_argument);
+        return 0;
+    }
+    void (*_task)(void const *);
+    void *_argument;
+    pthread_t _thread;
+    bool _running;
+};
+
+} // namespace rtos
+
+using namespace rtos;
+
+#endif
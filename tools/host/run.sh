@@ -0,0 +1,160 @@
+#!/bin/sh
+# Build and run the host benchmarks against the sources of this tree.
+#
+#   tools/host/run.sh                 all of them
+#   tools/host/run.sh freemap crc     just these
+#   ROOT=/tmp/old tools/host/run.sh   against another checkout, for "before" numbers
+#   BASE=/tmp/old tools/host/run.sh unicode   compare the code page tables with another checkout
+#
+# Binaries go to $OUT (/tmp/host-bench). Needs g++ and python3.
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=${ROOT:-$(cd "$HERE/../.." && pwd)}
+OUT=${OUT:-/tmp/host-bench}
+CXX=${CXX:-g++}
+mkdir -p "$OUT"
+
+FLAGS="-std=gnu++98 -O2 -g -w -pthread -I$HERE/mbed -I$HERE
+    -I$ROOT/FATFileSystem -I$ROOT/FATFileSystem/ChaN -I$ROOT/SDFileSystem
+    -I$ROOT/4DGL-uLCD-SE -I$ROOT/EventLog -I$ROOT/LCDAssets"
+
+MBED="$HERE/mbed/mbed.cpp"
+FATFS="$ROOT/FATFileSystem/*.cpp $ROOT/FATFileSystem/ChaN/*.cpp"
+SD="$ROOT/SDFileSystem/*.cpp $HERE/SDCardSim.cpp"
+LCD="$ROOT/4DGL-uLCD-SE/*.cpp $HERE/LCDSim.cpp"
+
+build() {
+    name=$1
+    shift
+    echo "== $name" >&2
+    $CXX $FLAGS -o "$OUT/$name" "$@"
+}
+
+# the test images of images.py, as raw RGB565 and RLE565
+images() {
+    python3 "$HERE/images.py" "$OUT/images"
+    for i in board strike banner noise; do
+        python3 "$ROOT/tools/rgb565.py" "$OUT/images/$i.ppm" "$OUT/images/$i.565" >/dev/null
+        python3 "$ROOT/tools/rgb565.py" --rle "$OUT/images/$i.ppm" "$OUT/images/$i.rle"
+    done
+}
+
+bench() {
+    case $1 in
+    freemap)
+        build freemap0 -D_FS_FREEMAP=0 $HERE/bench_freemap.cpp $MBED $FATFS $SD
+        build freemap512 -D_FS_FREEMAP=512 $HERE/bench_freemap.cpp $MBED $FATFS $SD
+        "$OUT/freemap0"
+        "$OUT/freemap512"
+        ;;
+    dircache)
+        build dircache0 -D_FS_DCACHE=0 $HERE/bench_dircache.cpp $MBED $FATFS $SD
+        build dircache8 $HERE/bench_dircache.cpp $MBED $FATFS $SD
+        "$OUT/dircache0"
+        "$OUT/dircache8"
+        ;;
+    reentrant)
+        build reentrant $HERE/stress_reentrant.cpp $MBED $FATFS $SD
+        "$OUT/reentrant"
+        ;;
+    volumes)
+        build volumes $HERE/test_volumes.cpp $MBED $FATFS $SD
+        "$OUT/volumes"
+        ;;
+    format)
+        build format $HERE/bench_format.cpp $MBED $FATFS $SD
+        "$OUT/format"
+        ;;
+    crc)
+        build crc $HERE/bench_crc.cpp $MBED $FATFS $SD
+        "$OUT/crc"
+        ;;
+    init)
+        build init $HERE/bench_init.cpp $MBED $FATFS $SD
+        "$OUT/init"
+        ;;
+    trim)
+        build trim $HERE/bench_trim.cpp $MBED $FATFS $SD
+        "$OUT/trim"
+        ;;
+    paged)
+        build paged $HERE/bench_paged.cpp $MBED $FATFS $SD
+        "$OUT/paged"
+        ;;
+    readview)
+        build readview $HERE/bench_readview.cpp $MBED $FATFS $SD
+        "$OUT/readview"
+        ;;
+    lcd)
+        build lcd $HERE/bench_lcd.cpp $MBED $LCD
+        "$OUT/lcd"
+        ;;
+    grid)
+        build grid $HERE/bench_grid.cpp $MBED $LCD
+        "$OUT/grid"
+        ;;
+    baud)
+        build baud $HERE/bench_baud.cpp $MBED $LCD
+        "$OUT/baud"
+        ;;
+    pace)
+        build pace $HERE/bench_pace.cpp $MBED $LCD
+        "$OUT/pace"
+        ;;
+    hold)
+        build hold $HERE/bench_hold.cpp $MBED $LCD
+        "$OUT/hold"
+        ;;
+    blit565)
+        build blit565 $HERE/bench_blit565.cpp $MBED $LCD
+        "$OUT/blit565"
+        ;;
+    rle)
+        build rle $HERE/bench_rle.cpp $MBED $LCD
+        images
+        "$OUT/rle" "$OUT/images"
+        ;;
+    assets)
+        build assets $HERE/bench_assets.cpp $MBED $LCD $ROOT/LCDAssets/*.cpp $ROOT/SDFileSystem/SDCRC.cpp
+        images
+        "$OUT/assets" "$OUT/images"
+        ;;
+    wire)
+        build wire $HERE/bench_wire.cpp $MBED $LCD
+        "$OUT/wire" "$OUT/wire.bin"
+        ;;
+    text)
+        build text $HERE/bench_text.cpp $MBED $LCD
+        "$OUT/text"
+        # the stack frame of text_string
+        $CXX $FLAGS -Os -fstack-usage -c -o "$OUT/text.o" $ROOT/4DGL-uLCD-SE/uLCD_4DGL_Text.cpp
+        grep text_string "$OUT/text.su"
+        ;;
+    unicode)
+        for cp in 437 720 737 771 775 850 852 855 857 860 861 862 863 864 865 866 869; do
+            base=
+            if [ -n "$BASE" ]; then
+                # copied out so its ff.h is not picked up before this tree's
+                cp "$BASE/FATFileSystem/ChaN/ccsbcs.cpp" "$OUT/base_ccsbcs.cpp"
+                $CXX $FLAGS -D_CODE_PAGE=$cp -Dff_convert=base_ff_convert -Dff_wtoupper=base_ff_wtoupper \
+                    -c -o "$OUT/base_ccsbcs.o" "$OUT/base_ccsbcs.cpp"
+                base="-DBASE $OUT/base_ccsbcs.o"
+            fi
+            build unicode$cp -D_CODE_PAGE=$cp $HERE/bench_unicode.cpp $ROOT/FATFileSystem/ChaN/ccsbcs.cpp $base
+            "$OUT/unicode$cp"
+        done
+        ;;
+    *)
+        echo "unknown benchmark $1" >&2
+        exit 1
+        ;;
+    esac
+}
+
+if [ $# -eq 0 ]; then
+    set -- freemap dircache reentrant volumes format crc init trim paged readview lcd grid baud pace hold blit565 rle assets wire text unicode
+fi
+for b in "$@"; do
+    bench $b
+done
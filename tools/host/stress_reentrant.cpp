@@ -0,0 +1,83 @@
+// Several threads writing and reading back their own files on one volume
+// at once. The Mutex and Thread stand-ins are pthreads, so the FatFs calls
+// really do run concurrently and only the volume lock keeps them apart.
+//
+// Each thread writes a file of 30 chunks whose bytes depend on the thread
+// and the chunk, reads it back and checks every byte, 20 times over. The
+// program exits with 1 on the first mismatch or failed call.
+#include "SDFileSystem.h"
+#include "SDCardSim.h"
+#include "rtos.h"
+
+#define THREADS FFS_MAX_OPEN_FILES      // a file handle each
+#define ROUNDS  20
+#define CHUNKS  30
+#define CHUNK   700                     // not a multiple of the sector size
+
+static SDCardSim card(64 * 1024);       // 32MB
+static SDFileSystem sd(p5, p6, p7, p8, "sd");
+static volatile int failures;
+
+static void worker(void const *arg) {
+    int id = (int)(intptr_t)arg;
+    char name[64], buf[CHUNK];
+    sprintf(name, "thread-%d-with-a-long-file-name.bin", id);
+    for (int r = 0; r < ROUNDS && !failures; r++) {
+        FileHandle *f = sd.open(name, O_WRONLY | O_CREAT | O_TRUNC);
+        if (f == NULL) {
+            printf("thread %d: create failed\n", id);
+            failures++;
+            return;
+        }
+        for (int k = 0; k < CHUNKS; k++) {
+            memset(buf, id * 37 + r + k, sizeof(buf));
+            f->write(buf, sizeof(buf));
+        }
+        f->close();
+
+        f = sd.open(name, O_RDONLY);
+        if (f == NULL) {
+            printf("thread %d: open failed\n", id);
+            failures++;
+            return;
+        }
+        for (int k = 0; k < CHUNKS; k++) {
+            if (f->read(buf, sizeof(buf)) != sizeof(buf)) {
+                printf("thread %d: short read\n", id);
+                failures++;
+                break;
+            }
+            for (int i = 0; i < CHUNK; i++) {
+                if (buf[i] != (char)(id * 37 + r + k)) {
+                    printf("thread %d: round %d chunk %d byte %d corrupt\n", id, r, k, i);
+                    failures++;
+                    k = CHUNKS;
+                    break;
+                }
+            }
+        }
+        f->close();
+    }
+}
+
+int main() {
+    card.ready_us = 1000;
+    card.attach();
+    if (sd.format() || sd.mount()) {
+        puts("format failed");
+        return 1;
+    }
+    Thread *threads[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        threads[i] = new Thread(worker, (void*)(intptr_t)i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        delete threads[i];
+    }
+    DWORD free_clusters;
+    FATFS *fs;
+    FRESULT res = f_getfree("0:", &free_clusters, &fs);
+    printf("%d threads x %d rounds x %d bytes: %s, f_getfree %d\n", THREADS, ROUNDS, CHUNKS * CHUNK,
+           failures ? "FAILED" : "all data read back intact", res);
+    return failures || res ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+// An SD card and a RAM volume mounted at once: every FATFileSystem call on
+// one must leave the other alone. Both volumes get a file "same.txt" with
+// their own contents, then each operation runs on one volume and the
+// files of both are checked. The program exits with 1 on the first
+// failure.
+#include "SDFileSystem.h"
+#include "MemFileSystem.h"
+#include "SDCardSim.h"
+
+static SDCardSim card(64 * 1024);
+static SDFileSystem sd(p5, p6, p7, p8, "sd");
+static MemFileSystem ram("ram", 256);
+static int failures;
+
+static void check(bool ok, const char *what) {
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAILED");
+    failures += !ok;
+}
+
+static void put(FATFileSystem &fs, const char *name, const char *text) {
+    FileHandle *f = fs.open(name, O_WRONLY | O_CREAT | O_TRUNC);
+    if (f == NULL) {
+        printf("  cannot create %s on %s\n", name, fs.getName());
+        failures++;
+        return;
+    }
+    f->write(text, strlen(text));
+    f->close();
+}
+
+// the contents of a file, "" if it cannot be opened
+static const char *get(FATFileSystem &fs, const char *name) {
+    static char buf[32];
+    buf[0] = 0;
+    FileHandle *f = fs.open(name, O_RDONLY);
+    if (f) {
+        ssize_t n = f->read(buf, sizeof(buf) - 1);
+        buf[n > 0 ? n : 0] = 0;
+        f->close();
+    }
+    return buf;
+}
+
+static bool listed(FATFileSystem &fs, const char *dir, const char *name) {
+    DirHandle *d = fs.opendir(dir);
+    bool found = false;
+    if (d) {
+        struct dirent *e;
+        while ((e = d->readdir()) != NULL) {
+            found |= strcasecmp(e->d_name, name) == 0;
+        }
+        d->closedir();
+    }
+    return found;
+}
+
+int main() {
+    card.ready_us = 1000;
+    card.attach();
+    if (sd.format() || sd.mount() || ram.format() || ram.mount()) {
+        puts("format failed");
+        return 1;
+    }
+    put(sd, "same.txt", "on the card");
+    put(ram, "same.txt", "in RAM");
+    check(!strcmp(get(sd, "same.txt"), "on the card") && !strcmp(get(ram, "same.txt"), "in RAM"),
+          "open() on each volume");
+
+    check(ram.mkdir("hot", 0777) == 0 && ram.opendir("hot") != NULL && sd.opendir("hot") == NULL,
+          "mkdir() on RAM, opendir() on both");
+    put(ram, "hot/a.bin", "a");
+    check(listed(ram, "hot", "a.bin") && listed(ram, "", "same.txt") && !listed(sd, "", "hot"),
+          "opendir() lists only its own volume");
+
+    put(sd, "old.txt", "card file");
+    put(ram, "old.txt", "RAM file");
+    check(ram.rename("old.txt", "new.txt") == 0 && !strcmp(get(ram, "new.txt"), "RAM file") &&
+          !strcmp(get(sd, "old.txt"), "card file") && !*get(sd, "new.txt"), "rename() on RAM");
+    check(sd.rename("old.txt", "new.txt") == 0 && !strcmp(get(sd, "new.txt"), "card file") &&
+          !strcmp(get(ram, "new.txt"), "RAM file"), "rename() on the card");
+
+    check(ram.remove("same.txt") == 0 && !*get(ram, "same.txt") && !strcmp(get(sd, "same.txt"), "on the card"),
+          "remove() on RAM");
+    check(sd.remove("same.txt") == 0 && !*get(sd, "same.txt") && ram.remove("same.txt") != 0,
+          "remove() on the card");
+    check(card.stats.writes > 0, "the card was written");
+    return failures != 0;
+}
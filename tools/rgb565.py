@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""Convert an image to RGB565 pixels for uLCD_4DGL::BLIT565.
+
+The raw output is the pixels row by row, two bytes each with the high byte
+first, which is the order they go to the screen in. Copy it to the SD card
+and draw it with
+
+    FILE *fp = fopen("/sd/logo.565", "rb");
+    LCD.BLIT565(0, 0, 64, 64, fp);
+
+or use --c to get a const uint16_t array that stays in flash.
+
+--rle writes the RLE565 format of uLCD_4DGL::BLITRLE instead and reports
+the bytes the screen gets compared with a plain BLIT:
+
+    tools/rgb565.py --rle board.bmp board.rle
+
+24/32-bit BMP and binary PPM files are read as they are, anything else
+needs Pillow.
+
+    tools/rgb565.py logo.png logo.565
+    tools/rgb565.py --size 64x64 --c logo logo.png logo.h
+"""
+
+import argparse
+import struct
+import sys
+
+RLE_MIN_RUN = 8     # LCD_RLE_MIN_RUN in uLCD_4DGL.h
+RLE_RECTS = 8       # LCD_RLE_RECTS
+
+
+def read_ppm(data):
+    fields = []
+    pos = 0
+    while len(fields) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b'#':
+            pos = data.index(b'\n', pos)
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    if fields[0] != b'P6' or int(fields[3]) != 255:
+        raise ValueError('only 8-bit binary (P6) PPM is supported')
+    w, h = int(fields[1]), int(fields[2])
+    pix = data[pos + 1:pos + 1 + 3 * w * h]
+    return w, h, [tuple(pix[i:i + 3]) for i in range(0, 3 * w * h, 3)]
+
+
+def read_bmp(data):
+    offset, = struct.unpack_from('<I', data, 10)
+    w, h, planes, bpp, compression = struct.unpack_from('<iiHHI', data, 18)
+    if bpp not in (24, 32) or compression not in (0, 3):
+        raise ValueError('only uncompressed 24/32-bit BMP is supported')
+    step = bpp // 8
+    stride = (w * step + 3) & ~3
+    rows = range(abs(h) - 1, -1, -1) if h > 0 else range(abs(h))   # bottom-up unless h < 0
+    pixels = []
+    for r in rows:
+        base = offset + r * stride
+        for x in range(w):
+            b, g, red = data[base + x * step:base + x * step + 3]
+            pixels.append((red, g, b))
+    return w, abs(h), pixels
+
+
+def read_image(path, size):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if size is None and data[:2] == b'BM':
+        return read_bmp(data)
+    if size is None and data[:2] == b'P6':
+        return read_ppm(data)
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit('%s: needs Pillow (pip install pillow), or give a BMP/PPM without --size' % path)
+    img = Image.open(path).convert('RGB')
+    if size:
+        img = img.resize(size, Image.LANCZOS)
+    return img.size[0], img.size[1], list(img.getdata())
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def rle_encode(w, h, words):
+    """RLE565 file: "RLE5", width, height, then packets that stay within a row."""
+    out = bytearray(b'RLE5' + struct.pack('>HH', w, h))
+    for y in range(h):
+        row = words[y * w:(y + 1) * w]
+        i = 0
+        lit = []
+        while i <= w:
+            j = i + 1
+            while j < w and j - i < 128 and row[j] == row[i]:
+                j += 1
+            if i == w or j - i >= 3:        # shorter runs cost more as packets than inside a literal
+                while lit:
+                    out.append(len(lit[:128]) - 1)
+                    out += struct.pack('>%dH' % len(lit[:128]), *lit[:128])
+                    lit = lit[128:]
+                if i == w:
+                    break
+                out.append(0x80 + j - i - 1)
+                out += struct.pack('>H', row[i])
+                i = j
+            else:
+                lit.append(row[i])
+                i += 1
+    return bytes(out)
+
+
+def rle_wire_bytes(w, h, words):
+    """Bytes BLITRLE sends for the image, the same split as on the device."""
+    sent = 0
+    rects = []                              # [x1, x2, color, last row]
+    for y in range(h):
+        row = words[y * w:(y + 1) * w]
+        lit = i = 0
+        while i < w:
+            j = i + 1
+            while j < w and row[j] == row[i]:
+                j += 1
+            if j - i >= RLE_MIN_RUN:
+                if i > lit:
+                    sent += 10 + 2 * (i - lit)
+                lit = j
+                for r in rects:
+                    if r[:3] == [i, j - 1, row[i]] and r[3] == y - 1:
+                        r[3] = y
+                        break
+                else:
+                    if len(rects) == RLE_RECTS:
+                        sent += 12
+                        rects.pop(0)
+                    rects.append([i, j - 1, row[i], y])
+            i = j
+        if w > lit:
+            sent += 10 + 2 * (w - lit)
+        sent += 12 * sum(1 for r in rects if r[3] != y)
+        rects = [r for r in rects if r[3] == y]
+    return sent + 12 * len(rects)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('input')
+    ap.add_argument('output')
+    ap.add_argument('--size', help='resize to WxH first (needs Pillow)')
+    ap.add_argument('--c', metavar='NAME', help='write a C array called NAME instead of raw bytes')
+    ap.add_argument('--rle', action='store_true', help='write an RLE565 file for BLITRLE')
+    args = ap.parse_args()
+
+    size = tuple(int(v) for v in args.size.split('x')) if args.size else None
+    w, h, pixels = read_image(args.input, size)
+    words = [rgb565(*p) for p in pixels]
+
+    if args.rle:
+        data = rle_encode(w, h, words)
+        with open(args.output, 'wb') as f:
+            f.write(data)
+        raw, wire = 10 + 2 * w * h, rle_wire_bytes(w, h, words)
+        print('%s: %dx%d, %d bytes on the card (%d raw), %d bytes to the screen (%d with BLIT, %d%% saved)'
+              % (args.output, w, h, len(data), 2 * w * h, wire, raw, 100 - 100 * wire // raw))
+        if wire >= raw:
+            print('%s: no long runs of one colour, the raw file is better for BLIT565' % args.output)
+        return
+    if args.c:
+        with open(args.output, 'w') as f:
+            f.write('// %s, %dx%d RGB565, made by tools/rgb565.py\n' % (args.input, w, h))
+            f.write('#define %s_W %d\n#define %s_H %d\n' % (args.c.upper(), w, args.c.upper(), h))
+            f.write('const uint16_t %s[%d] = {\n' % (args.c, w * h))
+            for i in range(0, len(words), 12):
+                f.write('    ' + ', '.join('0x%04X' % v for v in words[i:i + 12]) + ',\n')
+            f.write('};\n')
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(struct.pack('>%dH' % len(words), *words))
+    print('%s: %dx%d, %d bytes of pixels' % (args.output, w, h, 2 * w * h))
+
+
+if __name__ == '__main__':
+    main()